@@ -0,0 +1,114 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_BUNDLE_H
+#define MSL_BUNDLE_H
+
+#include <string>
+#include <list>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <iostream>
+#include <fstream>
+using namespace std;
+
+/*! A problem directory packed into a single file named Bundle, so that
+loading a problem costs one read instead of an open() per parameter.
+The file is
+
+  char magic[8]; int version; int count;
+  count entries of: int namelen; char name[namelen];
+                    long long offset; long long size;
+  the entry contents, each at its offset from the start of the file
+
+where every entry holds the bytes of the file of that name.  When a
+directory has a Bundle it is authoritative: files in the directory are
+found (or not) only in the bundle, so rebuild it with mslbundle after
+editing a parameter.  Directories without one are read as before.  */
+
+#define MSL_BUNDLE_FILE "Bundle"
+#define MSL_BUNDLE_MAGIC "MSLBNDL"
+#define MSL_BUNDLE_VERSION 1
+
+//! The files of one problem directory, held in memory
+class MSLBundle {
+ private:
+  //! The whole bundle file
+  string Data;
+
+  //! Each entry's offset and size within Data
+  unordered_map<string,pair<size_t,size_t> > Index;
+
+ public:
+  //! Load a bundle with a single read; false if it is not valid
+  bool Read(const string &fname);
+
+  //! True if the bundle has an entry called name
+  bool Contains(const string &name) const;
+
+  //! Point data at the contents of an entry; false if there is none
+  bool Find(const string &name, const char *&data, size_t &size) const;
+
+  //! The entry names, sorted
+  list<string> Names() const;
+
+  //! Write a bundle with the given (name, contents) entries
+  static void Write(ostream &os, const vector<pair<string,string> > &entries);
+
+  //! The bundle of directory dir (ending in '/', or empty for the
+  //! current directory), or NULL if it has none.  The Bundle file is
+  //! stat'ed on each call and read again if it changed; bundles stay
+  //! loaded.  Thread-safe, and only loading takes a lock.
+  static const MSLBundle* ForDirectory(const string &dir);
+
+  //! The bundle responsible for the file fname, or NULL; name is set
+  //! to the entry name within it
+  static const MSLBundle* ForFile(const string &fname, string &name);
+};
+
+
+//! A read-only stream buffer over memory owned by someone else
+class MSLMemoryBuf : public streambuf {
+ public:
+  void Set(const char *data, size_t size) {
+    char *p = const_cast<char*>(data);
+    setg(p,p,p+size);
+  }
+};
+
+
+/*! An input stream for a file of a problem directory.  It reads from
+the directory's bundle when there is one, and from the file otherwise,
+so it can be used in place of ifstream for anything under FilePath.  */
+class MSLProblemFile : public istream {
+ private:
+  filebuf File;
+  MSLMemoryBuf Memory;
+  bool Opened;
+
+ public:
+  MSLProblemFile();
+  MSLProblemFile(const string &fname);
+
+  void open(const string &fname);
+  void close();
+  inline bool is_open() const {return Opened;};
+};
+
+#endif
@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_COMPACTTREE_H
+#define MSL_COMPACTTREE_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+#include "vector.h"
+#include "tree.h"
+
+/*! A search tree that stores its nodes in a few flat arrays instead of
+one heap MSLNode (with two heap MSLVectors) per node, for trees too
+large to fit in memory otherwise.  Nodes are numbered in the order they
+are added; the root is 0.
+
+Each state is quantized on a grid of 2^Bits steps per dimension
+between LowerState and UpperState, and stored as the difference from
+its parent's quantized state, in variable-length bytes (a small step
+takes one or two bytes per dimension).  Every KeyframeInterval levels
+a node stores its full quantized state instead, so decoding walks at
+most that many parents.  Since the differences are between quantized
+values, errors never accumulate down the tree.  Inputs are stored once
+each in a table (planners usually draw them from a small set), and
+times as floats.
+
+For nearest-neighbor search the tree also keeps every state at 16 bits
+per dimension, decoded by IndexState without walking the tree.  */
+class MSLCompactTree {
+ private:
+  MSLVector Lower,Step,IndexStep;
+  int Dim,Bits,KeyframeInterval;
+
+  vector<int> Parents;
+  vector<float> Times;
+  vector<int> Inputs;
+  vector<unsigned char> Hops;  // Levels to the nearest keyframe above
+  vector<size_t> Offsets;      // Where each node's bytes start
+  vector<unsigned char> Bytes;
+  vector<unsigned short> Index;
+
+  vector<MSLVector> InputTable;
+  unordered_map<string,int> InputIds;
+
+  //! The quantized state of node n
+  void Quantized(int n, vector<long long> &q) const;
+
+  //! The table entry for u, adding one if needed
+  int InputID(const MSLVector &u);
+
+ public:
+  //! The grid spans lower to upper with 2^bits steps per dimension
+  MSLCompactTree(const MSLVector &lower, const MSLVector &upper,
+		 int bits = 24, int keyframe = 32);
+
+  void Clear();
+
+  //! Start over with a root at state x; returns 0
+  int MakeRoot(const MSLVector &x);
+
+  //! Add a child of parent reached by u in time t; returns its number
+  int Extend(int parent, const MSLVector &x, const MSLVector &u, double t);
+
+  inline int Size() const {return Parents.size();};
+
+  //! The parent of node n (-1 for the root)
+  inline int Parent(int n) const {return Parents[n];};
+
+  inline double Time(int n) const {return Times[n];};
+
+  //! The state of node n, to the precision of the grid
+  MSLVector State(int n) const;
+
+  //! The input that leads to node n from its parent
+  inline const MSLVector& Input(int n) const {return InputTable[Inputs[n]];};
+
+  //! The 16-bit approximation of the state of node n, written into x
+  //! (which must have the state dimension)
+  void IndexState(int n, MSLVector &x) const;
+
+  //! The nodes from n up to the root
+  list<int> PathToRoot(int n) const;
+
+  //! Bytes held by the arrays (not counting the input lookup table)
+  size_t MemoryUsage() const;
+
+  //! Make an ordinary tree with the same nodes (in the same order)
+  MSLTree* MakeTree() const;
+};
+
+#endif
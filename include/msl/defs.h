@@ -40,28 +40,25 @@
 	#include <iostream>
         #include <cstdlib>
 	using namespace std;
-	static std::ifstream _msl_fin;
 #endif
 
+#include "bundle.h"
+
+// Parameters are read from FilePath, or from its Bundle (see bundle.h).
+// Each read has its own stream, so planners may be set up concurrently.
 #define READ_OPTIONAL_PARAMETER(F)\
-_msl_fin.clear();\
-_msl_fin.open((FilePath+""#F"").c_str());\
-if (_msl_fin) {_msl_fin >> F;}\
-_msl_fin.close();\
+{ MSLProblemFile _msl_fin(FilePath+""#F"");\
+  if (_msl_fin) {_msl_fin >> F;} }\
 
 #define READ_PARAMETER_OR_DEFAULT(F,D)\
-_msl_fin.clear();\
-_msl_fin.open((FilePath+""#F"").c_str());\
-if (_msl_fin) {_msl_fin >> F;}\
-else F = D;\
-_msl_fin.close();\
+{ MSLProblemFile _msl_fin(FilePath+""#F"");\
+  if (_msl_fin) {_msl_fin >> F;}\
+  else F = D; }\
 
 #define READ_PARAMETER_OR_ERROR(F)\
-_msl_fin.clear();\
-_msl_fin.open((FilePath+""#F"").c_str());\
-if (_msl_fin) {_msl_fin >> F; _msl_fin.close();}\
-else {cerr << "Error reading "#F"\n"; exit(-1);}\
-_msl_fin.close();\
+{ MSLProblemFile _msl_fin(FilePath+""#F"");\
+  if (_msl_fin) {_msl_fin >> F;}\
+  else {cerr << "Error reading "#F"\n"; exit(-1);} }\
   
 // Convenient list iterator
 #define forall(x,S)\
@@ -20,6 +20,9 @@
 #define MSL_FDP_H
 
 #include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 using namespace std;
 
 #include "marray.h"
@@ -53,9 +56,10 @@ if the quantization leads to a grid boundary every 2.0 units, then
 PlannerDeltaT could be set to cause the state to change by 3.0 units.
 
 GridDimensions sets the resolution of the grid and can be read from a file.
-For high-dimensional problems an error message may occur due to a grid
-that is too large.  To enable larger grids, set the MaxSize to a desirable
-size in the MultiArray class (in marray.C).  */
+For high-dimensional problems the grid may be too large (over MaxSize
+in the MultiArray class, in marray.h); Plan then returns at once, and
+PlanWithin reports MSL_PLAN_MEMORY.  The grid counts toward
+MemoryLimit.  */
 
 //! A dynamic programming approach to nonholonomic planning, as proposed by Barraquand, Latombe, 
 //! Algorithmica 10:6, pp. 121-155, 1993.
@@ -103,6 +107,9 @@ class FDP: public IncrementalPlanner {
   //! Attempt to solve an Initial-Goal query by growing an FDP tree
   virtual bool Plan();
 
+  //! The trees, the collision models and the grid
+  virtual void MemoryItems(list<MSLMemoryItem> &ml);
+
 };
 
 
@@ -129,6 +136,83 @@ class FDPBestFirst: public FDP {
 };
 
 
+/*! Since every step in the base FDP costs PlannerDeltaT, all of the 
+nodes in the queue whose costs agree (a bucket of width PlannerDeltaT)
+can be expanded at the same time, as in delta-stepping.  Each bucket
+is split among NumThreads threads.  Threads claim grid cells with an 
+atomic compare-and-swap: an UNVISITED cell is marked with the (negated)
+position in the bucket of the node that reaches it, and a node that
+comes earlier in the bucket may take the cell over.  The new nodes are
+then added to the tree, checked against the goal and marked VISITED 
+on the calling thread, in bucket order.  Every cell is still visited
+at most once, and the result is the same as expanding the bucket one
+node at a time, regardless of the number of threads.  The path that is
+found therefore has the same cost as in FDP.
+
+This assumes the base class SearchCost, and the Problem must allow 
+concurrent calls to Integrate and GetInputs.
+*/
+//! FDP in which each cost bucket is expanded by several threads
+class FDPParallel: public FDP {
+ protected:
+  //! A grid cell that was claimed while expanding a bucket
+  struct Claim {
+    int Mark;
+    vector<int> Indices;
+    MSLNode *Parent;
+    MSLVector State;
+    MSLVector Input;
+  };
+
+  //! Expand bucket[first] to bucket[last-1], recording claimed cells
+  void ExpandBucket(const vector<MSLNode*> &bucket, int first, int last,
+		    vector<Claim> &claims);
+
+  //! The bucket being expanded by the workers, the size of each chunk,
+  //! and the claims of each chunk (chunk k goes to worker k; the
+  //! planning thread takes chunk 0)
+  const vector<MSLNode*> *PoolBucket;
+  int PoolChunk;
+  vector<vector<Claim> > *PoolClaims;
+
+  //! Buckets handed out so far, and workers yet to finish the last one
+  long PoolRound;
+  int PoolPending;
+  bool PoolStopping;
+  std::mutex PoolLock;
+  std::condition_variable PoolWake,PoolDone;
+
+  //! The workers, started once by Plan and kept for all of its buckets
+  vector<thread> Workers;
+
+  //! Expand chunk k of each bucket until StopWorkers
+  void Worker(int k);
+
+  //! Start NumThreads-1 workers
+  void StartWorkers();
+
+  //! Expand bucket with the workers, in chunks of chunk nodes
+  void ExpandWithWorkers(const vector<MSLNode*> &bucket, int chunk,
+			 vector<vector<Claim> > &claims);
+
+  //! Stop and join the workers
+  void StopWorkers();
+
+ public:
+  //! Number of threads used to expand a bucket (default = number of cores)
+  int NumThreads;
+
+  //! A constructor that initializes data members.
+  FDPParallel(Problem *problem);
+
+  //! Empty destructor
+  ~FDPParallel() {};
+
+  //! Attempt to solve an Initial-Goal query, one bucket at a time
+  virtual bool Plan();
+};
+
+
 //! A bidirectional version of forward dynamic programming
 class FDPBi: public FDP {
  protected:
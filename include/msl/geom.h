@@ -66,6 +66,10 @@ class Geom {
   //! obstacle region.
   virtual double DistanceComp(const MSLVector &q) = 0;  // Distance in world
 
+  //! Bytes held by the collision models (0 for geometries that keep
+  //! none, or do not count them)
+  virtual size_t MemoryUsage() {return 0;}
+
   //! Maximum displacement of geometry with respect to change in each variable
   MSLVector MaxDeviates;
 
@@ -35,12 +35,48 @@
 // really seems to want a static matrix.
 #define MAXBODIES 100
 
+/*! CollisionFree may be called from several threads at once: the
+robot transformations are computed into local arrays rather than RR
+and TR.  DistanceComp is not reentrant, since PQP_Distance caches the
+last closest triangle inside the models.  */
+
+/*! Building a PQP_Model (parsing, triangulating, and constructing the
+bounding volume hierarchy) can take longer than planning for large
+meshes.  If the file CollisionCache exists, each built model is saved
+as <hash>.pqp in the directory it names (default: the problem
+directory), where <hash> is the FNV-1a hash of the source file, and
+later loads of the same source read the model from there instead.  The
+cache holds PQP's Tri and BV arrays as they are in memory, so it is
+only valid for the PQP build that wrote it; a mismatch is detected and
+the model is rebuilt.  */
+
+#define MSL_PQP_CACHE_MAGIC "MSLPQPC"
+#define MSL_PQP_CACHE_VERSION 1
+
 //! Parent class PQP-based list of Triangle models
 
 class GeomPQP: public Geom {
  protected:
   PQP_REAL RR[3][3],RO[3][3];
   PQP_REAL TR[3],TO[3];
+
+  //! Directory of the collision model cache, or empty if it is off
+  string CollisionCache;
+
+  /*! Load the triangles of file fname into tl and build m from them.
+    If polygons is not NULL the file holds polygons instead, which are
+    read into *polygons and triangulated with the given tolerance
+    (unless fname+"Triangles" has the triangulation already).  */
+  void MakeModel(const string &fname, list<MSLPolygon> *polygons,
+		 double tolerance, list<MSLTriangle> &tl, PQP_Model &m);
+
+  //! Read m and tl from the cache file for key; false on a miss
+  bool ReadCachedModel(unsigned long long key, size_t srcsize,
+		       list<MSLTriangle> &tl, PQP_Model &m);
+
+  //! Save the built model m in the cache under key
+  void WriteCachedModel(unsigned long long key, size_t srcsize,
+			const PQP_Model &m);
  public:
   list<MSLTriangle> Obst;
   list<MSLTriangle> Robot;
@@ -51,6 +87,7 @@ class GeomPQP: public Geom {
   virtual void LoadRobot(string path);
   virtual bool CollisionFree(const MSLVector &q){return true;}
   virtual double DistanceComp(const MSLVector &q){return 10000.0;}
+  virtual size_t MemoryUsage();
 };
 
 //! A parent class for 2D PQP geometries
@@ -77,6 +114,9 @@ class GeomPQP2DRigid: public GeomPQP2D {
   virtual MSLVector ConfigurationDifference(const MSLVector &q1,
 					      const MSLVector &q2);
   void SetTransformation(const MSLVector &q); // Input is configuration
+  //! Compute the transformation into rr and tr, leaving members alone
+  void SetTransformation(const MSLVector &q, PQP_REAL rr[3][3], 
+			 PQP_REAL tr[3]);
 };
 
 
@@ -95,7 +135,11 @@ class GeomPQP2DRigidMulti: public GeomPQP2DRigid {
   virtual bool CollisionFree(const MSLVector &q); // Input is configuration
   virtual double DistanceComp(const MSLVector &q);  // Distance in world
   virtual void LoadRobot(string path); // Load multiple robots
+  virtual size_t MemoryUsage();
   void SetTransformation(const MSLVector &q); // Input is configuration
+  //! Compute the transformations into rr and tr, leaving members alone
+  void SetTransformation(const MSLVector &q, PQP_REAL rr[][3][3], 
+			 PQP_REAL tr[][3]);
 };
 
 
@@ -109,6 +153,9 @@ class GeomPQP3DRigid: public GeomPQP {
   virtual MSLVector ConfigurationDifference(const MSLVector &q1,
 					      const MSLVector &q2);
   void SetTransformation(const MSLVector &q); // Input is configuration
+  //! Compute the transformation into rr and tr, leaving members alone
+  void SetTransformation(const MSLVector &q, PQP_REAL rr[3][3], 
+			 PQP_REAL tr[3]);
 };
 
 
@@ -127,7 +174,11 @@ class GeomPQP3DRigidMulti: public GeomPQP3DRigid {
   virtual bool CollisionFree(const MSLVector &q); // Input is configuration
   virtual double DistanceComp(const MSLVector &q);  // Distance in world
   virtual void LoadRobot(string path); // Load multiple robots
+  virtual size_t MemoryUsage();
   void SetTransformation(const MSLVector &q); // Input is configuration
+  //! Compute the transformations into rr and tr, leaving members alone
+  void SetTransformation(const MSLVector &q, PQP_REAL rr[][3][3], 
+			 PQP_REAL tr[][3]);
 };
 
 #endif
@@ -147,6 +147,10 @@ class MSLGraph {
   list<MSLEdge*> edges;
   int numvertices;
   int numedges;
+
+  //! Bytes held by the vertices and edges now, and the most held
+  //! before the last Clear
+  size_t bytes,peakbytes;
  public:
 
   MSLGraph();
@@ -165,6 +169,14 @@ class MSLGraph {
   inline int NumVertices() const {return numvertices;}
   inline int NumEdges() const {return numedges;}
 
+  //! Bytes held by the vertices, edges, their states and inputs, and
+  //! the lists that link them (not counting allocator overhead)
+  inline size_t MemoryUsage() const {return bytes;}
+
+  //! The most MemoryUsage has been since the graph was made
+  inline size_t PeakMemoryUsage() const
+    {return (bytes > peakbytes) ? bytes : peakbytes;}
+
   void Clear();
 
   //MSLGraph& operator=(const MSLGraph& n);
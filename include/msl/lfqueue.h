@@ -0,0 +1,102 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_LFQUEUE_H
+#define MSL_LFQUEUE_H
+
+#include <atomic>
+
+/*! An unbounded single-producer, single-consumer queue that needs no
+locks.  One thread may call Push while another thread calls Pop; the
+queue is a singly-linked list with a stub node, so the producer only
+touches the tail and the consumer only touches the head.  This is used
+to pass newly created nodes between the two threads of
+RRTBidirParallel.  */
+
+//! A lock-free queue for handing elements from one thread to another
+
+template<class E> class MSLLockFreeQueue {
+  struct Cell {
+    E Value;
+    std::atomic<Cell*> Next;
+    Cell(): Next(NULL) {};
+  };
+
+  //! The consumer end (always points at the stub cell)
+  Cell *Head;
+
+  //! The producer end
+  Cell *Tail;
+
+  // Not copyable
+  MSLLockFreeQueue(const MSLLockFreeQueue &q);
+  MSLLockFreeQueue& operator=(const MSLLockFreeQueue &q);
+
+ public:
+  MSLLockFreeQueue();
+  ~MSLLockFreeQueue();
+
+  //! Append x to the queue (producer thread only)
+  inline void Push(const E &x);
+
+  //! Remove the oldest element into x; return false if empty (consumer only)
+  inline bool Pop(E &x);
+};
+
+
+template<class E> MSLLockFreeQueue<E>::MSLLockFreeQueue() {
+  Head = Tail = new Cell();
+}
+
+
+template<class E> MSLLockFreeQueue<E>::~MSLLockFreeQueue() {
+  Cell *c;
+
+  while (Head) {
+    c = Head->Next.load(std::memory_order_relaxed);
+    delete Head;
+    Head = c;
+  }
+}
+
+
+template<class E> inline void MSLLockFreeQueue<E>::Push(const E &x) {
+  Cell *c = new Cell();
+
+  c->Value = x;
+  // Publish the filled cell; the consumer acquires it through Next
+  Tail->Next.store(c,std::memory_order_release);
+  Tail = c;
+}
+
+
+template<class E> inline bool MSLLockFreeQueue<E>::Pop(E &x) {
+  Cell *c = Head->Next.load(std::memory_order_acquire);
+
+  if (!c)
+    return false;
+
+  // The popped cell becomes the new stub
+  x = c->Value;
+  delete Head;
+  Head = c;
+
+  return true;
+}
+
+#endif
@@ -40,8 +40,12 @@ template<class E> class MultiArray {
   //! Number of elements in the array
   int Size;
 
+  //! Position of an element in A
+  inline int Offset(const vector<int> &indices);
+
  public:
-  //! Maximum allowable array size (default = 10 million)
+  //! Maximum allowable array size (default = 10 million).  A larger
+  //! array is not allocated; see Allocated.
   int MaxSize;
 
   //! Constructor with default assignment of x to each element
@@ -57,6 +61,27 @@ template<class E> class MultiArray {
   //! This can be used for access or assignment (e.g., ma[indices] = 1).
   inline E& operator[](const vector<int> &indices);
 
+  //! Atomically set the element to y if it currently equals x.  The
+  //! previous value is returned, so the swap happened if it equals x.
+  //! This lets several threads claim elements of a shared array (E 
+  //! must be an integral type).
+  inline E CompareAndSwap(const vector<int> &indices, 
+			  const E &x, const E &y);
+
+  //! False if the array was too large (over MaxSize) to be allocated,
+  //! in which case it holds no elements and must not be indexed
+  inline bool Allocated() const {return (int) A.size() == Size;}
+
+  //! Number of elements (cells) the array has, or would have if it
+  //! were allocated
+  inline int NumElements() const {return Size;}
+
+  //! Bytes held by the elements and the index tables
+  inline size_t MemoryUsage() const {
+    return sizeof(*this) + A.capacity()*sizeof(E) + 
+      (Offsets.capacity() + Dimensions.capacity())*sizeof(int);
+  }
+
   //! Get the next element (used as an iterator).  Return true if at end.
   inline bool Increment(vector<int> &indices);
 
@@ -93,10 +118,8 @@ template<class E> MultiArray<E>::MultiArray(const vector<int> &dims,
     for (i = 0; i < Size; i++)
       A[i] = x; // Write the value x to all elements
   }
-  else {
+  else
     cout << "Size " << Size << " exceeds MaxSize limit " << MaxSize << "\n";
-    exit(-1);
-  }
 
 }
 
@@ -108,8 +131,8 @@ template<class E> MultiArray<E>::MultiArray(const vector<int> &dims) {
 }
 
 
-template<class E> inline E& MultiArray<E>::operator[](const vector<int>
-						      &indices) {
+template<class E> inline int MultiArray<E>::Offset(const vector<int>
+						   &indices) {
   int i,index;
 
   index = indices[0];
@@ -118,7 +141,21 @@ template<class E> inline E& MultiArray<E>::operator[](const vector<int>
     index += indices[i]*Offsets[i];
   }
 
-  return A[index];
+  return index;
+}
+
+
+template<class E> inline E& MultiArray<E>::operator[](const vector<int>
+						      &indices) {
+  return A[Offset(indices)];
+}
+
+
+template<class E> inline E MultiArray<E>::CompareAndSwap(const vector<int>
+							 &indices,
+							 const E &x,
+							 const E &y) {
+  return __sync_val_compare_and_swap(&A[Offset(indices)],x,y);
 }
 
 
@@ -0,0 +1,102 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_METRICS_H
+#define MSL_METRICS_H
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+#include "planner.h"
+
+/*! Live metrics of a running planner in the Prometheus text format.
+
+A thread of its own takes a snapshot every Period seconds.  It reads
+only the planner's Stats and Gauges, which are atomic, so the planning
+thread is never locked or made to wait; Start sets KeepGauges so that
+the planning loop keeps Gauges up to date.  The snapshot gives nodes
+and collision checks per second and the share of wall time spent
+finding nearest neighbors (all over the last period), memory use, the
+distance to the goal (for the planners that keep GoalDist), the sizes
+of T, T2 and Roadmap, and the Stats counters themselves.
+
+If Target starts with "unix:" the rest is the path of a Unix socket,
+and each connection is sent the latest snapshot and closed (with an
+HTTP header if the client sends a GET first, as curl --unix-socket
+does).  Otherwise Target is a file, replaced by each snapshot through a
+rename so that a reader never sees half of one; this suits the textfile
+collector of node_exporter.  */
+class MSLMetrics {
+ private:
+  Planner *Pl;
+  std::thread Worker;
+  std::atomic<bool> Stopping;
+
+  //! The listening socket, or -1 when writing a file
+  int Listener;
+
+  //! Nodes (of T, T2 and Roadmap, from Gauges), Stats and wall time at
+  //! the previous snapshot, for the rates
+  long LastNodes,LastCollisions;
+  double LastNearest,LastTime;
+
+  //! Pl->Stats.Timing before Start, which sets it for the nearest
+  //! neighbor time; Stop puts it back
+  bool WasTiming;
+
+  //! The latest snapshot
+  string Text;
+
+  //! Take a snapshot every Period until Stop, serving the socket
+  //! between snapshots
+  void Run();
+
+  //! Replace the file Target by Text
+  void WriteFile();
+
+  //! Send Text to one connection of the socket
+  void Serve(int fd);
+
+  //! Write the metrics now; rates are since the previous call.  Only
+  //! the thread of Run calls it, since it updates the Last values.
+  void Write(ostream &os);
+
+ public:
+  //! A file, or "unix:" and a socket path
+  string Target;
+
+  //! Seconds between snapshots
+  double Period;
+
+  MSLMetrics(Planner *pl);
+
+  //! Stop if running
+  ~MSLMetrics();
+
+  //! Start taking snapshots of the planner.  False (with a message on
+  //! cerr) if already started or the socket cannot be made.
+  bool Start(const string &target, double period = 1.0);
+
+  //! Take a last snapshot and stop the thread
+  void Stop();
+};
+
+#endif
@@ -43,12 +43,12 @@ class Model {
   //! The complete set of inputs
   list<MSLVector> Inputs;
 
+ public:
   //! Integrate xdot using 4th-order Runge-Kutta
   MSLVector RungeKuttaIntegrate(const MSLVector &x, const MSLVector &u, const double &h);
 
   //! Integrate xdot using Euler integration
   MSLVector EulerIntegrate(const MSLVector &x, const MSLVector &u, const double &h);
- public:
 
   //! This file path is used for all file reads
   string FilePath;
@@ -32,10 +32,8 @@ template<class T> istream& operator>>(istream& in, vector<T>& L);
 
 template<class T> ostream& operator<<(ostream& out, const list<T>& L)
 {
-  typename list<T>::iterator x; 
-  list<T> vl;
-  vl = L;
-  for (x = vl.begin(); x != vl.end(); x++) 
+  typename list<T>::const_iterator x; 
+  for (x = L.begin(); x != L.end(); x++) 
     out << " " << *x;
   return out;
 }
@@ -56,18 +54,16 @@ template<class T> istream& operator>>(istream& in, list<T>& L)
 }
 
 
-template<class T> ofstream& operator<<(ofstream& out, const vector<T>& L)
+template<class T> ostream& operator<<(ostream& out, const vector<T>& L)
 {
-  typename vector<T>::iterator x; 
-  vector<T> vl;
-  vl = L;
-  for (x = vl.begin(); x != vl.end(); x++) 
+  typename vector<T>::const_iterator x; 
+  for (x = L.begin(); x != L.end(); x++) 
     out << " " << *x;
   return out;
 }
 
 
-template<class T> ifstream& operator>>(ifstream& in, vector<T>& L)
+template<class T> istream& operator>>(istream& in, vector<T>& L)
 { 
   L.clear();
   T x;
@@ -20,34 +20,188 @@
 #define MSL_PLANNER_H
 
 #include <list>
+#include <vector>
 #include <fstream>
+#include <atomic>
+#include <mutex>
 using namespace std;
 
 #include "solver.h"
 #include "random.h"
 #include "graph.h"
 #include "tree.h"
+#include "trajectory.h"
+#include "plannerstats.h"
+#include "trace.h"
 #include "vector.h"
 #include "util.h"
 
+//! A flag that another thread can raise to stop a running Plan or
+//! Construct.  Planners poll it once per iteration.
+class MSLCancelToken {
+ private:
+  std::atomic<bool> Cancelled;
+ public:
+  MSLCancelToken() {Cancelled = false;}
+  inline void Cancel() {Cancelled = true;}
+  inline void Reset() {Cancelled = false;}
+  inline bool IsCancelled() const {return Cancelled;}
+};
+
+
+//! Edges added to the trees or roadmap since the consumer last looked.
+//! The planner appends while it runs; a display thread drains.  Edges
+//! are stored as consecutive (from, to) state pairs.
+class MSLPlannerSnapshot {
+ private:
+  std::mutex Lock;
+  list<MSLVector> Edges;
+ public:
+  //! Move the pairs in el onto the end of the pending list
+  void Add(list<MSLVector> &el);
+
+  //! Move all pending pairs onto the end of el
+  void Take(list<MSLVector> &el);
+
+  void Clear();
+};
+
+
+//! What a running planner has done so far, for another thread to read
+//! at any time (see Planner::KeepGauges and MSLMetrics).  The planning
+//! loop stores into it; nothing here is locked.
+class MSLPlannerGauges {
+ public:
+  std::atomic<long> TreeNodes;        // Nodes in T
+  std::atomic<long> Tree2Nodes;       // Nodes in T2
+  std::atomic<long> RoadmapVertices;  // Vertices in Roadmap
+  std::atomic<size_t> MemoryBytes;    // Planner::MemoryUsage
+  std::atomic<double> GoalDist;       // NaN if the planner does not keep it
+  std::atomic<int> Status;            // The MSLPlanStatus of the last run
+  std::atomic<bool> Running;          // In PlanWithin or ConstructWithin
+
+  MSLPlannerGauges() {Clear();}
+  void Clear();
+};
+
+
+//! How the last PlanWithin or ConstructWithin ended
+enum MSLPlanStatus {
+  MSL_PLAN_NONE,       // Not run yet
+  MSL_PLAN_SUCCESS,    // A solution was found (or the graph was built)
+  MSL_PLAN_FAILURE,    // The planner gave up (e.g., NumNodes reached)
+  MSL_PLAN_TIMEOUT,    // The deadline passed
+  MSL_PLAN_CANCELLED,  // The cancel token was raised
+  MSL_PLAN_MEMORY      // MemoryLimit was passed
+};
+
+ostream& operator<< (ostream& os, MSLPlanStatus s);
+
+
 //! The base class for all path planners
 class Planner: public Solver {
  protected:
   MSLRandomSource R;
 
+  //! Time of the last published snapshot (wall clock)
+  double LastSnapshotTime;
+
+  //! How much of T, T2 and Roadmap has already been published
+  int SnapshotNodes,SnapshotNodes2,SnapshotEdges;
+
+  //! Append the edges of T, T2 and Roadmap added since the last
+  //! snapshot to el, as (from, to) pairs
+  virtual void CollectSnapshotEdges(list<MSLVector> &el);
+
+  //! PublishSnapshot for tree t alone, with count (SnapshotNodes or
+  //! SnapshotNodes2) and last in place of the planner's.  A thread of a
+  //! parallel planner calls it for the tree it grows, since the other
+  //! trees may be growing while it runs.
+  void PublishTreeSnapshot(MSLTree *t, int &count, double &last,
+			   bool force = false);
+
+  //! True if the planning loop should stop early (cancelled, the
+  //! deadline has passed, or MemoryLimit has been passed)
+  bool Interrupted();
+
+  //! Set once MemoryUsage passes MemoryLimit during a run
+  atomic<bool> MemoryExceeded;
+
+  //! Calls of Interrupted since MemoryUsage was last checked against
+  //! MemoryLimit or stored in Gauges (this is done every 64 calls)
+  atomic<int> MemoryPolls;
+
+  //! Store the sizes of T, T2 and Roadmap, and bytes as MemoryBytes, in
+  //! Gauges (planners that keep a distance to the goal add it)
+  virtual void UpdateGauges(size_t bytes);
+
+  //! Set Status after a run, and record a partial result on anything
+  //! but success
+  void FinishStatus(bool success);
+
+  //! Fill BestState and PartialPath from whatever has been built so far
+  virtual void RecordPartialSolution();
+
+  //! Send Path, Policy and TimeList to Sink, for planners that make
+  //! the whole solution at once
+  void SendSolution();
+
   //! Choose a state at random
   MSLVector RandomState();
 
+  //! Choose a state at random, drawing from rs instead of R (this
+  //! lets each thread of a parallel planner keep its own source)
+  MSLVector RandomState(MSLRandomSource &rs);
+
+  //! Fill x with n random states, one after another (n*StateDim
+  //! doubles), drawing from rs.  Nothing is allocated.  RandomState
+  //! draws its one state this way, and gets the same state as the first
+  //! of a block would.
+  void RandomStates(MSLRandomSource &rs, double *x, int n);
+
   //! Pick a state using a Normal distribution
   MSLVector NormalState(MSLVector mean, double sd);
 
+  //! LowerState and UpperState-LowerState, unpacked by Reset for the
+  //! samplers.  They are copies: call Reset after changing
+  //! P->LowerState or P->UpperState.
+  vector<double> StateLower,StateRange;
+
+  //! Streams of Seed handed out by SplitRandomSource so far
+  int NumStreams;
+
+  //! Seed rs with the next stream of Seed, for a worker thread.  The
+  //! streams are independent of R and of each other, and are the same
+  //! on every run with the same Seed.
+  void SplitRandomSource(MSLRandomSource &rs);
+
+  //! P->Integrate, timed in Stats
+  inline MSLVector Integrate(const MSLVector &x, const MSLVector &u,
+			     const double &h) {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_INTEGRATE);
+    return P->Integrate(x,u,h);
+  }
+
+  //! P->Satisfied, timed in Stats
+  inline bool Satisfied(const MSLVector &x) {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_COLLISION);
+    return P->Satisfied(x);
+  }
+
+  //! Append Stats, as one JSON line, to the file stats
+  void WriteStats(const string &run);
+
  public:
-  //! Total amount of time spent on planning
+  //! Total amount of processor time spent on planning (of all threads,
+  //! for the parallel planners)
   double CumulativePlanningTime;
 
-  //! Total amount of time spent on construction
+  //! Total amount of processor time spent on construction
   double CumulativeConstructTime;
 
+  //! Total wall-clock time of PlanWithin and of ConstructWithin
+  double CumulativePlanningWallTime,CumulativeConstructWallTime;
+
   //! The solution path, as a list of states
   list<MSLVector> Path;
 
@@ -61,6 +215,11 @@ class Planner: public Solver {
   //! This will make "regular" path planning much faster.
   bool Holonomic;
 
+  //! Set to true to write trees (or roadmaps, see MSLRoadmapFile) in
+  //! binary (default false, or true if the file BinaryGraphs exists).
+  //! Either format is read.
+  bool BinaryGraphs;
+
   //! How much gap error is allowed for each element in bidirectional search
   MSLVector GapError; 
 
@@ -90,6 +249,85 @@ class Planner: public Solver {
   //! Time step to use for incremental planners
   double PlannerDeltaT;
 
+  //! If set, Plan and Construct return early once it is cancelled
+  MSLCancelToken *CancelToken;
+
+  //! Wall-clock time (see wall_time) after which Plan and Construct
+  //! return early; 0 means no deadline
+  double Deadline;
+
+  //! How the last PlanWithin or ConstructWithin ended
+  MSLPlanStatus Status;
+
+  //! The closest state to the goal reached so far
+  MSLVector BestState;
+
+  //! When planning does not succeed: the states from the initial state
+  //! to BestState (empty for roadmap planners, whose partial result is
+  //! the Roadmap itself)
+  list<MSLVector> PartialPath;
+
+  //! If set, new edges are published here while the planner runs
+  MSLPlannerSnapshot *Snapshot;
+
+  //! Minimum number of seconds between published snapshots (default 0.25)
+  double SnapshotPeriod;
+
+  //! Publish the edges added since the last call, if a Snapshot is
+  //! attached and SnapshotPeriod has passed (or force is true)
+  void PublishSnapshot(bool force = false);
+
+  //! Forget what has been published, so the next snapshot starts over
+  void ResetSnapshot();
+
+  //! Calls and time spent in each phase since the last Reset,
+  //! PlanWithin or ConstructWithin, which clear it.  Calling Plan or
+  //! Construct directly adds to it, as it does to CumulativePlanningTime.
+  //! Stats.Timing is set by Reset if SaveStats is or the file PhaseTiming
+  //! exists; otherwise only the calls are counted.
+  MSLPlannerStats Stats;
+
+  //! Set to true to append Stats to the file stats after each PlanWithin
+  //! and ConstructWithin (default false, or true if the file
+  //! PlannerStats exists)
+  bool SaveStats;
+
+  //! A soft cap in megabytes on MemoryUsage (0, the default, for none),
+  //! read from the file MemoryLimit.  Plan and Construct stop cleanly
+  //! with MSL_PLAN_MEMORY once it is passed.
+  double MemoryLimit;
+
+  //! Add the bytes held by each data structure of the planner (trees,
+  //! roadmap, collision models, and so on) to ml
+  virtual void MemoryItems(list<MSLMemoryItem> &ml);
+
+  //! Bytes held now by all of MemoryItems
+  size_t MemoryUsage();
+
+  //! The sum of the peaks of all of MemoryItems
+  size_t PeakMemoryUsage();
+
+  //! Write MemoryItems as a JSON object (see
+  //! MSLPlannerStats::WriteMemoryJSON)
+  void WriteMemoryJSON(ostream &os);
+
+  //! Sizes, memory and goal distance of the run in progress; kept up to
+  //! date only if KeepGauges is set
+  MSLPlannerGauges Gauges;
+
+  //! Set to true to have the planning loop refresh Gauges every 64
+  //! iterations (default false; MSLMetrics sets it).  Any thread of a
+  //! parallel planner may do so, since the counts of MSLTree are atomic.
+  atomic<bool> KeepGauges;
+
+  //! If set, Extend, Connect and the other traced steps are recorded
+  //! here (see MSLTrace)
+  MSLTrace *Trace;
+
+  //! If set, each solution is sent here sample by sample as it is
+  //! recorded (Path, Policy and TimeList are still filled as before)
+  MSLTrajectorySink *Sink;
+
   //! A constructor that initializes data members.
   Planner(Problem *problem);
 
@@ -98,12 +336,29 @@ class Planner: public Solver {
   //! Reset the planner
   void Reset();
 
+  //! Restart the random source of the planner from seed, so that a
+  //! run can be repeated
+  void SetSeed(int seed);
+
+  //! The seed of the planner's random source.  It is read from the file
+  //! Seed by Reset if there is one, and otherwise drawn from the clock,
+  //! so that any single-threaded run can be repeated with SetSeed(Seed).
+  int Seed;
+
   //! Generate a planning graph
   virtual void Construct() = 0;
 
   //! Attempt to solve an Initial-Goal query
   virtual bool Plan() = 0;
 
+  //! Run Plan, giving up after timelimit seconds of wall time (0 for no
+  //! limit) or once token is cancelled.  Returns and sets Status.
+  MSLPlanStatus PlanWithin(double timelimit, MSLCancelToken *token = NULL);
+
+  //! Run Construct under the same limits as PlanWithin
+  MSLPlanStatus ConstructWithin(double timelimit,
+				MSLCancelToken *token = NULL);
+
   //! Write roadmap or trees to a file
   virtual void WriteGraphs(ofstream &fout) = 0;
 
@@ -136,6 +391,10 @@ class IncrementalPlanner: public Planner {
 
   //! Read trees from a file
   virtual void ReadGraphs(ifstream &fin);
+
+ protected:
+  //! Use the node of T closest to the goal
+  virtual void RecordPartialSolution();
 };
 
 
@@ -151,6 +410,10 @@ class RoadmapPlanner: public Planner {
 
   //! Read roadmap from a file
   virtual void ReadGraphs(ifstream &fin);
+
+ protected:
+  //! Use the roadmap vertex closest to the goal
+  virtual void RecordPartialSolution();
 };
 
 
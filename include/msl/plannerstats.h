@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_PLANNERSTATS_H
+#define MSL_PLANNERSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+using namespace std;
+
+#include "profile.h"
+
+
+//! The parts of a planning iteration that MSLPlannerStats times.
+//! Phases may nest: input selection includes the integration and
+//! collision checks that it makes.
+enum MSLPlannerPhase {
+  MSL_PHASE_SAMPLE,        // Choosing a random state
+  MSL_PHASE_NEAREST,       // Finding the nearest node or neighbors
+  MSL_PHASE_SELECT_INPUT,  // Choosing the input that gets closest
+  MSL_PHASE_INTEGRATE,     // Problem::Integrate
+  MSL_PHASE_COLLISION,     // Problem::Satisfied (collision checking)
+  MSL_PHASE_INSERT,        // Adding nodes and edges to a tree or roadmap
+  MSL_PHASE_RECOVER,       // Turning a tree path into Path and Policy
+  MSL_NUM_PHASES
+};
+
+
+//! Bytes held by one data structure of a planner (see
+//! Planner::MemoryItems)
+struct MSLMemoryItem {
+  const char *Name;   // As written by WriteMemoryJSON, such as "tree"
+  size_t Bytes;       // Held now
+  size_t PeakBytes;   // The most held since the structure was made
+  long Items;         // Nodes, vertices and edges, or cells (0 if none)
+};
+
+
+/*! Call counts and accumulated time for each MSLPlannerPhase.  Adding
+to it takes two relaxed atomic increments, so several threads of one
+planner may share it.  Calls are always counted; the time is only
+measured while Timing is set, since that reads the clock twice per
+call, and Integrate and Satisfied are called very often. */
+class MSLPlannerStats {
+ private:
+  std::atomic<long> Calls[MSL_NUM_PHASES];
+  std::atomic<long long> Nanoseconds[MSL_NUM_PHASES];
+ public:
+  MSLPlannerStats() {Timing = false; Clear();}
+
+  //! Set to true to also measure the time of each call (default false);
+  //! Clear leaves it as it is
+  std::atomic<bool> Timing;
+
+  //! A monotonic time stamp in nanoseconds
+  static inline long long Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	     std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  //! Count one call of phase p that took ns nanoseconds
+  inline void Add(MSLPlannerPhase p, long long ns) {
+    Calls[p].fetch_add(1,std::memory_order_relaxed);
+    Nanoseconds[p].fetch_add(ns,std::memory_order_relaxed);
+  }
+
+  //! Set all counts and times to zero
+  void Clear();
+
+  inline long NumCalls(MSLPlannerPhase p) const {return Calls[p];}
+  inline double Seconds(MSLPlannerPhase p) const {return Nanoseconds[p]*1e-9;}
+
+  //! The name of p as written by WriteJSON, such as "nearest"
+  static const char* PhaseName(MSLPlannerPhase p);
+
+  //! Write one JSON object with a {"calls","seconds"} object per phase
+  void WriteJSON(ostream &os) const;
+
+  //! Write one JSON object with a {"bytes","peak_bytes","items",
+  //! "bytes_per_item"} object per item of ml, and their sums as "total"
+  static void WriteMemoryJSON(ostream &os, const list<MSLMemoryItem> &ml);
+};
+
+
+//! Count a call of a phase, and add the time between construction and
+//! destruction to it if Stats.Timing is set.  With MSL_PROFILING the
+//! phase is also a profiler marker (see MSLProfiler).
+class MSLPhaseTimer {
+ private:
+  MSLPlannerStats &Stats;
+  MSLPlannerPhase Phase;
+  long long Start;
+ public:
+  MSLPhaseTimer(MSLPlannerStats &s, MSLPlannerPhase p):
+    Stats(s), Phase(p),
+    Start(s.Timing.load(std::memory_order_relaxed) ?
+	  MSLPlannerStats::Now() : -1) {
+#ifdef MSL_PROFILING
+    MSLProfiler::Begin(MSLPlannerStats::PhaseName(p));
+#endif
+  }
+  ~MSLPhaseTimer() {
+#ifdef MSL_PROFILING
+    MSLProfiler::End();
+#endif
+    Stats.Add(Phase,(Start >= 0) ? MSLPlannerStats::Now() - Start : 0);
+  }
+};
+
+
+#endif
@@ -22,6 +22,7 @@
 #include <queue>
 
 #include "planner.h"
+#include "roadmapfile.h"
 #include "util.h"
 
 /*! The base class for planners based on the Probabilistic Roadmap Planner (PRM)
@@ -43,6 +44,15 @@ class PRM: public RoadmapPlanner {
   double StepSize;  // Derived from DeltaT using the model
   int MaxNeighbors;
   int MaxEdgesPerVertex;
+
+  //! Connect x to a vertex of MappedRoadmap, as NeighboringVertices and
+  //! Connect would; toward is true if the path leads from x to the
+  //! vertex.  Returns the vertex, or -1, and the input that connects
+  //! them in u_best.
+  int ConnectMapped(const MSLVector &x, bool toward, MSLVector &u_best);
+
+  //! Plan over MappedRoadmap without changing it
+  bool PlanMapped();
  public:
 
   //! Used for deciding on which neighbors to choose
@@ -57,11 +67,18 @@ class PRM: public RoadmapPlanner {
   //! Choose Hammersley, over Halton sequence
   bool QuasiRandomHammersley;
 
+  //! A roadmap mapped from a file by MapRoadmap.  When it is set, Plan
+  //! searches it in place (the initial and goal states are not added to
+  //! it), and Roadmap is not used.
+  MSLRoadmapFile *MappedRoadmap;
+
   //! A constructor that initializes data members.
   PRM(Problem *problem);
 
-  //! Empty destructor
-  virtual ~PRM() {};
+  virtual ~PRM();
+
+  //! Map a roadmap written with BinaryGraphs, for Plan to use directly
+  bool MapRoadmap(const string &fname);
 
   //! Build a PRM
   virtual void Construct();
@@ -123,6 +123,9 @@ class Problem {
   //! The distance computation algorithm from Geom
   virtual double DistanceComp(const MSLVector &q); 
 
+  //! Bytes held by the collision models of Geom
+  virtual size_t MemoryUsage();
+
   //! Maximum displacement of geometry with respect to change in each variable
   MSLVector MaxDeviates; 
 
@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_PROFILE_H
+#define MSL_PROFILE_H
+
+#include <iostream>
+using namespace std;
+
+/*! Markers for sampling profilers.  A marker names the region of code
+a thread is in, such as a planner phase or a Problem method.  Markers
+nest, and each thread keeps a stack of them.
+
+When MSL is built with MSL_PROFILING (the CMake option of that name,
+which also keeps frame pointers for perf), MSL_PROFILE_SCOPE pushes a
+marker for the rest of the enclosing block.  MSLPhaseTimer pushes the
+phase it times the same way.  If <sys/sdt.h> is found, each marker also
+fires the USDT probes msl:marker_begin and msl:marker_end with the
+name as argument, so that perf and bpftrace can see them.  Without
+MSL_PROFILING the macro expands to nothing.
+
+MSLProfiler is a sampler built in: on each SIGPROF it counts the
+marker stack of the thread that was running, and WriteFolded gives the
+counts in the folded format read by flamegraph.pl and speedscope.  */
+
+//! Markers deeper than this are counted in the depth but not named
+#define MSL_PROFILE_MAX_DEPTH 16
+
+#ifdef MSL_PROFILING
+#ifdef __has_include
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define MSL_PROFILE_PROBE(P,NAME) DTRACE_PROBE1(msl,P,NAME)
+#endif
+#endif
+#endif
+#ifndef MSL_PROFILE_PROBE
+#define MSL_PROFILE_PROBE(P,NAME)
+#endif
+
+
+//! The markers a thread is in, outermost first
+struct MSLMarkerStack {
+  const char *Names[MSL_PROFILE_MAX_DEPTH];
+  volatile int Depth;
+};
+
+extern thread_local MSLMarkerStack MSLMarkers;
+
+
+class MSLProfiler {
+ public:
+  //! Enter the region name (a string that is never freed)
+  static inline void Begin(const char *name) {
+    int d = MSLMarkers.Depth;
+    if (d < MSL_PROFILE_MAX_DEPTH)
+      MSLMarkers.Names[d] = name;
+    // The signal handler must not see the new depth before the name
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    MSLMarkers.Depth = d + 1;
+    MSL_PROFILE_PROBE(marker_begin,name);
+  }
+
+  //! Leave the innermost region
+  static inline void End() {
+    int d = MSLMarkers.Depth - 1;
+    MSL_PROFILE_PROBE(marker_end,
+		      (d < MSL_PROFILE_MAX_DEPTH) ? MSLMarkers.Names[d] : "");
+    MSLMarkers.Depth = d;
+  }
+
+  //! True if MSL was built with MSL_PROFILING, so that markers are kept
+  static bool MarkersEnabled();
+
+  //! Sample the marker stacks hz times per second of CPU time used by
+  //! the process.  False if sampling is already on or cannot start.
+  static bool Start(int hz = 997);
+
+  //! Stop sampling; the counts are kept until Clear
+  static void Stop();
+
+  //! Forget all samples
+  static void Clear();
+
+  //! Samples taken, and samples lost because too many different stacks
+  //! were seen
+  static long NumSamples();
+  static long NumDropped();
+
+  //! Write one line per stack: the markers, outermost first, joined by
+  //! ';' ("(none)" outside every marker), a space, and the count
+  static void WriteFolded(ostream &os);
+};
+
+
+//! Keeps a marker for its lifetime
+class MSLProfileScope {
+ public:
+  MSLProfileScope(const char *name) {MSLProfiler::Begin(name);}
+  ~MSLProfileScope() {MSLProfiler::End();}
+};
+
+
+#ifdef MSL_PROFILING
+#define MSL_PROFILE_SCOPE(NAME) MSLProfileScope _msl_profile_scope(NAME)
+#else
+#define MSL_PROFILE_SCOPE(NAME)
+#endif
+
+#endif
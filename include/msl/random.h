@@ -20,26 +20,42 @@
 #define MSL_RANDOM_H
 
 
+/*! Random numbers from xoshiro256** (Blackman and Vigna), a 256-bit
+state that is advanced with a few shifts and xors.  The interface is
+the one of the old LEDA-style additive generator; uniform, normal and
+the block form of uniform are the fast paths for sampling. */
 class MSLRandomSource {
 
-  long  table[32];
-  long* ptr0;
-  long* ptr1;
-  long* ptr2;
-  long* ptr_end;
+  unsigned long long state[4];
   unsigned long pat;
   int  prec;
   int  low;
   int  diff;
   bool bit_mode;
-  unsigned long buffer;
+  bool have_normal;
+  double next_normal;
   static int count;
-  void          init_table();
+
+  static inline unsigned long long rotl(unsigned long long x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
 
 public:
 
-  unsigned long get_rand31();
-  unsigned long get_rand32();
+  //! The next 64 random bits
+  inline unsigned long long get_rand64() {
+    unsigned long long r = rotl(state[1] * 5, 7) * 9;
+    unsigned long long t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return r;
+  }
+  unsigned long get_rand31() { return (unsigned long)(get_rand64() >> 33); }
+  unsigned long get_rand32() { return (unsigned long)(get_rand64() >> 32); }
   MSLRandomSource();
   MSLRandomSource(int p);
   MSLRandomSource(int low, int high);
@@ -49,9 +65,18 @@ public:
 #endif
  return r; }
   void set_seed(int s);
+  //! Seed stream number stream of seed.  Different streams of one seed
+  //! are independent, so each thread of a planner can have its own.
+  void set_stream(int seed, int stream);
   void set_range(int low, int high);
   int set_precision(int p);
   int get_precision() { return prec; }
+  //! A uniform double in [0,1), with all 53 bits random
+  inline double uniform() { return (get_rand64() >> 11) * (1.0/9007199254740992.0); }
+  //! Fill x[0..n-1] with uniform doubles in [0,1)
+  void uniform(double *x, int n);
+  //! A standard normal double (polar Box-Muller, two per pair of uniforms)
+  double normal();
 #if defined(__HAS_BUILTIN_BOOL__)
   MSLRandomSource& operator>>(char& x);
 #endif
@@ -60,7 +85,7 @@ public:
   MSLRandomSource& operator>>(long& x);
   MSLRandomSource& operator>>(unsigned int& x);
   MSLRandomSource& operator>>(unsigned long& x);
-  MSLRandomSource& operator>>(double& x);
+  MSLRandomSource& operator>>(double& x) { x = uniform(); return *this; }
   MSLRandomSource& operator>>(float& x);
   MSLRandomSource& operator>>(bool& b);
   int operator()();    
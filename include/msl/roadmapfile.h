@@ -0,0 +1,123 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_ROADMAPFILE_H
+#define MSL_ROADMAPFILE_H
+
+#include <string>
+#include <iostream>
+using namespace std;
+
+#include "graph.h"
+#include "vector.h"
+
+/*! A roadmap stored in compressed sparse row (CSR) form, in a file that
+can be memory-mapped and searched in place.  The file is a 64-byte
+header followed by these blocks, all in native byte order:
+
+  double states[NumVertices*StateDim]
+  double costs[NumEdges]
+  double times[NumEdges]
+  double inputs[NumEdges*InputDim]   (InputDim may be 0)
+  int    offsets[NumVertices+1]
+  int    targets[NumEdges]
+
+The edges leaving vertex v are offsets[v] through offsets[v+1]-1.  A
+mapped file is read-only, so any number of planners (and threads) can
+share one.  */
+
+#define MSL_ROADMAP_MAGIC "MSLRMAP"
+#define MSL_ROADMAP_VERSION 1
+
+struct MSLRoadmapHeader {
+  char Magic[8];
+  int Version;
+  int NumVertices;
+  int NumEdges;
+  int StateDim;
+  int InputDim;
+  int Reserved[9];
+};
+
+//! A read-only roadmap in CSR form, usually memory-mapped from a file
+class MSLRoadmapFile {
+ private:
+  //! The mapped region (NULL if the data is not mapped)
+  void *Map;
+  size_t MapSize;
+
+  //! A copy of the data, when it was read from a stream instead
+  string Buffer;
+
+  const MSLRoadmapHeader *Header;
+  const double *States;
+  const double *Costs;
+  const double *Times;
+  const double *Inputs;
+  const int *Offsets;
+  const int *Targets;
+
+  //! Point the arrays into data; false if it is not a valid roadmap
+  bool Attach(const char *data, size_t size);
+
+ public:
+  MSLRoadmapFile();
+  ~MSLRoadmapFile();
+
+  //! Map a roadmap file; false if it cannot be opened or is not valid
+  bool Open(const string &fname);
+
+  //! Read a roadmap from a stream into memory
+  bool Read(istream &is);
+
+  //! Release the data
+  void Close();
+
+  inline bool IsOpen() const {return Header != NULL;};
+
+  //! Write g in this format
+  static void Write(ostream &os, const MSLGraph &g);
+
+  //! Make an ordinary graph with the same vertices and edges
+  MSLGraph* MakeGraph() const;
+
+  inline int NumVertices() const {return Header->NumVertices;};
+  inline int NumEdges() const {return Header->NumEdges;};
+  inline int StateDim() const {return Header->StateDim;};
+  inline int InputDim() const {return Header->InputDim;};
+
+  //! The state of vertex v
+  MSLVector State(int v) const;
+
+  //! The first edge leaving v
+  inline int EdgeBegin(int v) const {return Offsets[v];};
+
+  //! One past the last edge leaving v
+  inline int EdgeEnd(int v) const {return Offsets[v+1];};
+
+  //! The vertex that edge e leads to
+  inline int Target(int e) const {return Targets[e];};
+
+  inline double Cost(int e) const {return Costs[e];};
+  inline double Time(int e) const {return Times[e];};
+
+  //! The input applied along edge e (empty if none were stored)
+  MSLVector Input(int e) const;
+};
+
+#endif
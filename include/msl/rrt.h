@@ -19,7 +19,11 @@
 #ifndef MSL_RRT_H
 #define MSL_RRT_H
 
+#include <atomic>
+
 #include "planner.h"
+#include "compacttree.h"
+#include "lfqueue.h"
 #include "util.h"
 
 #ifdef USE_ANN
@@ -61,6 +65,10 @@ class RRT: public IncrementalPlanner {
   //! Pick a state using some sampling technique
   virtual MSLVector ChooseState();
 
+  //! Also store GoalDist in Gauges, if there is no T2 (the dual-tree
+  //! planners do not keep it)
+  virtual void UpdateGauges(size_t bytes);
+
   public:
 
   //! If true, then the ANN package is used for nearest neighbors.  It
@@ -70,9 +78,6 @@ class RRT: public IncrementalPlanner {
   //! The distance of the closest RRT MSLNode to the goal
   double GoalDist;
 
-  //! The closest state to the goal so far (not used in dual-tree planners)
-  MSLVector BestState;
-
   //! The maximum amount of time to move in a Connect step (default = INFINITY)
   double ConnectTimeLimit;
 
@@ -87,8 +92,9 @@ class RRT: public IncrementalPlanner {
   //! Empty destructor
   virtual ~RRT() {};
   
-  //! Number of times the collision checker has been called
-  int SatisfiedCount;
+  //! Number of times the collision checker has been called (atomic so
+  //! that parallel planners can share it across threads)
+  std::atomic<int> SatisfiedCount;
 
   //! Reset the planner
   virtual void Reset();
@@ -322,6 +328,92 @@ class RRTBidirBalanced: public RRTDual {
 };
 
 
+/*! This planner follows RRTConCon, but each tree is grown on its own
+    thread.  The thread for G connects G toward random samples, and 
+    the thread for G2 does the same for G2.  Every node added in this
+    way is handed to the other thread through a lock-free queue; the
+    other thread uses Connect to grow its own tree toward it, and 
+    checks GapSatisfied for the pair.  The first thread to close the
+    gap stops both threads, and RecoverSolution stitches the path on
+    the calling thread.
+
+    Each thread performs NumNodes/2 exploration steps, which matches
+    the work done by RRTConCon.  Each thread draws samples from its own
+    random source; the goal thread's is split from Seed (see
+    Planner::SplitRandomSource).  The Problem must allow concurrent
+    calls to Metric, Integrate, and Satisfied; this holds for the
+    PQP-based geometries.
+*/
+//! RRTConCon with the two trees grown concurrently on two threads
+
+class RRTBidirParallel: public RRTDual {
+ protected:
+  //! Set by the first thread that closes the gap
+  std::atomic<bool> Connected;
+
+  //! The pair of nodes (in G and G2) that closed the gap
+  MSLNode *ConnectNode,*ConnectNode2;
+
+  //! Grow tree t on the calling thread, publishing new nodes to out 
+  //! and attempting connections to nodes taken from in
+  void GrowTree(MSLTree *t, bool forward, MSLRandomSource *rs,
+		MSLLockFreeQueue<MSLNode*> *out,
+		MSLLockFreeQueue<MSLNode*> *in);
+ public:
+  RRTBidirParallel(Problem *p);
+  virtual ~RRTBidirParallel() {};
+
+  //! Grow both trees concurrently until they connect
+  virtual bool Plan();
+};
+
+
+/*! RRTGoalBias with its tree held in an MSLCompactTree, so that runs
+    of millions of nodes fit in memory.  States are kept to the precision
+    of a grid with 2^CompactBits steps per dimension (default 24, from
+    the file CompactBits), and nearest neighbors are found from a 16-bit
+    copy of each state.  T stays empty while planning; MakeTree builds
+    it on request (WriteGraphs does so).  */
+//! A goal-biased RRT with a compact, quantized tree
+class RRTCompact: public RRTGoalBias {
+ protected:
+  //! How much of CT has been published (see PublishSnapshot)
+  int SnapshotCompactNodes;
+
+  //! The nearest node to x, using the 16-bit index
+  int SelectCompactNode(const MSLVector &x);
+
+  virtual void RecordPartialSolution();
+  virtual void CollectSnapshotEdges(list<MSLVector> &el);
+
+  //! Count the nodes of CT as those of T
+  virtual void UpdateGauges(size_t bytes);
+ public:
+  //! The tree (NULL until Plan is called)
+  MSLCompactTree *CT;
+
+  //! Grid resolution for stored states, in bits per dimension
+  int CompactBits;
+
+  RRTCompact(Problem *p);
+  virtual ~RRTCompact();
+
+  virtual void Reset();
+
+  //! Grow the compact tree toward the goal
+  virtual bool Plan();
+
+  //! Set T to an ordinary copy of the compact tree
+  void MakeTree();
+
+  //! Write the tree, expanding it into T first
+  virtual void WriteGraphs(ofstream &fout);
+
+  //! The compact tree as well as those of Planner
+  virtual void MemoryItems(list<MSLMemoryItem> &ml);
+};
+
+
 /*! Grow a tree incrementally by simply selecting vertex at random and 
     moving in a random direction from the chosen vertex.   It is not 
     really a Rapidly-exploring Random Tree since there is no random
@@ -19,7 +19,26 @@
 #ifndef MSL_SETUP_H
 #define MSL_SETUP_H
 
+#include <list>
+#include <string>
+using namespace std;
+
+#include "model.h"
+#include "geom.h"
+#include "problem.h"
+#include "planner.h"
+
+//! Make the Model and Geom named by the files in path (for example,
+//! the file Model2DRigid selects Model2DRigid); Model2DPoint and
+//! GeomPQP2DRigid are used if none is named
 void SetupProblem(Model *&m, Geom *&g, string path);
 
+//! Make the planner whose class is called name (for example, "RRTConCon"),
+//! or return NULL if there is no such planner
+Planner* MakePlanner(const string &name, Problem *p);
+
+//! The names accepted by MakePlanner
+list<string> PlannerNames();
+
 #endif
 
@@ -0,0 +1,139 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_TRACE_H
+#define MSL_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+using namespace std;
+
+#include "vector.h"
+
+//! The number of state components kept with each event
+#define MSL_TRACE_MAX_DIM 16
+#define MSL_TRACE_MAGIC "MSLTRACE"
+#define MSL_TRACE_VERSION 1
+
+
+//! What a planner was doing when it recorded an MSLTraceEvent
+enum MSLTraceKind {
+  MSL_TRACE_EXTEND,    // RRT::Extend toward Sample
+  MSL_TRACE_CONNECT,   // RRT::Connect toward Sample; Count is the steps
+  MSL_TRACE_SAMPLE,    // PRM::Construct sample; Count is the edges added
+  MSL_TRACE_EXPAND,    // FDP::Plan expansion of Node; Count is the children
+  MSL_TRACE_SELECT     // An RCRRT node selector; Count is 1 if in a ball
+};
+
+//! How the traced step ended
+enum MSLTraceResult {
+  MSL_TRACE_OK,           // A node (or vertex) was added or chosen
+  MSL_TRACE_COLLISION,    // Stopped by Problem::Satisfied
+  MSL_TRACE_NO_PROGRESS,  // Connect got no closer to Sample
+  MSL_TRACE_TIME_LIMIT,   // Connect reached ConnectTimeLimit
+  MSL_TRACE_VISITED,      // Every new FDP state fell in a visited cell
+  MSL_TRACE_NOT_FOUND     // The selector found no node to expand
+};
+
+
+//! One traced planner step.  The layout is also the record of the
+//! binary trace format.
+struct MSLTraceEvent {
+  long long Start;      // Nanoseconds since the trace was cleared
+  long long Duration;   // Nanoseconds
+  int Kind;             // An MSLTraceKind
+  int Result;           // An MSLTraceResult
+  int Thread;           // A small number per planner thread
+  int Node;             // The ID of the chosen node, or -1
+  int NewNode;          // The ID of the added node or vertex, or -1
+  int Count;            // Depends on Kind (see MSLTraceKind)
+  int Dim;              // The dimension of Sample (at most MSL_TRACE_MAX_DIM)
+  int Pad;
+  double Sample[MSL_TRACE_MAX_DIM];  // The state the step aimed at
+};
+
+
+/*! A fixed-size ring buffer of planner events.  Any number of threads
+may Add at once: each event claims a slot with one atomic increment,
+and once the ring is full the oldest events are overwritten.  Write
+and Read should only be called while no planner is adding.
+
+A planner only traces if its Trace member is set, so tracing costs one
+pointer test per step when it is off.  */
+class MSLTrace {
+ private:
+  vector<MSLTraceEvent> Events;
+  unsigned long long Mask;
+  std::atomic<unsigned long long> Head;
+  long long Origin;
+
+  //! Events dropped before those in the ring, as read by ReadBinary
+  long long Lost;
+
+  //! A small number for the calling thread, starting at 0
+  static int ThreadNumber();
+ public:
+  //! Keep the last capacity events (rounded up to a power of two)
+  MSLTrace(int capacity = 65536);
+
+  //! A monotonic time stamp in nanoseconds; pass it to Add as start
+  static inline long long Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	     std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  //! Record one step that began at start (a value of Now)
+  void Add(MSLTraceKind kind, long long start, MSLTraceResult result,
+	   int node, int newnode, int count, const MSLVector &sample);
+
+  //! Forget all events and restart the clock
+  void Clear();
+
+  //! The number of events held (at most the capacity)
+  long long Size() const;
+
+  //! The number of events lost because the ring was full
+  long long Dropped() const;
+
+  //! The events held, oldest first
+  vector<MSLTraceEvent> Contents() const;
+
+  //! Write the events as Chrome trace JSON (chrome://tracing, Perfetto)
+  void WriteChrome(ostream &os) const;
+
+  //! Write the events in the binary format: a header, then the raw
+  //! MSLTraceEvent records, oldest first
+  void WriteBinary(ostream &os) const;
+
+  //! Replace the events with those of a binary trace.  False if is
+  //! (which must be seekable, such as a file) is not a whole, valid
+  //! trace.
+  bool ReadBinary(istream &is);
+
+  //! Write to fname, in binary or as Chrome JSON
+  bool Write(const string &fname, bool binary = false) const;
+
+  static const char* KindName(int kind);
+  static const char* ResultName(int result);
+};
+
+
+#endif
@@ -0,0 +1,104 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_TRAJECTORY_H
+#define MSL_TRAJECTORY_H
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "vector.h"
+
+class Problem;
+
+/*! Receives a solution trajectory one sample at a time, while the
+planner records it (see Planner::Sink), so a consumer can act on the
+start of a solution before the rest has been converted.  Each sample
+is a time, a state, and the input applied from that state until the
+next sample.  */
+class MSLTrajectorySink {
+ public:
+  virtual ~MSLTrajectorySink() {};
+
+  //! A new solution starts; anything sent before belongs to an old one
+  virtual void Begin(int /*statedim*/, int /*inputdim*/) {};
+
+  //! The next sample, in order of increasing time
+  virtual void Sample(double t, const MSLVector &x, const MSLVector &u) = 0;
+
+  //! The solution is complete
+  virtual void End() {};
+};
+
+
+#define MSL_TRAJECTORY_MAGIC "MSLTRAJ"
+#define MSL_TRAJECTORY_VERSION 1
+
+/*! Writes samples to a stream as they arrive, flushing after each
+one, in either of two formats:
+
+  text:    a line "# MSL trajectory <statedim> <inputdim>", then one
+           line per sample: t x[0] ... x[statedim-1] u[0] ... u[inputdim-1]
+  binary:  char magic[8]; int version, statedim, inputdim; then per
+           sample 1+statedim+inputdim doubles in native byte order
+
+Inputs shorter than inputdim (e.g. from a PRM) are padded with zeros.
+If ResampleDeltaT is positive and the writer was given a Problem,
+samples are written at that fixed period instead: states are
+interpolated by Problem::InterpolateState, which respects the topology
+of the model (angles wrap), and inputs are held from the sample
+before.  */
+class MSLTrajectoryWriter: public MSLTrajectorySink {
+ private:
+  ostream &Out;
+  int StateDim,InputDim;
+
+  //! Interpolates states for resampling (NULL if none was given)
+  Problem *P;
+
+  //! The last sample received (with resampling): its state and input.
+  //! They are copied in fresh each time, since MSLVector assignment
+  //! never shrinks a vector.
+  bool HavePrevious;
+  double PreviousTime;
+  vector<MSLVector> Previous;
+
+  //! The next time to write (with resampling)
+  double NextTime;
+
+  void Write(double t, const MSLVector &x, const MSLVector &u);
+
+ public:
+  //! Write binary samples instead of text (default false)
+  bool Binary;
+
+  //! Sample period; 0 (the default) writes the samples as received, as
+  //! does any period without a Problem
+  double ResampleDeltaT;
+
+  //! Write to os; p is needed only for resampling
+  MSLTrajectoryWriter(ostream &os, Problem *p = NULL);
+  virtual ~MSLTrajectoryWriter() {};
+
+  virtual void Begin(int statedim, int inputdim);
+  virtual void Sample(double t, const MSLVector &x, const MSLVector &u);
+  virtual void End();
+};
+
+#endif
@@ -21,6 +21,7 @@
 
 #include <list>
 #include <string>
+#include <atomic>
 using namespace std;
 
 
@@ -30,6 +31,10 @@ using namespace std;
 
 class MSLTree;
 
+//! The first bytes of a binary tree, followed by the format version
+#define MSL_TREE_MAGIC "MSLTREE"
+#define MSL_TREE_VERSION 1
+
 class MSLNode {
  private:
   MSLVector state;
@@ -115,7 +120,18 @@ class MSLTree {
  private:
   //  list<MSLNode*> nodes;
   //MSLNode* root;
-  int size;
+
+  //! Atomic, like bytes and peakbytes, so that Size and MemoryUsage
+  //! may be read by one thread while another grows the tree.  Only the
+  //! growing thread writes them, and nothing else is published through
+  //! them, so relaxed loads and stores are enough.
+  std::atomic<int> size;
+
+  //! Bytes held by the nodes now, and the most held before the last Clear
+  std::atomic<size_t> bytes,peakbytes;
+
+  //! Append n to nodes and count its bytes
+  void AddNode(MSLNode *n);
  public:
   list<MSLNode*> nodes;
   MSLNode* root;
@@ -136,10 +152,33 @@ class MSLTree {
   MSLNode* FindNode(int nid);
   inline list<MSLNode*> Nodes() const { return nodes; };
   inline MSLNode* Root() {return root; };
-  inline int Size() {return size;}
+  inline int Size() {return size.load(std::memory_order_relaxed);}
+
+  //! Bytes held by the nodes, their states and inputs, and the node
+  //! list (not counting allocator overhead or the info of each node)
+  inline size_t MemoryUsage() const
+    {return bytes.load(std::memory_order_relaxed);}
+
+  //! The most MemoryUsage has been since the tree was made
+  inline size_t PeakMemoryUsage() const {
+    size_t b = bytes.load(std::memory_order_relaxed),
+      p = peakbytes.load(std::memory_order_relaxed);
+    return (b > p) ? b : p;
+  }
 
   void Clear();
 
+  //! Write the tree in the binary format (see MSL_TREE_MAGIC): a header,
+  //! then parent indices, times, states and inputs as contiguous
+  //! blocks, all in native byte order
+  void WriteBinary(ostream& os) const;
+
+  //! Replace the tree by one in the binary format; false on a bad header
+  //! or a short read
+  bool ReadBinary(istream& is);
+
+  //! Reading detects the format: binary if the stream starts with
+  //! MSL_TREE_MAGIC, and text otherwise
   friend istream& operator>> (istream& is, MSLTree& n);
   friend ostream& operator<< (ostream& os, const MSLTree& n);
 };
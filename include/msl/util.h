@@ -31,6 +31,12 @@ float used_time();
 
 float used_time(float&);
 
+//! Elapsed wall-clock time in seconds (used_time reports processor time,
+//! which adds up over all threads of a parallel planner)
+double wall_time();
+
+double wall_time(double&);
+
 //ostream& operator<<(ostream& out, const list<string>& L);
 
 //istream& operator>>(istream& in, list<string>& L);
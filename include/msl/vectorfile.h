@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#ifndef MSL_VECTORFILE_H
+#define MSL_VECTORFILE_H
+
+#include <list>
+#include <vector>
+#include <string>
+#include <fstream>
+using namespace std;
+
+#include "vector.h"
+
+/*! A binary file of equal-length vectors, such as animation frames or
+a solution path.  It is a 24-byte header
+
+  char magic[8]; int version; int dim; long long count;
+
+followed by count*dim doubles in native byte order, so vector i starts
+at byte 24 + 8*dim*i and can be read without reading the ones before. */
+
+#define MSL_VECTORFILE_MAGIC "MSLVECS"
+#define MSL_VECTORFILE_VERSION 1
+
+struct MSLVectorFileHeader {
+  char Magic[8];
+  int Version;
+  int Dim;
+  long long Count;
+};
+
+
+//! Random access to a file of vectors
+class MSLVectorFile {
+ private:
+  ifstream File;
+  MSLVectorFileHeader Header;
+  bool Valid;
+
+ public:
+  MSLVectorFile();
+
+  //! Open a file and read its header; false if it is not in this format
+  bool Open(const string &fname);
+
+  void Close();
+
+  inline bool IsOpen() const {return Valid;};
+  inline int Dim() const {return Header.Dim;};
+  inline long long Count() const {return Header.Count;};
+
+  //! Read vector i into x
+  bool Get(long long i, MSLVector &x);
+
+  //! Read every vector, in one block
+  bool ReadAll(vector<MSLVector> &vl);
+  bool ReadAll(list<MSLVector> &vl);
+
+  //! Write vectors in this format; they must all have the same dimension
+  static bool Write(ostream &os, const vector<MSLVector> &vl);
+  static bool Write(ostream &os, const list<MSLVector> &vl);
+
+  //! True if the file fname starts with MSL_VECTORFILE_MAGIC
+  static bool IsVectorFile(const string &fname);
+};
+
+#endif
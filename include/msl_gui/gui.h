@@ -109,6 +109,7 @@ enum {
   GID_SAVE_PATH,
   GID_LOAD_PATH,
   GID_DONE,
+  GID_STOP,
 
   GID_RRT,
   GID_RRTGOALBIAS,
@@ -120,11 +121,14 @@ enum {
   GID_RCRRT,
   GID_RCRRTEXTEXT,
   GID_RRTBIDIRBALANCED,
+  GID_RRTBIDIRPARALLEL,
+  GID_RRTCOMPACT,
   GID_PRM,
   GID_FDP,
   GID_FDPSTAR,
   GID_FDPBESTFIRST,
   GID_FDPBI,
+  GID_FDPPARALLEL,
 
   GID_LAST
 };
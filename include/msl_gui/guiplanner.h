@@ -23,6 +23,8 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <thread>
+#include <atomic>
 #include <fx.h>
 
 #include "msl/defs.h"
@@ -32,6 +34,7 @@
 #include "msl/prm.h"
 #include "msl/fdp.h"
 #include "msl/util.h"
+#include "msl/vectorfile.h"
 
 #include "gui.h"
 
@@ -122,15 +125,56 @@ class GuiPlanner: public FXApp, public Gui {
   virtual void CreateMenuWindow();
 
   MSLPlannerWindow* Window;
+
+  //! The thread that runs Plan or Construct, so the GUI stays live
+  std::thread Worker;
+
+  //! Set by Worker when the planner returns
+  std::atomic<bool> WorkerDone;
+
+  //! True from starting Worker until it has been joined
+  bool Working;
+
+  //! Whether Worker is running Plan (true) or Construct (false)
+  bool WorkerPlanning;
+
+  //! The result of the last Plan run by Worker
+  bool PlanSucceeded;
+
+  //! Raised by the Stop button
+  MSLCancelToken Cancel;
+
+  //! Edges published by the running planner, drained by UpdateProgress
+  MSLPlannerSnapshot Snapshot;
+
+  //! Body of Worker: run Plan (plan = true) or Construct
+  void RunPlanner(bool plan);
+
+  //! Start Worker, unless one is already running
+  void StartPlanner(bool plan);
+
+  //! Wait for Worker to stop
+  void JoinPlanner();
+
  public:
   virtual void HandleEvents();
   virtual void ButtonHandle(int b);
+
+  //! Move published edges to the renderer; when Worker has finished,
+  //! join it and make the animation frames.  Called from the timer.
+  void UpdateProgress();
   double LineWidth;
   double PSLineWidth;
   int DrawIndexX,DrawIndexY;
+
+  //! Write animation frames and paths in binary (see MSLVectorFile);
+  //! default false, or true if the file BinaryFrames exists.  Either
+  //! format is read.
+  bool BinaryFrames;
+
   Planner *Pl;
   GuiPlanner(Render *render, Planner *planner);
-  virtual ~GuiPlanner(){};
+  virtual ~GuiPlanner();
   void ResetPlanner();
   void WriteGraphs();
   void ReadGraphs();
@@ -22,6 +22,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 #include "msl/mslio.h"
 #include "msl/util.h"
@@ -72,6 +76,47 @@ class Render
   //! The time stamps for the state sequence
   list<double> TimeList;
 
+  //! StateList copied into a vector, for the frame workers
+  vector<MSLVector> KeyStates;
+
+  //! Frame i interpolates KeyStates[FrameLower[i]] and
+  //! KeyStates[FrameUpper[i]] at FrameLambda[i]; if FrameUpper[i] < 0,
+  //! it is just KeyStates[FrameLower[i]]
+  vector<int> FrameLower,FrameUpper;
+  vector<double> FrameLambda;
+
+  //! The scene used by the frame workers (SetScene may change S while
+  //! they run)
+  Scene *FrameScene;
+
+  //! Threads filling FrameList after SetFrameList returns
+  vector<std::thread> FrameWorkers;
+
+  //! The next chunk of frames to hand out to a worker
+  std::atomic<int> NextFrameChunk;
+
+  //! Set to make the workers give up early
+  std::atomic<bool> StopFrames;
+
+  //! Guards ChunkDone and ReadyChunks
+  std::mutex FrameLock;
+
+  //! Which chunks have been finished, and how many leading ones are
+  vector<bool> ChunkDone;
+  int ReadyChunks;
+
+  //! Compute the frames of one chunk, then advance FramesReady
+  void MakeFrameChunk(int c);
+
+  //! Body of each frame worker
+  void FrameWorker();
+
+  //! Append one entry to the frame schedule
+  void AddFrame(int lower, int upper, double lambda);
+
+  //! Initial values for the frame worker state (used by constructors)
+  void InitFrames();
+
   list<string> EnvList; // File names of all stationary environment objects
   list<string> BodyList; // File names of all movable bodies
 
@@ -84,8 +129,18 @@ class Render
   //! The path name for accessing files
   string FilePath;
 
-  //! The animation frames; each element is a SceneConfiguration
-  list<MSLVector> FrameList;
+  //! The animation frames; each element is a SceneConfiguration.
+  //! While FramesReady < NumFrames, only the first FramesReady are valid.
+  vector<MSLVector> FrameList;
+
+  //! How many frames at the front of FrameList are valid
+  std::atomic<int> FramesReady;
+
+  //! Number of threads used to make the frames (default: all cores)
+  int FrameThreads;
+
+  //! Number of frames computed by a worker at a time (default 32)
+  int FrameChunkSize;
 
   //! The amount of time for which a frame is shown
   double FrameTime;
@@ -114,6 +169,10 @@ class Render
   //! The frame that should be shown currently
   MSLVector CurrentAnimationFrame;
 
+  //! Search graph edges received while a planner runs, as consecutive
+  //! (from, to) SceneConfiguration pairs
+  list<MSLVector> GraphList;
+
   //! Set to true to start the animation
   bool AnimationActive;
 
@@ -145,7 +204,7 @@ class Render
   Render();
   Render(string filepath);
   Render(Scene *s, string filepath);
-  virtual ~Render() {}
+  virtual ~Render();
 
   //! Initialized the renderer
   virtual void Init();
@@ -162,9 +221,20 @@ class Render
   //! Implement functions upon termination of the renderer
   virtual void Terminate() {};
 
-  //! Make the set of frames from StateList and TimeList
+  //! Make the set of frames from StateList and TimeList.  The first
+  //! chunk is ready on return; the rest are filled in by FrameThreads
+  //! threads while the animation plays.
   virtual void SetFrameList();
 
+  //! Wait until all of FrameList is valid
+  void FinishAnimationFrames();
+
+  //! Stop the frame workers, leaving FrameList partly filled
+  void StopAnimationFrames();
+
+  //! Call after replacing FrameList directly (e.g., reading a file)
+  void SetFramesLoaded();
+
   //! Generate FrameList and set AnimationActive to true.
   virtual void MakeAnimationFrames(const list<MSLVector> &xlist, double deltat);
   virtual void MakeAnimationFrames(const list<MSLVector> &xlist,
@@ -173,6 +243,16 @@ class Render
   //! Display an entire path (the specific renderer determines how)
   virtual void DrawPath() {};
 
+  //! Convert (from, to) state pairs to scene configurations and
+  //! append them to GraphList
+  void AddGraphEdges(const list<MSLVector> &edges);
+
+  //! Forget all search graph edges
+  void ClearGraphs();
+
+  //! Display the search graph edges in GraphList
+  virtual void DrawGraphs() {};
+
   //! Execute actions for render control window choices
   virtual void ButtonHandle(int b);
 
@@ -127,6 +127,8 @@ class RenderGL: public Render
 
   void DrawPath();
 
+  void DrawGraphs();
+
   void InitData();
   void InitGeometry(list<MSLTriangle> triangles);
   void DrawBodies(const MSLVector &x);
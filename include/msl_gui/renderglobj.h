@@ -28,6 +28,8 @@
 #include <math.h>
 
 #include <string>
+#include <vector>
+#include <list>
 //#include <algorithm>
 using namespace std;
 //  #include <unistd.h>     // needed to sleep.
@@ -48,6 +50,11 @@ using namespace std;
 #define	MAX_MTL_FILES	512
 #define MAXNAME_LENGTH  50
 
+// Binary model cache written next to each OBJ file
+#define MSL_GLOBJ_CACHE_MAGIC    "MSLGLOB"
+#define MSL_GLOBJ_CACHE_VERSION  1
+#define MSL_GLOBJ_CACHE_SUFFIX   ".cache"
+
 // !!!!!!!!!!!!!!!!!!!!!!!!!!! -- originally from chpdef.h -- 1/5/01
 #define MinX                            -100.0
 #define MinY                            -100.0
@@ -229,6 +236,10 @@ class mslGLFace
 
   int MaterialID;
 
+  // Index of the first corner in the arrays of the owning mslGLObject,
+  // or -1 if the face allocated its own arrays with AddVertex etc.
+  int FirstCorner;
+
   mslGLFace();
   ~mslGLFace();
 
@@ -263,6 +274,17 @@ class mslGLObject
   int NumberOfFace;
   mslGLFace * ObjectFaceLib;
 
+  // Storage behind ObjectFaceLib, and the flat per-corner arrays that
+  // the faces of ReadModelFile point into; the normal and texture
+  // arrays are padded to the length of the vertex array
+  vector<mslGLFace> FaceArray;
+  vector<mslGLVertex> VertexArray;
+  vector<mslGLNormal> NormalArray;
+  vector<mslGLTexCoord> TexCoordArray;
+
+  // Keep a binary copy of each model next to its source file
+  bool UseCache;
+
   float Position[3], Orientation[3];
   float Scale[3];
 
@@ -274,6 +296,11 @@ class mslGLObject
   ~mslGLObject();
 
   int ReadModelFile(const string& path, const string& filename);
+  bool ReadCachedModel(const string& path, const string& filename);
+  void WriteCachedModel(const string& path, const string& filename,
+			int firstface, const list<string>& mtllibs);
+  void SetFaceArrays();
+  void ComputeBoundingBox();
 
   MSLPoint3d PointCurrentState(const MSLPoint3d& po, int mode);
 
@@ -0,0 +1,266 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <string.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <mutex>
+
+#include "msl/bundle.h"
+
+
+bool MSLBundle::Read(const string &fname) {
+  ifstream fin(fname.c_str(),ios::in|ios::binary);
+  const char *p,*end;
+  int version,count,len,i;
+  long long offset,size;
+
+  Data.clear();
+  Index.clear();
+  if (!fin)
+    return false;
+
+  fin.seekg(0,ios::end);
+  Data.resize((size_t) fin.tellg());
+  fin.seekg(0,ios::beg);
+  fin.read(&Data[0],Data.size());
+  if (!fin)
+    return false;
+
+  p = Data.data();
+  end = p + Data.size();
+  if ((Data.size() < 16) || (memcmp(p,MSL_BUNDLE_MAGIC,8) != 0))
+    return false;
+  memcpy(&version,p+8,sizeof(int));
+  memcpy(&count,p+12,sizeof(int));
+  if ((version != MSL_BUNDLE_VERSION) || (count < 0))
+    return false;
+  p += 16;
+
+  for (i = 0; i < count; i++) {
+    if (end - p < (long) sizeof(int))
+      return false;
+    memcpy(&len,p,sizeof(int));
+    p += sizeof(int);
+    if ((len < 0) || (end - p < len + 2 * (long) sizeof(long long)))
+      return false;
+    string name(p,len);
+    p += len;
+    memcpy(&offset,p,sizeof(long long));
+    memcpy(&size,p+sizeof(long long),sizeof(long long));
+    p += 2 * sizeof(long long);
+    if ((offset < 0) || (size < 0) ||
+	((size_t) (offset + size) > Data.size()))
+      return false;
+    Index[name] = make_pair((size_t) offset,(size_t) size);
+  }
+
+  return true;
+}
+
+
+
+bool MSLBundle::Contains(const string &name) const {
+  return Index.find(name) != Index.end();
+}
+
+
+
+bool MSLBundle::Find(const string &name, const char *&data,
+		     size_t &size) const {
+  unordered_map<string,pair<size_t,size_t> >::const_iterator i;
+
+  i = Index.find(name);
+  if (i == Index.end())
+    return false;
+
+  data = Data.data() + i->second.first;
+  size = i->second.second;
+  return true;
+}
+
+
+
+list<string> MSLBundle::Names() const {
+  unordered_map<string,pair<size_t,size_t> >::const_iterator i;
+  list<string> names;
+
+  for (i = Index.begin(); i != Index.end(); i++)
+    names.push_back(i->first);
+  names.sort();
+
+  return names;
+}
+
+
+
+void MSLBundle::Write(ostream &os,
+		      const vector<pair<string,string> > &entries) {
+  int version = MSL_BUNDLE_VERSION;
+  int count = entries.size();
+  long long offset,size;
+  int len;
+  size_t i;
+
+  // The contents start right after the index
+  offset = 16;
+  for (i = 0; i < entries.size(); i++)
+    offset += sizeof(int) + entries[i].first.size() + 2 * sizeof(long long);
+
+  os.write(MSL_BUNDLE_MAGIC,8);
+  os.write((const char*) &version,sizeof(int));
+  os.write((const char*) &count,sizeof(int));
+  for (i = 0; i < entries.size(); i++) {
+    len = entries[i].first.size();
+    size = entries[i].second.size();
+    os.write((const char*) &len,sizeof(int));
+    os.write(entries[i].first.data(),len);
+    os.write((const char*) &offset,sizeof(long long));
+    os.write((const char*) &size,sizeof(long long));
+    offset += size;
+  }
+  for (i = 0; i < entries.size(); i++)
+    os.write(entries[i].second.data(),entries[i].second.size());
+}
+
+
+
+// A directory's bundle (NULL if not valid), as loaded from a Bundle
+// file with that modification time, size and inode
+struct MSLBundleEntry {
+  const MSLBundle *Bundle;
+  long long MTime,Size,Inode;
+};
+
+typedef unordered_map<string,MSLBundleEntry> MSLBundleMap;
+
+static inline bool SameFile(const MSLBundleEntry &a,
+			    const MSLBundleEntry &b) {
+  return (a.MTime == b.MTime) && (a.Size == b.Size) && (a.Inode == b.Inode);
+}
+
+
+const MSLBundle* MSLBundle::ForDirectory(const string &dir) {
+  static mutex lock;
+  static atomic<const MSLBundleMap*> bundles(new MSLBundleMap());
+  const MSLBundleMap *m;
+  MSLBundleMap *nm;
+  MSLBundleMap::const_iterator i;
+  MSLBundleEntry e;
+  MSLBundle *b;
+  struct stat st;
+
+  // Most directories have none: a stat, and no lock
+  if (stat((dir + MSL_BUNDLE_FILE).c_str(),&st) != 0)
+    return NULL;
+  e.MTime = (long long) st.st_mtime;
+  e.Size = (long long) st.st_size;
+  e.Inode = (long long) st.st_ino;
+
+  m = bundles.load(memory_order_acquire);
+  i = m->find(dir);
+  if ((i != m->end()) && SameFile(i->second,e))
+    return i->second.Bundle;
+
+  // New or rebuilt since it was loaded.  Readers never lock: the map is
+  // replaced by a copy holding the new entry, and the old map and
+  // bundles are kept, since other threads may still be using them.
+  lock_guard<mutex> guard(lock);
+  m = bundles.load(memory_order_acquire);
+  i = m->find(dir);
+  if ((i != m->end()) && SameFile(i->second,e))
+    return i->second.Bundle;
+
+  b = new MSLBundle();
+  if (!b->Read(dir + MSL_BUNDLE_FILE)) {
+    delete b;
+    b = NULL;
+  }
+  e.Bundle = b;
+  nm = new MSLBundleMap(*m);
+  (*nm)[dir] = e;
+  bundles.store(nm,memory_order_release);
+
+  return b;
+}
+
+
+
+const MSLBundle* MSLBundle::ForFile(const string &fname, string &name) {
+  size_t slash;
+
+  slash = fname.rfind('/');
+  if (slash == string::npos) {
+    name = fname;
+    return ForDirectory("");
+  }
+
+  name = fname.substr(slash + 1);
+  return ForDirectory(fname.substr(0,slash + 1));
+}
+
+
+
+MSLProblemFile::MSLProblemFile():istream(NULL) {
+  Opened = false;
+  setstate(ios::failbit);
+}
+
+
+
+MSLProblemFile::MSLProblemFile(const string &fname):istream(NULL) {
+  Opened = false;
+  open(fname);
+}
+
+
+
+void MSLProblemFile::open(const string &fname) {
+  const MSLBundle *b;
+  const char *data;
+  size_t size;
+  string name;
+
+  close();
+
+  b = MSLBundle::ForFile(fname,name);
+  if (b) {
+    if (b->Find(name,data,size)) {
+      Memory.Set(data,size);
+      rdbuf(&Memory);
+      Opened = true;
+    }
+  }
+  else if (File.open(fname.c_str(),ios::in)) {
+    rdbuf(&File);
+    Opened = true;
+  }
+
+  if (!Opened)
+    setstate(ios::failbit);
+}
+
+
+
+void MSLProblemFile::close() {
+  if (File.is_open())
+    File.close();
+  rdbuf(NULL);
+  Opened = false;
+  clear(ios::failbit);
+}
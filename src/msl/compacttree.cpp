@@ -0,0 +1,247 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <math.h>
+#include <string.h>
+
+#include "msl/compacttree.h"
+
+
+// Signed values are zigzag encoded so that small steps either way
+// take few bytes
+static void PutVarint(vector<unsigned char> &b, long long v) {
+  unsigned long long z = ((unsigned long long) v << 1) ^ (v >> 63);
+
+  while (z >= 0x80) {
+    b.push_back((unsigned char) (z | 0x80));
+    z >>= 7;
+  }
+  b.push_back((unsigned char) z);
+}
+
+
+static long long GetVarint(const unsigned char *&p) {
+  unsigned long long z = 0;
+  int shift = 0;
+
+  while (*p & 0x80) {
+    z |= (unsigned long long) (*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  z |= (unsigned long long) (*p++) << shift;
+
+  return (long long) (z >> 1) ^ -(long long) (z & 1);
+}
+
+
+
+MSLCompactTree::MSLCompactTree(const MSLVector &lower,
+			       const MSLVector &upper,
+			       int bits, int keyframe) {
+  int i;
+
+  Dim = lower.dim();
+  Bits = (bits < 1) ? 1 : ((bits > 52) ? 52 : bits);
+  KeyframeInterval = (keyframe < 1) ? 1 : ((keyframe > 255) ? 255 : keyframe);
+
+  Lower = lower;
+  Step = MSLVector(Dim);
+  IndexStep = MSLVector(Dim);
+  for (i = 0; i < Dim; i++) {
+    Step[i] = (upper[i] - lower[i]) / ldexp(1.0,Bits);
+    IndexStep[i] = (upper[i] - lower[i]) / 65535.0;
+    if (Step[i] <= 0.0)
+      Step[i] = IndexStep[i] = 1.0;
+  }
+}
+
+
+
+void MSLCompactTree::Clear() {
+  Parents.clear();
+  Times.clear();
+  Inputs.clear();
+  Hops.clear();
+  Offsets.clear();
+  Bytes.clear();
+  Index.clear();
+  InputTable.clear();
+  InputIds.clear();
+}
+
+
+
+int MSLCompactTree::InputID(const MSLVector &u) {
+  unordered_map<string,int>::iterator i;
+  string key;
+  double v;
+  int j;
+
+  for (j = 0; j < u.dim(); j++) {
+    v = u[j];
+    key.append((const char*) &v,sizeof(double));
+  }
+
+  i = InputIds.find(key);
+  if (i != InputIds.end())
+    return i->second;
+
+  InputTable.push_back(u);
+  InputIds[key] = InputTable.size() - 1;
+  return InputTable.size() - 1;
+}
+
+
+
+void MSLCompactTree::Quantized(int n, vector<long long> &q) const {
+  const unsigned char *p;
+  vector<int> chain;
+  int i,j;
+
+  // Collect the nodes back to the keyframe, then add up their steps
+  chain.push_back(n);
+  while (Hops[n] > 0) {
+    n = Parents[n];
+    chain.push_back(n);
+  }
+
+  q.assign(Dim,0);
+  for (j = chain.size() - 1; j >= 0; j--) {
+    p = &Bytes[Offsets[chain[j]]];
+    for (i = 0; i < Dim; i++)
+      q[i] += GetVarint(p);
+  }
+}
+
+
+
+int MSLCompactTree::MakeRoot(const MSLVector &x) {
+  Clear();
+  Extend(-1,x,MSLVector(),0.0);
+  return 0;
+}
+
+
+
+int MSLCompactTree::Extend(int parent, const MSLVector &x,
+			   const MSLVector &u, double t) {
+  vector<long long> pq;
+  long long q;
+  double v;
+  int i,hops;
+
+  if ((parent < 0) || (Hops[parent] + 1 >= KeyframeInterval)) {
+    hops = 0;
+    pq.assign(Dim,0);
+  }
+  else {
+    hops = Hops[parent] + 1;
+    Quantized(parent,pq);
+  }
+
+  Parents.push_back(parent);
+  Times.push_back((float) t);
+  Inputs.push_back(InputID(u));
+  Hops.push_back((unsigned char) hops);
+  Offsets.push_back(Bytes.size());
+  for (i = 0; i < Dim; i++) {
+    q = llround((x[i] - Lower[i]) / Step[i]);
+    PutVarint(Bytes,q - pq[i]);
+
+    v = floor((x[i] - Lower[i]) / IndexStep[i] + 0.5);
+    Index.push_back((unsigned short) ((v < 0.0) ? 0.0 :
+				      ((v > 65535.0) ? 65535.0 : v)));
+  }
+
+  return Parents.size() - 1;
+}
+
+
+
+MSLVector MSLCompactTree::State(int n) const {
+  vector<long long> q;
+  MSLVector x(Dim);
+  int i;
+
+  Quantized(n,q);
+  for (i = 0; i < Dim; i++)
+    x[i] = Lower[i] + q[i] * Step[i];
+
+  return x;
+}
+
+
+
+void MSLCompactTree::IndexState(int n, MSLVector &x) const {
+  const unsigned short *s = &Index[(size_t) n * Dim];
+  int i;
+
+  for (i = 0; i < Dim; i++)
+    x[i] = Lower[i] + s[i] * IndexStep[i];
+}
+
+
+
+list<int> MSLCompactTree::PathToRoot(int n) const {
+  list<int> path;
+
+  while (n >= 0) {
+    path.push_back(n);
+    n = Parents[n];
+  }
+
+  return path;
+}
+
+
+
+size_t MSLCompactTree::MemoryUsage() const {
+  size_t m;
+  int i;
+
+  m = Parents.capacity() * sizeof(int) +
+    Times.capacity() * sizeof(float) +
+    Inputs.capacity() * sizeof(int) +
+    Hops.capacity() +
+    Offsets.capacity() * sizeof(size_t) +
+    Bytes.capacity() +
+    Index.capacity() * sizeof(unsigned short);
+  for (i = 0; i < (int) InputTable.size(); i++)
+    m += sizeof(MSLVector) + InputTable[i].dim() * sizeof(double);
+
+  return m;
+}
+
+
+
+MSLTree* MSLCompactTree::MakeTree() const {
+  vector<MSLNode*> nodes;
+  MSLTree *t;
+  int n;
+
+  t = new MSLTree();
+  if (Size() == 0)
+    return t;
+
+  t->MakeRoot(State(0));
+  nodes.push_back(t->Root());
+  for (n = 1; n < Size(); n++)
+    nodes.push_back(t->Extend(nodes[Parents[n]],State(n),Input(n),Time(n)));
+
+  return t;
+}
@@ -18,6 +18,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <thread>
 
 #include "msl/fdp.h"
 
@@ -54,7 +55,7 @@ void FDP::Reset() {
   for (i = 0; i < P->StateDim; i++)
     GridDimensions[i] = GridDefaultResolution;
   if (is_file(P->FilePath + "GridDimensions")) {
-    ifstream fin((P->FilePath + "GridDimensions").c_str());
+    MSLProblemFile fin(P->FilePath + "GridDimensions");
     for (i = 0; i < P->StateDim; i++) {
       fin >> dim;
       GridDimensions[i] = dim;
@@ -83,10 +84,10 @@ void FDP::Reset() {
 
   // Loop through all of the indices and check each for collision
   cout << "Performing collision detection to initialize grid.\n";
-  done = false;
+  done = !Grid->Allocated();
   while (!done) {
     (*Grid)[indices] =
-      (P->Satisfied(IndicesToState(indices))) ? UNVISITED : COLLISION;
+      (Satisfied(IndicesToState(indices))) ? UNVISITED : COLLISION;
     done = Grid->Increment(indices); // This modifies indices
   }
   cout << "Finished.\n";
@@ -94,6 +95,17 @@ void FDP::Reset() {
 
 
 
+void FDP::MemoryItems(list<MSLMemoryItem> &ml) {
+  MSLMemoryItem m;
+
+  IncrementalPlanner::MemoryItems(ml);
+  m = {"grid",Grid->MemoryUsage(),Grid->MemoryUsage(),
+       Grid->Allocated() ? Grid->NumElements() : 0};
+  ml.push_back(m);
+}
+
+
+
 bool FDP::Plan()
 {
   int i;
@@ -106,6 +118,17 @@ bool FDP::Plan()
   list<MSLVector>::iterator u;
   list<MSLNode*>::iterator ni;
   list<MSLVector> ulist;
+  long long start = 0;
+  int children,collisions;
+
+  float t = used_time();
+
+  // The grid did not fit (see MultiArray::MaxSize)
+  if (!Grid->Allocated()) {
+    MemoryExceeded = true;
+    CumulativePlanningTime += ((double)used_time(t));
+    return false;
+  }
 
   // Make the root node of G
   if (!T) {
@@ -116,7 +139,7 @@ bool FDP::Plan()
 
   i = 0;
   while ((i < NumNodes)&&
-	 (!Q.empty())) {
+	 (!Q.empty())&&(!Interrupted())) {
 
     // Remove the element with smallest cost
     n = Q.top();
@@ -125,15 +148,24 @@ bool FDP::Plan()
     x = n->State();
 
     // Try all inputs
+    if (Trace)
+      start = MSLTrace::Now();
+    children = collisions = 0;
     ulist = P->GetInputs(x);
     forall(u,ulist) {
-      nx = P->Integrate(x,*u,PlannerDeltaT);
+      nx = Integrate(x,*u,PlannerDeltaT);
       indices = StateToIndices(nx);
+      if ((*Grid)[indices] == COLLISION)
+	collisions++;
       // If we are visiting an UNVISITED place...
       if ((*Grid)[indices] == UNVISITED) {
 	(*Grid)[indices] = VISITED;
+	children++;
 	// Make a new node and edge
-	nn = T->Extend(n,nx,*u,PlannerDeltaT); // Make a new node with state nx
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T->Extend(n,nx,*u,PlannerDeltaT);
+	}
 	nn->SetCost(SearchCost(cost,n,nn));
 	Q.push(nn); // Put it into the priority queue
 	//cout << "New node: " << nn->State() << "  " << nn->Cost() << "\n";
@@ -150,15 +182,24 @@ bool FDP::Plan()
 	  }
 
 	  RecordSolution(path); // Write to Path and Policy
+	  CumulativePlanningTime += ((double)used_time(t));
 	  return true;
 	}
       }
     }
 
+    if (Trace)
+      Trace->Add(MSL_TRACE_EXPAND,start,
+		 (children > 0) ? MSL_TRACE_OK : ((collisions > 0) ?
+		   MSL_TRACE_COLLISION : MSL_TRACE_VISITED),
+		 n->ID(),-1,children,x);
+
     i++;
+    PublishSnapshot();
   }
 
   cout << "Failure to find a path\n";
+  CumulativePlanningTime += ((double)used_time(t));
   return false;
 }
 
@@ -244,6 +285,250 @@ double FDPBestFirst::SearchCost(double initcost, MSLNode* &n,
 
 
 
+// *********************************************************************
+// *********************************************************************
+// CLASS:     FDPParallel
+//
+// All nodes of equal cost are expanded together, with the bucket
+// split among several threads.  Grid cells are claimed atomically.
+// *********************************************************************
+// *********************************************************************
+
+FDPParallel::FDPParallel(Problem *problem): FDP(problem) {
+  READ_PARAMETER_OR_DEFAULT(NumThreads,(int) thread::hardware_concurrency());
+  if (NumThreads < 1)
+    NumThreads = 1;
+}
+
+
+
+void FDPParallel::ExpandBucket(const vector<MSLNode*> &bucket,
+			       int first, int last, vector<Claim> &claims)
+{
+  int k,seen,prev;
+  Claim c;
+  MSLVector x;
+  list<MSLVector>::iterator u;
+  list<MSLVector> ulist;
+
+  for (k = first; k < last; k++) {
+    x = bucket[k]->State();
+    c.Mark = -(k+1);  // Earlier nodes have larger marks
+    ulist = P->GetInputs(x);
+    forall(u,ulist) {
+      c.State = Integrate(x,*u,PlannerDeltaT);
+      c.Indices = StateToIndices(c.State);
+      // Take the cell if it is unvisited, or marked by a later node
+      seen = UNVISITED;
+      while ((seen == UNVISITED)||(seen < c.Mark)) {
+	prev = Grid->CompareAndSwap(c.Indices,seen,c.Mark);
+	if (prev == seen) {
+	  c.Parent = bucket[k];
+	  c.Input = *u;
+	  claims.push_back(c);
+	  break;
+	}
+	seen = prev;
+      }
+    }
+  }
+}
+
+
+
+void FDPParallel::Worker(int k)
+{
+  long round = 0;
+  int first,last,size;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(PoolLock);
+      PoolWake.wait(lock,[&]{return PoolStopping || (PoolRound != round);});
+      if (PoolStopping)
+	return;
+      round = PoolRound;
+    }
+
+    // Workers past the last chunk of a small bucket have nothing to do
+    size = PoolBucket->size();
+    first = min(k*PoolChunk,size);
+    last = min((k+1)*PoolChunk,size);
+    if (first < last)
+      ExpandBucket(*PoolBucket,first,last,(*PoolClaims)[k]);
+
+    {
+      std::lock_guard<std::mutex> guard(PoolLock);
+      if (--PoolPending == 0)
+	PoolDone.notify_one();
+    }
+  }
+}
+
+
+
+void FDPParallel::StartWorkers()
+{
+  int k;
+
+  PoolRound = 0;
+  PoolPending = 0;
+  PoolStopping = false;
+  Workers.clear();
+  for (k = 1; k < NumThreads; k++)
+    Workers.push_back(thread(&FDPParallel::Worker,this,k));
+}
+
+
+
+void FDPParallel::ExpandWithWorkers(const vector<MSLNode*> &bucket,
+				    int chunk, vector<vector<Claim> > &claims)
+{
+  {
+    std::lock_guard<std::mutex> guard(PoolLock);
+    PoolBucket = &bucket;
+    PoolChunk = chunk;
+    PoolClaims = &claims;
+    PoolPending = Workers.size();
+    PoolRound++;
+  }
+  PoolWake.notify_all();
+
+  ExpandBucket(bucket,0,min(chunk,(int) bucket.size()),claims[0]);
+
+  std::unique_lock<std::mutex> lock(PoolLock);
+  PoolDone.wait(lock,[&]{return PoolPending == 0;});
+}
+
+
+
+void FDPParallel::StopWorkers()
+{
+  int k;
+
+  {
+    std::lock_guard<std::mutex> guard(PoolLock);
+    PoolStopping = true;
+  }
+  PoolWake.notify_all();
+  for (k = 0; k < (int) Workers.size(); k++)
+    Workers[k].join();
+  Workers.clear();
+}
+
+
+
+bool FDPParallel::Plan()
+{
+  int i,k,nthreads,chunk,size;
+  MSLNode *n,*nn;
+  double ptime,cost;
+  list<MSLNode*> path;
+  list<MSLNode*>::iterator ni;
+  vector<MSLNode*> bucket;
+  vector<vector<Claim> > claims;
+  vector<Claim>::iterator c;
+
+  // Keep track of time (processor time of all the threads)
+  float t = used_time();
+
+  // The grid did not fit (see MultiArray::MaxSize)
+  if (!Grid->Allocated()) {
+    MemoryExceeded = true;
+    CumulativePlanningTime += ((double)used_time(t));
+    return false;
+  }
+
+  // Make the root node of G
+  if (!T) {
+    T = new MSLTree(P->InitialState);
+    T->Root()->SetCost(0.0);
+    Q.push(T->Root());  // Add the root node to the queue
+  }
+
+  // One set of threads serves every bucket of this call
+  StartWorkers();
+
+  i = 0;
+  while ((i < NumNodes)&&
+	 (!Q.empty())&&(!Interrupted())) {
+
+    // Remove every element in the bucket of smallest cost
+    bucket.clear();
+    cost = Q.top()->Cost();
+    while ((!Q.empty())&&
+	   (Q.top()->Cost() < cost + 0.5*PlannerDeltaT)&&
+	   (i < NumNodes)) {
+      bucket.push_back(Q.top());
+      Q.pop();
+      i++;
+    }
+
+    // Split the bucket into one chunk per thread (small buckets are
+    // not worth waking the workers)
+    size = bucket.size();
+    nthreads = (size + 15)/16;
+    if (nthreads > NumThreads)
+      nthreads = NumThreads;
+    chunk = (size + nthreads - 1)/nthreads;
+
+    claims.assign(NumThreads,vector<Claim>());
+    if (nthreads > 1)
+      ExpandWithWorkers(bucket,chunk,claims);
+    else
+      ExpandBucket(bucket,0,size,claims[0]);
+
+    // Make the new nodes, in bucket order, for the claims that held
+    for (k = 0; k < NumThreads; k++) {
+      for (c = claims[k].begin(); c != claims[k].end(); c++) {
+	if ((*Grid)[c->Indices] != c->Mark)
+	  continue;
+	(*Grid)[c->Indices] = VISITED;
+	n = c->Parent;
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T->Extend(n,c->State,c->Input,PlannerDeltaT);
+	}
+	nn->SetCost(SearchCost(n->Cost(),n,nn));
+	Q.push(nn); // Put it into the priority queue
+
+	// Check if goal reached
+	if (GapSatisfied(nn->State(),P->GoalState)) {
+	  cout << "Successful Path Found\n";
+	  path = T->PathToRoot(nn); path.reverse();
+	  // Make the correct times
+	  ptime = 0.0; TimeList.clear();
+	  forall(ni,path) {
+	    ptime += (*ni)->Time();
+	    TimeList.push_back(ptime);
+	  }
+
+	  RecordSolution(path); // Write to Path and Policy
+
+	  // Free the cells still claimed by the rest of the bucket, so
+	  // that a later Plan can reach them
+	  for (k = 0; k < NumThreads; k++)
+	    for (c = claims[k].begin(); c != claims[k].end(); c++)
+	      if ((*Grid)[c->Indices] == c->Mark)
+		(*Grid)[c->Indices] = UNVISITED;
+	  StopWorkers();
+	  CumulativePlanningTime += ((double)used_time(t));
+	  return true;
+	}
+      }
+    }
+    PublishSnapshot();
+  }
+
+  StopWorkers();
+  cout << "Failure to find a path\n";
+  CumulativePlanningTime += ((double)used_time(t));
+  return false;
+}
+
+
+
+
 // *********************************************************************
 // *********************************************************************
 // CLASS:     FDPBi
@@ -276,6 +561,15 @@ bool FDPBi::Plan()
   list<MSLNode*>::iterator ni;
   list<MSLVector> ulist;
 
+  float t = used_time();
+
+  // The grid did not fit (see MultiArray::MaxSize)
+  if (!Grid->Allocated()) {
+    MemoryExceeded = true;
+    CumulativePlanningTime += ((double)used_time(t));
+    return false;
+  }
+
   // Make the root node of T
   if (!T) {
     T = new MSLTree(P->InitialState);
@@ -293,7 +587,7 @@ bool FDPBi::Plan()
   i = 0;
   while ((i < NumNodes)&&
 	 (!Q.empty())&&
-	 (!Q2.empty())) {
+	 (!Q2.empty())&&(!Interrupted())) {
 
     // ******** Handle the tree from the initial state *************
     // Remove the element with smallest cost
@@ -305,13 +599,16 @@ bool FDPBi::Plan()
     // Try all inputs
     ulist = P->GetInputs(x);
     forall(u,ulist) {
-      nx = P->Integrate(x,*u,PlannerDeltaT);
+      nx = Integrate(x,*u,PlannerDeltaT);
       indices = StateToIndices(nx);
 
       // If we are visiting a place visited by T2...
       if ((*Grid)[indices] == VISITED2) {
 	// Make a new node and edge
-	nn = T->Extend(n,nx,*u,PlannerDeltaT); // Make a new node with state nx
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T->Extend(n,nx,*u,PlannerDeltaT);
+	}
 	nn->SetCost(SearchCost(cost,n,nn));
 
 	// Get the node in T2 that was visited
@@ -327,6 +624,7 @@ bool FDPBi::Plan()
 	}
 	RecoverSolution(nn,nn2);
 	cout << "Successful Path Found\n";
+	CumulativePlanningTime += ((double)used_time(t));
 	return true;
       }
 
@@ -334,7 +632,10 @@ bool FDPBi::Plan()
       if ((*Grid)[indices] == UNVISITED) {
 	(*Grid)[indices] = VISITED;
 	// Make a new node and edge
-	nn = T->Extend(n,nx,*u,PlannerDeltaT); // Make a new node with state nx
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T->Extend(n,nx,*u,PlannerDeltaT);
+	}
 	nn->SetCost(SearchCost(cost,n,nn));
 	Q.push(nn); // Put it into the priority queue
 
@@ -350,6 +651,7 @@ bool FDPBi::Plan()
 	  }
 
 	  RecordSolution(path); // Write to Path and Policy
+	  CumulativePlanningTime += ((double)used_time(t));
 	  return true;
 	}
       }
@@ -365,13 +667,16 @@ bool FDPBi::Plan()
     // Try all inputs
     ulist = P->GetInputs(x);
     forall(u,ulist) {
-      nx = P->Integrate(x,*u,-PlannerDeltaT);  // Reverse time integration
+      nx = Integrate(x,*u,-PlannerDeltaT);  // Reverse time integration
       indices = StateToIndices(nx);
 
       // If we are visiting a place visited by T...
       if ((*Grid)[indices] == VISITED) {
 	// Make a new node and edge
-	nn = T2->Extend(n,nx,*u,PlannerDeltaT); // Make new node with state nx
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T2->Extend(n,nx,*u,PlannerDeltaT);
+	}
 	nn->SetCost(SearchCost(cost,n,nn));
 
 	// Get the node in T that was visited
@@ -387,6 +692,7 @@ bool FDPBi::Plan()
 	}
 	RecoverSolution(nn2,nn);
 	cout << "Successful Path Found\n";
+	CumulativePlanningTime += ((double)used_time(t));
 	return true;
       }
 
@@ -394,7 +700,10 @@ bool FDPBi::Plan()
       if ((*Grid)[indices] == UNVISITED) {
 	(*Grid)[indices] = VISITED2;
 	// Make a new node and edge
-	nn = T2->Extend(n,nx,*u,PlannerDeltaT); // Make new node with state nx
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  nn = T2->Extend(n,nx,*u,PlannerDeltaT);
+	}
 	nn->SetCost(SearchCost(cost,n,nn));
 	Q2.push(nn); // Put it into the priority queue
 
@@ -410,15 +719,18 @@ bool FDPBi::Plan()
 	  }
 
 	  RecordSolution(path); // Write to Path and Policy
+	  CumulativePlanningTime += ((double)used_time(t));
 	  return true;
 	}
       }
     }
 
     i++;
+    PublishSnapshot();
   }
 
   cout << "Failure to find a path\n";
+  CumulativePlanningTime += ((double)used_time(t));
   return false;
 }
 
@@ -18,8 +18,12 @@
 
 //#include <fstream.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sstream>
 
 #include "msl/geom_pqp.h"
+#include "msl/util.h"
 
 // Define some useless stream defaults
 istream& operator>> (istream& is, PQP_Model& p) {
@@ -51,21 +55,105 @@ GeomPQP::GeomPQP(string path = ""):Geom(path) {
   RO[0][1]=RO[0][2]=RO[1][0]= RO[1][2]= RO[2][0]= RO[2][1]=0.0;
 
   NumBodies = 1; // Default
+
+  CollisionCache = "";
+  if (is_file(FilePath + "CollisionCache")) {
+    READ_OPTIONAL_PARAMETER(CollisionCache);
+    if (CollisionCache == "")
+      CollisionCache = FilePath;
+    else if (CollisionCache[CollisionCache.length()-1] != '/')
+      CollisionCache += "/";
+  }
 }
 
 
 
+// 64-bit FNV-1a
+static unsigned long long HashBytes(const string &s,
+				    unsigned long long h = 14695981039346656037ULL)
+{
+  size_t i;
+
+  for (i = 0; i < s.size(); i++) {
+    h ^= (unsigned char) s[i];
+    h *= 1099511628211ULL;
+  }
+
+  return h;
+}
+
 
-void GeomPQP::LoadEnvironment(string path){
 
-  READ_OPTIONAL_PARAMETER(Obst);
+// The header of a cached model; the sizes guard against another PQP build
+struct MSLPQPCacheHeader {
+  char Magic[8];
+  int Version;
+  int RealSize;
+  int TriSize;
+  int BVSize;
+  unsigned long long Key;
+  unsigned long long SourceSize;
+  int NumTris;
+  int NumBVs;
+};
 
-  int i=0;
+
+
+static string CacheFileName(const string &dir, unsigned long long key) {
+  char s[20];
+
+  sprintf(s,"%016llx",key);
+  return dir + s + ".pqp";
+}
+
+
+
+void GeomPQP::MakeModel(const string &fname, list<MSLPolygon> *polygons,
+			double tolerance, list<MSLTriangle> &tl,
+			PQP_Model &m) {
+  MSLProblemFile fin(fname);
+  ostringstream text;
+  unsigned long long key;
+  string src;
+  int i;
+
+  if (fin)
+    text << fin.rdbuf();
+  src = text.str();
+  istringstream is(src);
+
+  tl.clear();
+  if (polygons)
+    is >> *polygons;
+
+  // The triangulation tolerance is part of what was built
+  key = HashBytes(src);
+  if (polygons) {
+    ostringstream tol;
+    tol << "/" << tolerance;
+    key = HashBytes(tol.str(),key);
+  }
+
+  if ((CollisionCache != "") && (src.size() > 0) &&
+      ReadCachedModel(key,src.size(),tl,m))
+    return;
+
+  if (!polygons)
+    is >> tl;
+  else {
+    fin.open(fname + "Triangles");
+    if (fin)
+      fin >> tl;
+    else
+      tl = PolygonsToTriangles(*polygons,tolerance);
+  }
+
+  i = 0;
   list<MSLTriangle>::iterator t;
 
-  Ob.BeginModel();
+  m.BeginModel();
   PQP_REAL p1[3],p2[3],p3[3];
-  forall(t,Obst) {
+  forall(t,tl) {
     p1[0] = (PQP_REAL) t->p1.xcoord();
     p1[1] = (PQP_REAL) t->p1.ycoord();
     p1[2] = (PQP_REAL) t->p1.zcoord();
@@ -75,37 +163,137 @@ void GeomPQP::LoadEnvironment(string path){
     p3[0] = (PQP_REAL) t->p3.xcoord();
     p3[1] = (PQP_REAL) t->p3.ycoord();
     p3[2] = (PQP_REAL) t->p3.zcoord();
-    Ob.AddTri(p1,p2,p3,i);
+    m.AddTri(p1,p2,p3,i);
     i++;
   }
-  Ob.EndModel();
+  m.EndModel();
+
+  if ((CollisionCache != "") && (src.size() > 0))
+    WriteCachedModel(key,src.size(),m);
 }
 
 
 
-void GeomPQP::LoadRobot(string path){
+bool GeomPQP::ReadCachedModel(unsigned long long key, size_t srcsize,
+			      list<MSLTriangle> &tl, PQP_Model &m) {
+  ifstream fin(CacheFileName(CollisionCache,key).c_str(),
+	       ios::in|ios::binary);
+  MSLPQPCacheHeader h;
+  vector<Tri*> byid;
+  Tri *tris;
+  BV *bvs;
+  int i;
 
-  READ_OPTIONAL_PARAMETER(Robot);
+  if (!fin)
+    return false;
+
+  fin.read((char*) &h,sizeof(h));
+  if ((!fin) || (memcmp(h.Magic,MSL_PQP_CACHE_MAGIC,8) != 0) ||
+      (h.Version != MSL_PQP_CACHE_VERSION) ||
+      (h.RealSize != (int) sizeof(PQP_REAL)) ||
+      (h.TriSize != (int) sizeof(Tri)) || (h.BVSize != (int) sizeof(BV)) ||
+      (h.Key != key) || (h.SourceSize != srcsize) ||
+      (h.NumTris < 0) || (h.NumBVs < 0))
+    return false;
+
+  tris = new Tri[h.NumTris > 0 ? h.NumTris : 1];
+  bvs = new BV[h.NumBVs > 0 ? h.NumBVs : 1];
+  fin.read((char*) tris,h.NumTris * sizeof(Tri));
+  fin.read((char*) bvs,h.NumBVs * sizeof(BV));
+  if (!fin) {
+    delete [] tris;
+    delete [] bvs;
+    return false;
+  }
 
-  int i=0;
-  list<MSLTriangle>::iterator t;
+  // Put a built model in place of whatever m held
+  m.BeginModel();
+  delete [] m.tris;
+  m.tris = tris;
+  m.num_tris = m.num_tris_alloced = h.NumTris;
+  m.b = bvs;
+  m.num_bvs = m.num_bvs_alloced = h.NumBVs;
+  m.last_tri = tris;
+  m.build_state = PQP_BUILD_STATE_PROCESSED;
+
+  // PQP reorders the triangles; the ids give back the file order
+  byid.assign(h.NumTris,(Tri*) NULL);
+  for (i = 0; i < h.NumTris; i++)
+    if ((tris[i].id >= 0) && (tris[i].id < h.NumTris))
+      byid[tris[i].id] = &tris[i];
+  for (i = 0; i < h.NumTris; i++)
+    if (byid[i])
+      tl.push_back(MSLTriangle(
+	MSLPoint3d(byid[i]->p1[0],byid[i]->p1[1],byid[i]->p1[2]),
+	MSLPoint3d(byid[i]->p2[0],byid[i]->p2[1],byid[i]->p2[2]),
+	MSLPoint3d(byid[i]->p3[0],byid[i]->p3[1],byid[i]->p3[2])));
 
-  Ro.BeginModel();
-  PQP_REAL p1[3],p2[3],p3[3];
-  forall(t,Robot){
-    p1[0] = (PQP_REAL) t->p1.xcoord();
-    p1[1] = (PQP_REAL) t->p1.ycoord();
-    p1[2] = (PQP_REAL) t->p1.zcoord();
-    p2[0] = (PQP_REAL) t->p2.xcoord();
-    p2[1] = (PQP_REAL) t->p2.ycoord();
-    p2[2] = (PQP_REAL) t->p2.zcoord();
-    p3[0] = (PQP_REAL) t->p3.xcoord();
-    p3[1] = (PQP_REAL) t->p3.ycoord();
-    p3[2] = (PQP_REAL) t->p3.zcoord();
-    Ro.AddTri(p1,p2,p3,i);
-    i++;
+  return true;
+}
+
+
+
+void GeomPQP::WriteCachedModel(unsigned long long key, size_t srcsize,
+			       const PQP_Model &m) {
+  string fname,tmp;
+  MSLPQPCacheHeader h;
+  char s[30];
+
+  if (m.build_state != PQP_BUILD_STATE_PROCESSED)
+    return;
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.Magic,MSL_PQP_CACHE_MAGIC,sizeof(MSL_PQP_CACHE_MAGIC));
+  h.Version = MSL_PQP_CACHE_VERSION;
+  h.RealSize = sizeof(PQP_REAL);
+  h.TriSize = sizeof(Tri);
+  h.BVSize = sizeof(BV);
+  h.Key = key;
+  h.SourceSize = srcsize;
+  h.NumTris = m.num_tris;
+  h.NumBVs = m.num_bvs;
+
+  // Write to a private name and rename, so that a concurrent reader
+  // never sees a partial file
+  fname = CacheFileName(CollisionCache,key);
+  sprintf(s,".%d",(int) getpid());
+  tmp = fname + s;
+  ofstream fout(tmp.c_str(),ios::out|ios::binary);
+  fout.write((const char*) &h,sizeof(h));
+  fout.write((const char*) m.tris,m.num_tris * sizeof(Tri));
+  fout.write((const char*) m.b,m.num_bvs * sizeof(BV));
+  fout.close();
+  if (!fout || (rename(tmp.c_str(),fname.c_str()) != 0)) {
+    cout << "Could not write the collision model cache " << fname << "\n";
+    remove(tmp.c_str());
   }
-  Ro.EndModel();
+}
+
+
+
+
+void GeomPQP::LoadEnvironment(string path){
+  MakeModel(FilePath+"Obst",NULL,0.0,Obst,Ob);
+}
+
+
+
+void GeomPQP::LoadRobot(string path){
+  MakeModel(FilePath+"Robot",NULL,0.0,Robot,Ro);
+}
+
+
+
+// The bytes of a triangle list and of the PQP model built from it
+static size_t ModelBytes(const list<MSLTriangle> &tl, PQP_Model &m) {
+  return tl.size()*(sizeof(MSLTriangle) + 2*sizeof(void*)) + 
+    m.MemUsage(0);
+}
+
+
+
+size_t GeomPQP::MemoryUsage() {
+  return ModelBytes(Obst,Ob) + ModelBytes(Robot,Ro);
 }
 
 
@@ -126,36 +314,8 @@ GeomPQP2D::GeomPQP2D(string path = ""):GeomPQP(path) {
 
 void GeomPQP2D::LoadEnvironment(string path)
 {
-  std::ifstream fin;
-
-  Obst.clear();
-  fin.open((FilePath+"Obst").c_str());
-  if (fin) {
-    fin >> ObstPolygons;
-    // Make triangles to store in Obst
-    Obst = PolygonsToTriangles(ObstPolygons,3.0);
-  }
-  fin.close();
-
-  int i=0;
-  list<MSLTriangle>::iterator t;
-
-  Ob.BeginModel();
-  PQP_REAL p1[3],p2[3],p3[3];
-  forall(t,Obst) {
-    p1[0] = (PQP_REAL) t->p1.xcoord();
-    p1[1] = (PQP_REAL) t->p1.ycoord();
-    p1[2] = (PQP_REAL) t->p1.zcoord();
-    p2[0] = (PQP_REAL) t->p2.xcoord();
-    p2[1] = (PQP_REAL) t->p2.ycoord();
-    p2[2] = (PQP_REAL) t->p2.zcoord();
-    p3[0] = (PQP_REAL) t->p3.xcoord();
-    p3[1] = (PQP_REAL) t->p3.ycoord();
-    p3[2] = (PQP_REAL) t->p3.zcoord();
-    Ob.AddTri(p1,p2,p3,i);
-    i++;
-  }
-  Ob.EndModel();
+  ObstPolygons.clear();
+  MakeModel(FilePath+"Obst",&ObstPolygons,3.0,Obst,Ob);
 
   //cout << "Obstacle region:\n" << ObstPolygons << "\n";
   //cout << "Number of polygons: " << ObstPolygons.size() << "\n";
@@ -164,36 +324,8 @@ void GeomPQP2D::LoadEnvironment(string path)
 
 
 void GeomPQP2D::LoadRobot(string path){
-  std::ifstream fin;
-
-  Robot.clear();
-  fin.open((FilePath+"Robot").c_str());
-  if (fin) {
-    fin >> RobotPolygons;
-    // Make triangles to store in Robot
-    Robot = PolygonsToTriangles(RobotPolygons,3.0);
-  }
-  fin.close();
-
-  int i=0;
-  list<MSLTriangle>::iterator t;
-
-  Ro.BeginModel();
-  PQP_REAL p1[3],p2[3],p3[3];
-  forall(t,Robot){
-    p1[0] = (PQP_REAL) t->p1.xcoord();
-    p1[1] = (PQP_REAL) t->p1.ycoord();
-    p1[2] = (PQP_REAL) t->p1.zcoord();
-    p2[0] = (PQP_REAL) t->p2.xcoord();
-    p2[1] = (PQP_REAL) t->p2.ycoord();
-    p2[2] = (PQP_REAL) t->p2.zcoord();
-    p3[0] = (PQP_REAL) t->p3.xcoord();
-    p3[1] = (PQP_REAL) t->p3.ycoord();
-    p3[2] = (PQP_REAL) t->p3.zcoord();
-    Ro.AddTri(p1,p2,p3,i);
-    i++;
-  }
-  Ro.EndModel();
+  RobotPolygons.clear();
+  MakeModel(FilePath+"Robot",&RobotPolygons,3.0,Robot,Ro);
 }
 
 
@@ -230,32 +362,39 @@ GeomPQP2DRigid::GeomPQP2DRigid(string path = ""):GeomPQP2D(path) {
 
 
 void GeomPQP2DRigid::SetTransformation(const MSLVector &q){
+  SetTransformation(q,RR,TR);
+}
+
+
+void GeomPQP2DRigid::SetTransformation(const MSLVector &q, PQP_REAL rr[3][3],
+				 PQP_REAL tr[3]){
 
   // Set translation
-  TR[0] = (PQP_REAL)q[0];
-  TR[1] = (PQP_REAL)q[1];
-  TR[2] = 0.0;
+  tr[0] = (PQP_REAL)q[0];
+  tr[1] = (PQP_REAL)q[1];
+  tr[2] = 0.0;
 
   // Set yaw rotation
-  RR[0][0] = (PQP_REAL)(cos(q[2]));
-  RR[0][1] = (PQP_REAL)(-sin(q[2]));
-  RR[0][2] = 0.0;
-  RR[1][0] = (PQP_REAL)(sin(q[2]));
-  RR[1][1] = (PQP_REAL)(cos(q[2]));
-  RR[1][2] = 0.0;
-  RR[2][0] = 0.0;
-  RR[2][1] = 0.0;
-  RR[2][2] = 1.0;
+  rr[0][0] = (PQP_REAL)(cos(q[2]));
+  rr[0][1] = (PQP_REAL)(-sin(q[2]));
+  rr[0][2] = 0.0;
+  rr[1][0] = (PQP_REAL)(sin(q[2]));
+  rr[1][1] = (PQP_REAL)(cos(q[2]));
+  rr[1][2] = 0.0;
+  rr[2][0] = 0.0;
+  rr[2][1] = 0.0;
+  rr[2][2] = 1.0;
 
 }
 
 
 bool GeomPQP2DRigid::CollisionFree(const MSLVector &q){
+  PQP_REAL rr[3][3],tr[3];
 
-  SetTransformation(q);
+  SetTransformation(q,rr,tr);
 
   PQP_CollideResult cres;
-  PQP_Collide(&cres,RR,TR,&Ro,RO,TO,&Ob,PQP_FIRST_CONTACT);
+  PQP_Collide(&cres,rr,tr,&Ro,RO,TO,&Ob,PQP_FIRST_CONTACT);
 
   return (cres.NumPairs() == 0);
 }
@@ -315,7 +454,7 @@ GeomPQP2DRigidMulti::GeomPQP2DRigidMulti(string path = ""):GeomPQP2DRigid(path)
 
 
 void GeomPQP2DRigidMulti::LoadRobot(string path) {
-  int i,j;
+  int i;
   string fname;
   list<MSLPolygon> pl;
 
@@ -338,46 +477,36 @@ void GeomPQP2DRigidMulti::LoadRobot(string path) {
   Ro = vector<PQP_Model>(NumBodies);
 
   for (i = 0; i < NumBodies; i++) {
-
     sprintf(s,"%sRobot%d",FilePath.c_str(),i);
-    std::ifstream fin(s);
     pl.clear();
-    fin >> pl;
-
-    Robot[i] = PolygonsToTriangles(pl,5.0);
-    j=0;
-    list<MSLTriangle>::iterator t;
-
-    Ro[i].BeginModel();
-    PQP_REAL p1[3],p2[3],p3[3];
-    forall(t,Robot[i]){
-      p1[0] = (PQP_REAL) t->p1.xcoord();
-      p1[1] = (PQP_REAL) t->p1.ycoord();
-      p1[2] = (PQP_REAL) t->p1.zcoord();
-      p2[0] = (PQP_REAL) t->p2.xcoord();
-      p2[1] = (PQP_REAL) t->p2.ycoord();
-      p2[2] = (PQP_REAL) t->p2.zcoord();
-      p3[0] = (PQP_REAL) t->p3.xcoord();
-      p3[1] = (PQP_REAL) t->p3.ycoord();
-      p3[2] = (PQP_REAL) t->p3.zcoord();
-      Ro[i].AddTri(p1,p2,p3,j);
-      j++;
-    }
-    Ro[i].EndModel();
+    MakeModel(s,&pl,5.0,Robot[i],Ro[i]);
   }
 }
 
 
+
+size_t GeomPQP2DRigidMulti::MemoryUsage() {
+  size_t bytes;
+  int i;
+
+  bytes = GeomPQP::MemoryUsage();
+  for (i = 0; i < (int) Ro.size(); i++)
+    bytes += ModelBytes(Robot[i],Ro[i]);
+  return bytes;
+}
+
+
 bool GeomPQP2DRigidMulti::CollisionFree(const MSLVector &q){
   int i,j;
   list<MSLVector>::iterator v;
+  PQP_REAL rr[MAXBODIES][3][3],tr[MAXBODIES][3];
 
   PQP_CollideResult cres;
-  SetTransformation(q);
+  SetTransformation(q,rr,tr);
 
   // Check for collisions with obstacles
   for (i = 0; i < NumBodies; i++) {
-    PQP_Collide(&cres,RR[i],TR[i],&Ro[i],RO,TO,&Ob,PQP_FIRST_CONTACT);
+    PQP_Collide(&cres,rr[i],tr[i],&Ro[i],RO,TO,&Ob,PQP_FIRST_CONTACT);
     if (cres.NumPairs() >= 1)
       return false;
   }
@@ -386,7 +515,7 @@ bool GeomPQP2DRigidMulti::CollisionFree(const MSLVector &q){
   forall(v,CollisionPairs) {
     i = (int) v->operator[](0);
     j = (int) v->operator[](1);
-    PQP_Collide(&cres,RR[i],TR[i],&Ro[i],RR[j],TR[j],&Ro[j],PQP_FIRST_CONTACT);
+    PQP_Collide(&cres,rr[i],tr[i],&Ro[i],rr[j],tr[j],&Ro[j],PQP_FIRST_CONTACT);
     if (cres.NumPairs() >= 1)
       return false;
   }
@@ -424,6 +553,12 @@ double GeomPQP2DRigidMulti::DistanceComp(const MSLVector &q){
 
 
 void GeomPQP2DRigidMulti::SetTransformation(const MSLVector &q){
+  SetTransformation(q,RR,TR);
+}
+
+
+void GeomPQP2DRigidMulti::SetTransformation(const MSLVector &q,
+					    PQP_REAL rr[][3][3], PQP_REAL tr[][3]){
 
   int i;
   MSLVector qi(3);
@@ -434,20 +569,20 @@ void GeomPQP2DRigidMulti::SetTransformation(const MSLVector &q){
     qi[2] = q[i*3+2];
 
     // Set translation
-    TR[i][0]=(PQP_REAL)qi[0];
-    TR[i][1]=(PQP_REAL)qi[1];
-    TR[i][2]=0.0;
+    tr[i][0]=(PQP_REAL)qi[0];
+    tr[i][1]=(PQP_REAL)qi[1];
+    tr[i][2]=0.0;
 
     // Set yaw rotation
-    RR[i][0][0] = (PQP_REAL)(cos(qi[2]));
-    RR[i][0][1] = (PQP_REAL)(-sin(qi[2]));
-    RR[i][0][2] = 0.0;
-    RR[i][1][0] = (PQP_REAL)(sin(qi[2]));
-    RR[i][1][1] = (PQP_REAL)(cos(qi[2]));
-    RR[i][1][2] = 0.0;
-    RR[i][2][0] = 0.0;
-    RR[i][2][1] = 0.0;
-    RR[i][2][2] = 1.0;
+    rr[i][0][0] = (PQP_REAL)(cos(qi[2]));
+    rr[i][0][1] = (PQP_REAL)(-sin(qi[2]));
+    rr[i][0][2] = 0.0;
+    rr[i][1][0] = (PQP_REAL)(sin(qi[2]));
+    rr[i][1][1] = (PQP_REAL)(cos(qi[2]));
+    rr[i][1][2] = 0.0;
+    rr[i][2][0] = 0.0;
+    rr[i][2][1] = 0.0;
+    rr[i][2][2] = 1.0;
   }
 }
 
@@ -519,12 +654,13 @@ GeomPQP3DRigid::GeomPQP3DRigid(string path = ""):GeomPQP(path) {
 
 
 bool GeomPQP3DRigid::CollisionFree(const MSLVector &q){
+  PQP_REAL rr[3][3],tr[3];
 
-  SetTransformation(q);
+  SetTransformation(q,rr,tr);
 
 
   PQP_CollideResult cres;
-  PQP_Collide(&cres,RR,TR,&Ro,RO,TO,&Ob,PQP_FIRST_CONTACT);
+  PQP_Collide(&cres,rr,tr,&Ro,RO,TO,&Ob,PQP_FIRST_CONTACT);
 
   return (cres.NumPairs() == 0);
 }
@@ -587,22 +723,28 @@ MSLVector GeomPQP3DRigid::ConfigurationDifference(const MSLVector &q1,
 
 
 void GeomPQP3DRigid::SetTransformation(const MSLVector &q){
+  SetTransformation(q,RR,TR);
+}
+
+
+void GeomPQP3DRigid::SetTransformation(const MSLVector &q, PQP_REAL rr[3][3],
+				 PQP_REAL tr[3]){
 
   // Set translation
-  TR[0]=(PQP_REAL)q[0];
-  TR[1]=(PQP_REAL)q[1];
-  TR[2]=(PQP_REAL)q[2];
+  tr[0]=(PQP_REAL)q[0];
+  tr[1]=(PQP_REAL)q[1];
+  tr[2]=(PQP_REAL)q[2];
 
   // Set rotation
-  RR[0][0]=(PQP_REAL)(cos(q[5])*cos(q[4]));
-  RR[0][1]=(PQP_REAL)(cos(q[5])*sin(q[4])*sin(q[3])-sin(q[5])*cos(q[3]));
-  RR[0][2]=(PQP_REAL)(cos(q[5])*sin(q[4])*cos(q[3])+sin(q[5])*sin(q[3]));
-  RR[1][0]=(PQP_REAL)(sin(q[5])*cos(q[4]));
-  RR[1][1]=(PQP_REAL)(sin(q[5])*sin(q[4])*sin(q[3])+cos(q[5])*cos(q[3]));
-  RR[1][2]=(PQP_REAL)(sin(q[5])*sin(q[4])*cos(q[3])-cos(q[5])*sin(q[3]));
-  RR[2][0]=(PQP_REAL)((-1)*sin(q[4]));
-  RR[2][1]=(PQP_REAL)(cos(q[4])*sin(q[3]));
-  RR[2][2]=(PQP_REAL)(cos(q[4])*cos(q[3]));
+  rr[0][0]=(PQP_REAL)(cos(q[5])*cos(q[4]));
+  rr[0][1]=(PQP_REAL)(cos(q[5])*sin(q[4])*sin(q[3])-sin(q[5])*cos(q[3]));
+  rr[0][2]=(PQP_REAL)(cos(q[5])*sin(q[4])*cos(q[3])+sin(q[5])*sin(q[3]));
+  rr[1][0]=(PQP_REAL)(sin(q[5])*cos(q[4]));
+  rr[1][1]=(PQP_REAL)(sin(q[5])*sin(q[4])*sin(q[3])+cos(q[5])*cos(q[3]));
+  rr[1][2]=(PQP_REAL)(sin(q[5])*sin(q[4])*cos(q[3])-cos(q[5])*sin(q[3]));
+  rr[2][0]=(PQP_REAL)((-1)*sin(q[4]));
+  rr[2][1]=(PQP_REAL)(cos(q[4])*sin(q[3]));
+  rr[2][2]=(PQP_REAL)(cos(q[4])*cos(q[3]));
 
 }
 
@@ -628,7 +770,7 @@ GeomPQP3DRigidMulti::GeomPQP3DRigidMulti(string path = ""):GeomPQP3DRigid(path)
 
 
 void GeomPQP3DRigidMulti::LoadRobot(string path){
-  int i,j;
+  int i;
   string fname;
 
   char* s = new char[50];
@@ -650,44 +792,35 @@ void GeomPQP3DRigidMulti::LoadRobot(string path){
   Ro = vector<PQP_Model>(NumBodies);
 
   for (i = 0; i < NumBodies; i++) {
-
     sprintf(s,"%sRobot%d",FilePath.c_str(),i);
-    std::ifstream fin(s);
-    fin >> Robot[i];
-
-    j=0;
-    list<MSLTriangle>::iterator t;
-
-    Ro[i].BeginModel();
-    PQP_REAL p1[3],p2[3],p3[3];
-    forall(t,Robot[i]){
-      p1[0] = (PQP_REAL) t->p1.xcoord();
-      p1[1] = (PQP_REAL) t->p1.ycoord();
-      p1[2] = (PQP_REAL) t->p1.zcoord();
-      p2[0] = (PQP_REAL) t->p2.xcoord();
-      p2[1] = (PQP_REAL) t->p2.ycoord();
-      p2[2] = (PQP_REAL) t->p2.zcoord();
-      p3[0] = (PQP_REAL) t->p3.xcoord();
-      p3[1] = (PQP_REAL) t->p3.ycoord();
-      p3[2] = (PQP_REAL) t->p3.zcoord();
-      Ro[i].AddTri(p1,p2,p3,j);
-      j++;
-    }
-    Ro[i].EndModel();
+    MakeModel(s,NULL,0.0,Robot[i],Ro[i]);
   }
 }
 
 
+
+size_t GeomPQP3DRigidMulti::MemoryUsage() {
+  size_t bytes;
+  int i;
+
+  bytes = GeomPQP::MemoryUsage();
+  for (i = 0; i < (int) Ro.size(); i++)
+    bytes += ModelBytes(Robot[i],Ro[i]);
+  return bytes;
+}
+
+
 bool GeomPQP3DRigidMulti::CollisionFree(const MSLVector &q){
   int i,j;
   list<MSLVector>::iterator v;
+  PQP_REAL rr[MAXBODIES][3][3],tr[MAXBODIES][3];
 
   PQP_CollideResult cres;
-  SetTransformation(q);
+  SetTransformation(q,rr,tr);
 
   // Check for collisions with obstacles
   for (i = 0; i < NumBodies; i++) {
-    PQP_Collide(&cres,RR[i],TR[i],&Ro[i],RO,TO,&Ob,PQP_FIRST_CONTACT);
+    PQP_Collide(&cres,rr[i],tr[i],&Ro[i],RO,TO,&Ob,PQP_FIRST_CONTACT);
     if (cres.NumPairs() >= 1)
       return false;
   }
@@ -696,7 +829,7 @@ bool GeomPQP3DRigidMulti::CollisionFree(const MSLVector &q){
   forall(v,CollisionPairs) {
     i = (int) v->operator[](0);
     j = (int) v->operator[](1);
-    PQP_Collide(&cres,RR[i],TR[i],&Ro[i],RR[j],TR[j],&Ro[j],PQP_FIRST_CONTACT);
+    PQP_Collide(&cres,rr[i],tr[i],&Ro[i],rr[j],tr[j],&Ro[j],PQP_FIRST_CONTACT);
     if (cres.NumPairs() >= 1)
       return false;
   }
@@ -734,6 +867,12 @@ double GeomPQP3DRigidMulti::DistanceComp(const MSLVector &q){
 
 
 void GeomPQP3DRigidMulti::SetTransformation(const MSLVector &q){
+  SetTransformation(q,RR,TR);
+}
+
+
+void GeomPQP3DRigidMulti::SetTransformation(const MSLVector &q,
+					    PQP_REAL rr[][3][3], PQP_REAL tr[][3]){
 
   int i;
   MSLVector qi(6);
@@ -744,19 +883,19 @@ void GeomPQP3DRigidMulti::SetTransformation(const MSLVector &q){
     qi[3] = q[i*6+3]; qi[4] = q[i*6+4]; qi[5] = q[i*6+5];
 
     // Set translation
-    TR[i][0]=(PQP_REAL)qi[0];
-    TR[i][1]=(PQP_REAL)qi[1];
-    TR[i][2]=(PQP_REAL)qi[2];
+    tr[i][0]=(PQP_REAL)qi[0];
+    tr[i][1]=(PQP_REAL)qi[1];
+    tr[i][2]=(PQP_REAL)qi[2];
 
     // Set rotation
-    RR[i][0][0]=(PQP_REAL)(cos(qi[5])*cos(qi[4]));
-    RR[i][0][1]=(PQP_REAL)(cos(qi[5])*sin(qi[4])*sin(qi[3])-sin(qi[5])*cos(qi[3]));
-    RR[i][0][2]=(PQP_REAL)(cos(qi[5])*sin(qi[4])*cos(qi[3])+sin(qi[5])*sin(qi[3]));
-    RR[i][1][0]=(PQP_REAL)(sin(qi[5])*cos(qi[4]));
-    RR[i][1][1]=(PQP_REAL)(sin(qi[5])*sin(qi[4])*sin(qi[3])+cos(qi[5])*cos(qi[3]));
-    RR[i][1][2]=(PQP_REAL)(sin(qi[5])*sin(qi[4])*cos(qi[3])-cos(qi[5])*sin(qi[3]));
-    RR[i][2][0]=(PQP_REAL)((-1)*sin(qi[4]));
-    RR[i][2][1]=(PQP_REAL)(cos(qi[4])*sin(qi[3]));
-    RR[i][2][2]=(PQP_REAL)(cos(qi[4])*cos(qi[3]));
+    rr[i][0][0]=(PQP_REAL)(cos(qi[5])*cos(qi[4]));
+    rr[i][0][1]=(PQP_REAL)(cos(qi[5])*sin(qi[4])*sin(qi[3])-sin(qi[5])*cos(qi[3]));
+    rr[i][0][2]=(PQP_REAL)(cos(qi[5])*sin(qi[4])*cos(qi[3])+sin(qi[5])*sin(qi[3]));
+    rr[i][1][0]=(PQP_REAL)(sin(qi[5])*cos(qi[4]));
+    rr[i][1][1]=(PQP_REAL)(sin(qi[5])*sin(qi[4])*sin(qi[3])+cos(qi[5])*cos(qi[3]));
+    rr[i][1][2]=(PQP_REAL)(sin(qi[5])*sin(qi[4])*cos(qi[3])-cos(qi[5])*sin(qi[3]));
+    rr[i][2][0]=(PQP_REAL)((-1)*sin(qi[4]));
+    rr[i][2][1]=(PQP_REAL)(cos(qi[4])*sin(qi[3]));
+    rr[i][2][2]=(PQP_REAL)(cos(qi[4])*cos(qi[3]));
   }
 }
@@ -17,6 +17,8 @@
 //----------------------------------------------------------------------
 
 
+#include <unordered_map>
+
 #include "msl/graph.h"
 
 
@@ -146,9 +148,13 @@ ostream& operator<<(ostream& out, const MSLEdge& e)
 // *********************************************************************
 // *********************************************************************
 
+// A list cell: two links and the element
+#define MSL_LIST_CELL (sizeof(void*) + 2*sizeof(void*))
+
 MSLGraph::MSLGraph() {
   numvertices = 0;
   numedges = 0;
+  bytes = peakbytes = 0;
 }
 
 
@@ -165,6 +171,7 @@ MSLVertex* MSLGraph::AddVertex(const MSLVector &x) {
   nv->id = numvertices;
   vertices.push_back(nv);
   numvertices++;
+  bytes += sizeof(MSLVertex) + x.dim()*sizeof(double) + MSL_LIST_CELL;
 
   return nv;
 }
@@ -190,6 +197,8 @@ MSLEdge* MSLGraph::AddEdge(MSLVertex* v1, MSLVertex* v2,
 
   edges.push_back(e);
   numedges++;
+  // The edge is also on the edge lists of both of its vertices
+  bytes += sizeof(MSLEdge) + u.dim()*sizeof(double) + 3*MSL_LIST_CELL;
 
   return e;
 }
@@ -234,6 +243,12 @@ void MSLGraph::Clear() {
   for (e = edges.begin(); e != edges.end(); e++)
     delete *e;
   edges.clear();
+
+  numvertices = 0;
+  numedges = 0;
+  if (bytes > peakbytes)
+    peakbytes = bytes;
+  bytes = 0;
 }
 
 
@@ -261,10 +276,12 @@ istream& operator>> (istream& is, MSLGraph & G) {
   int i,nid1,nid2,nume,numv;
   MSLVector x,u;
   MSLVertex *v1,*v2;
+  unordered_map<int,MSLVertex*> byid;
 
   G.Clear();
 
-  is >> numv >> nume;
+  if (!(is >> numv >> nume))
+    return is;
   cout << "Loading a graph that has " << numv
        << " vertices and " << nume << " edges\n";
 
@@ -273,13 +290,14 @@ istream& operator>> (istream& is, MSLGraph & G) {
     is >> nid1 >> x;
     v1 = G.AddVertex(x);
     v1->SetID(nid1);
+    byid[nid1] = v1;
   }
 
-  // Handle edges
+  // Handle edges (look the vertices up by id, rather than with FindVertex)
   for (i = 0; i < nume; i++) {
     is >> nid1 >> nid2;
-    v1 = G.FindVertex(nid1);
-    v2 = G.FindVertex(nid2);
+    v1 = byid.count(nid1) ? byid[nid1] : NULL;
+    v2 = byid.count(nid2) ? byid[nid2] : NULL;
     if (v1 && v2)
       G.AddEdge(v1,v2);
     else
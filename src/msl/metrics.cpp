@@ -0,0 +1,288 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fstream>
+#include <sstream>
+
+#include "msl/metrics.h"
+#include "msl/util.h"
+
+//! Longest wait, in milliseconds, before Run looks at Stopping again
+#define MSL_METRICS_POLL 100
+
+
+// *********************************************************************
+// *********************************************************************
+// CLASS:     MSLMetrics
+//
+// *********************************************************************
+// *********************************************************************
+
+MSLMetrics::MSLMetrics(Planner *pl) {
+  Pl = pl;
+  Stopping = false;
+  Listener = -1;
+  WasTiming = false;
+  LastNodes = LastCollisions = 0;
+  LastNearest = 0.0;
+  LastTime = wall_time();
+  Period = 1.0;
+}
+
+
+
+MSLMetrics::~MSLMetrics() {
+  Stop();
+}
+
+
+
+bool MSLMetrics::Start(const string &target, double period) {
+  struct sockaddr_un addr;
+  string sockpath;
+
+  if (Worker.joinable()) {
+    cerr << "Error:   Metrics already started\n";
+    return false;
+  }
+  Target = target;
+  Period = (period > 0.0) ? period : 1.0;
+
+  if (Target.compare(0,5,"unix:") == 0) {
+    sockpath = Target.substr(5);
+    if (sockpath.length() >= sizeof(addr.sun_path)) {
+      cerr << "Error:   Socket path too long\n";
+      return false;
+    }
+    memset(&addr,0,sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path,sockpath.c_str());
+    unlink(sockpath.c_str());
+    Listener = socket(AF_UNIX,SOCK_STREAM,0);
+    if ((Listener < 0) ||
+	(bind(Listener,(struct sockaddr*) &addr,sizeof(addr)) != 0) ||
+	(listen(Listener,16) != 0)) {
+      cerr << "Error:   Cannot listen on " << sockpath << "\n";
+      if (Listener >= 0)
+	close(Listener);
+      Listener = -1;
+      return false;
+    }
+  }
+
+  Pl->KeepGauges = true;
+  WasTiming = Pl->Stats.Timing;
+  Pl->Stats.Timing = true;
+  LastNodes = LastCollisions = 0;
+  LastNearest = 0.0;
+  LastTime = wall_time();
+  Stopping = false;
+  Worker = std::thread(&MSLMetrics::Run,this);
+  return true;
+}
+
+
+
+void MSLMetrics::Stop() {
+  if (!Worker.joinable())
+    return;
+
+  Stopping = true;
+  Worker.join();
+  Pl->KeepGauges = false;
+  Pl->Stats.Timing = WasTiming;
+  if (Listener >= 0) {
+    close(Listener);
+    unlink(Target.substr(5).c_str());
+    Listener = -1;
+  }
+}
+
+
+
+void MSLMetrics::Run() {
+  struct pollfd p;
+  double next;
+  int fd,wait;
+  bool stop;
+
+  next = 0.0;
+  for (;;) {
+    // The last snapshot is taken after Stop, so that it is final
+    stop = Stopping;
+    if (stop || (wall_time() >= next)) {
+      ostringstream os;
+      Write(os);
+      Text = os.str();
+      if (Listener < 0)
+	WriteFile();
+      next = wall_time() + Period;
+    }
+    if (stop)
+      break;
+
+    wait = (int) ((next - wall_time())*1000.0) + 1;
+    if (wait > MSL_METRICS_POLL)
+      wait = MSL_METRICS_POLL;
+    if (Listener < 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+      continue;
+    }
+    p.fd = Listener;
+    p.events = POLLIN;
+    if ((poll(&p,1,wait) > 0) && ((fd = accept(Listener,NULL,NULL)) >= 0)) {
+      Serve(fd);
+      close(fd);
+    }
+  }
+}
+
+
+
+void MSLMetrics::WriteFile() {
+  string tmp = Target + ".tmp";
+  ofstream fout(tmp.c_str());
+
+  fout << Text;
+  fout.close();
+  if (!fout || (rename(tmp.c_str(),Target.c_str()) != 0))
+    cerr << "Warning: Cannot write " << Target << "\n";
+}
+
+
+
+void MSLMetrics::Serve(int fd) {
+  struct pollfd p;
+  char request[256];
+  ssize_t n = 0;
+  string reply;
+
+  // A client that speaks HTTP sends its request first; others are sent
+  // the text right away
+  p.fd = fd;
+  p.events = POLLIN;
+  if (poll(&p,1,MSL_METRICS_POLL) > 0)
+    n = recv(fd,request,sizeof(request)-1,0);
+  if ((n >= 3) && (strncmp(request,"GET",3) == 0)) {
+    ostringstream header;
+    header << "HTTP/1.0 200 OK\r\n"
+	   << "Content-Type: text/plain; version=0.0.4\r\n"
+	   << "Content-Length: " << Text.length() << "\r\n\r\n";
+    reply = header.str();
+  }
+  reply += Text;
+  send(fd,reply.data(),reply.length(),MSG_NOSIGNAL);
+}
+
+
+
+// One metric with its HELP and TYPE lines
+static void Metric(ostream &os, const char *name, const char *type,
+		   const char *help, double value) {
+  os << "# HELP " << name << " " << help << "\n"
+     << "# TYPE " << name << " " << type << "\n"
+     << name << " " << value << "\n";
+}
+
+
+
+void MSLMetrics::Write(ostream &os) {
+  MSLPlannerStats &s = Pl->Stats;
+  long nodes,collisions;
+  double nearest,now,dt,goaldist;
+  int p;
+
+  now = wall_time();
+  // Counted from the sizes, since a roadmap also inserts edges
+  nodes = Pl->Gauges.TreeNodes + Pl->Gauges.Tree2Nodes +
+    Pl->Gauges.RoadmapVertices;
+  collisions = s.NumCalls(MSL_PHASE_COLLISION);
+  nearest = s.Seconds(MSL_PHASE_NEAREST);
+  dt = now - LastTime;
+
+  // PlanWithin and ConstructWithin clear Stats, and Reset the trees;
+  // count from zero again
+  if (nodes < LastNodes)
+    LastNodes = 0;
+  if ((collisions < LastCollisions) || (nearest < LastNearest)) {
+    LastCollisions = 0;
+    LastNearest = 0.0;
+  }
+
+  os.precision(10);
+  Metric(os,"msl_nodes_per_second","gauge",
+	 "Nodes added to the trees or roadmap per second, over the last "
+	 "period",
+	 (dt > 0.0) ? (nodes - LastNodes)/dt : 0.0);
+  Metric(os,"msl_collision_checks_per_second","gauge",
+	 "Calls of Problem::Satisfied per second, over the last period",
+	 (dt > 0.0) ? (collisions - LastCollisions)/dt : 0.0);
+  Metric(os,"msl_nearest_time_share","gauge",
+	 "Seconds spent finding nearest neighbors per second of wall time, "
+	 "over the last period (above 1 with several threads)",
+	 (dt > 0.0) ? (nearest - LastNearest)/dt : 0.0);
+  Metric(os,"msl_memory_bytes","gauge",
+	 "Bytes held by the trees, roadmap and collision models",
+	 (double) Pl->Gauges.MemoryBytes);
+  goaldist = Pl->Gauges.GoalDist;
+  if (!isnan(goaldist))
+    Metric(os,"msl_goal_distance","gauge",
+	   "Distance from the closest state found (BestState) to the goal",
+	   goaldist);
+
+  os << "# HELP msl_tree_nodes Nodes in each tree\n"
+     << "# TYPE msl_tree_nodes gauge\n"
+     << "msl_tree_nodes{tree=\"T\"} " << Pl->Gauges.TreeNodes << "\n"
+     << "msl_tree_nodes{tree=\"T2\"} " << Pl->Gauges.Tree2Nodes << "\n";
+  Metric(os,"msl_roadmap_vertices","gauge","Vertices in the roadmap",
+	 (double) Pl->Gauges.RoadmapVertices);
+  Metric(os,"msl_running","gauge",
+	 "1 while PlanWithin or ConstructWithin runs",
+	 Pl->Gauges.Running ? 1.0 : 0.0);
+  Metric(os,"msl_status","gauge",
+	 "How the last run ended: 0 none, 1 success, 2 failure, 3 timeout, "
+	 "4 cancelled, 5 memory",
+	 (double) Pl->Gauges.Status);
+
+  os << "# HELP msl_phase_calls_total Calls of each planner phase in the "
+     << "current run\n"
+     << "# TYPE msl_phase_calls_total counter\n";
+  for (p = 0; p < MSL_NUM_PHASES; p++)
+    os << "msl_phase_calls_total{phase=\""
+       << MSLPlannerStats::PhaseName((MSLPlannerPhase) p) << "\"} "
+       << s.NumCalls((MSLPlannerPhase) p) << "\n";
+  os << "# HELP msl_phase_seconds_total Seconds spent in each planner "
+     << "phase in the current run\n"
+     << "# TYPE msl_phase_seconds_total counter\n";
+  for (p = 0; p < MSL_NUM_PHASES; p++)
+    os << "msl_phase_seconds_total{phase=\""
+       << MSLPlannerStats::PhaseName((MSLPlannerPhase) p) << "\"} "
+       << s.Seconds((MSLPlannerPhase) p) << "\n";
+
+  LastNodes = nodes;
+  LastCollisions = collisions;
+  LastNearest = nearest;
+  LastTime = now;
+}
@@ -303,7 +303,7 @@ Model3DRigidChain::Model3DRigidChain(string path = ""):Model3DRigid(path) {
 
   int i;
   MSLVector u;
-  std::ifstream fin;
+  MSLProblemFile fin;
 
   READ_PARAMETER_OR_ERROR(NumBodies);
   READ_PARAMETER_OR_ERROR(StateDim);
@@ -312,7 +312,7 @@ Model3DRigidChain::Model3DRigidChain(string path = ""):Model3DRigid(path) {
   InputDim = StateDim;
 
   StateIndices = vector<int>(StateDim);
-  fin.open((FilePath + "StateIndices").c_str());
+  fin.open(FilePath + "StateIndices");
   if (fin) {
     for (i = 0; i < StateDim; i++) {
       fin >> StateIndices[i];
@@ -352,7 +352,7 @@ Model3DRigidChain::Model3DRigidChain(string path = ""):Model3DRigid(path) {
 
 MSLVector Model3DRigidChain::StateToConfiguration(const MSLVector &x) {
   MSLVector q;
-  MSLVector A, Alpha, D, Theta;
+  MSLVector A, Alpha, D, Theta, dh;
   int i;
   MSLMatrix r(4,4), rn(4,4), ro(4,4);
 
@@ -362,18 +362,20 @@ MSLVector Model3DRigidChain::StateToConfiguration(const MSLVector &x) {
   Alpha = MSLVector(NumBodies);
   Theta = MSLVector(NumBodies);
 
+  // Work on a copy so that concurrent calls do not share DH
+  dh = DH;
   for (i = 0; i < StateDim; i++ ) {
     if (StateIndices[i] != 0) {
       int y = StateIndices[i];
-      DH[y-1] = x[i];
+      dh[y-1] = x[i];
     }
   }
 
   for (i = 0; i < NumBodies; i++) {
-       Alpha[i] = DH[i];
-       Theta[i] = DH[NumBodies*1+i];
-       A[i] = DH[NumBodies*2+i];
-       D[i] = DH[NumBodies*3+i];
+       Alpha[i] = dh[i];
+       Theta[i] = dh[NumBodies*1+i];
+       A[i] = dh[NumBodies*2+i];
+       D[i] = dh[NumBodies*3+i];
   }
 
   for (i = 0; i < 4 ; i ++ ) {
@@ -508,7 +510,7 @@ Model3DRigidTree::Model3DRigidTree(string path = ""):Model3DRigid(path) {
 
   int i;
   MSLVector u;
-  std::ifstream fin;
+  MSLProblemFile fin;
 
   READ_PARAMETER_OR_ERROR(NumBodies);
   READ_PARAMETER_OR_ERROR(StateDim);
@@ -517,7 +519,7 @@ Model3DRigidTree::Model3DRigidTree(string path = ""):Model3DRigid(path) {
   InputDim = StateDim;
 
   StateIndices = vector<int>(StateDim);
-  fin.open((FilePath + "StateIndices").c_str());
+  fin.open(FilePath + "StateIndices");
   if (fin) {
     for (i = 0; i < StateDim; i++) {
       fin >> StateIndices[i];
@@ -531,7 +533,7 @@ Model3DRigidTree::Model3DRigidTree(string path = ""):Model3DRigid(path) {
 
 
   Parents = vector<int>(NumBodies);
-  fin.open((FilePath + "Parents").c_str());
+  fin.open(FilePath + "Parents");
   if (fin) {
     for (i = 0; i < NumBodies; i++) {
       fin >> Parents[i];
@@ -574,7 +576,7 @@ Model3DRigidTree::Model3DRigidTree(string path = ""):Model3DRigid(path) {
 
 MSLVector Model3DRigidTree::StateToConfiguration(const MSLVector &x) {
   MSLVector q;
-  MSLVector A, Alpha, D, Theta;
+  MSLVector A, Alpha, D, Theta, dh;
   int i;
   MSLMatrix r(4,4), rn(4,4), ro(4,4);
 
@@ -587,18 +589,20 @@ MSLVector Model3DRigidTree::StateToConfiguration(const MSLVector &x) {
   Alpha = MSLVector(NumBodies);
   Theta = MSLVector(NumBodies);
 
+  // Work on a copy so that concurrent calls do not share DH
+  dh = DH;
   for (i = 0; i < StateDim; i++ ) {
     if (StateIndices[i] != 0) {
       int y = StateIndices[i];
-      DH[y-1] = x[i];
+      dh[y-1] = x[i];
     }
   }
 
   for (i = 0; i < NumBodies; i++){
-       Alpha[i] = DH[i];
-       Theta[i] = DH[NumBodies*1+i];
-       A[i] = DH[NumBodies*2+i];
-       D[i] = DH[NumBodies*3+i];
+       Alpha[i] = dh[i];
+       Theta[i] = dh[NumBodies*1+i];
+       A[i] = dh[NumBodies*2+i];
+       D[i] = dh[NumBodies*3+i];
   }
 
   for (i = 0; i < 4 ; i ++ ) {
@@ -20,6 +20,7 @@
 #include <stdio.h>
 
 #include "msl/planner.h"
+#include "msl/roadmapfile.h"
 #include "msl/defs.h"
 
 
@@ -34,6 +35,13 @@ Planner::Planner(Problem *problem):Solver(problem) {
   T = NULL;
   T2 = NULL;
   Roadmap = NULL;
+  CancelToken = NULL;
+  Deadline = 0.0;
+  Snapshot = NULL;
+  SnapshotPeriod = 0.25;
+  Sink = NULL;
+  Trace = NULL;
+  KeepGauges = false;
   Reset();
 }
 
@@ -46,7 +54,6 @@ void Planner::Reset() {
   int i;
 
   NumNodes = 1000;
-  std::ifstream fin;
 
   READ_PARAMETER_OR_DEFAULT(PlannerDeltaT,1.0);
 
@@ -55,15 +62,41 @@ void Planner::Reset() {
     GapError[i] = 1.0;
   READ_OPTIONAL_PARAMETER(GapError);
 
+  StateLower.resize(P->StateDim);
+  StateRange.resize(P->StateDim);
+  for (i = 0; i < P->StateDim; i++) {
+    StateLower[i] = P->LowerState[i];
+    StateRange[i] = P->UpperState[i] - P->LowerState[i];
+  }
+
   Path.clear();
   Policy.clear();
 
-  fin.open((FilePath+"Holonomic").c_str());
-  Holonomic = fin ? true : false; // Nonholonomic by default
-  fin.close();
+  Status = MSL_PLAN_NONE;
+  BestState = P->InitialState;
+  PartialPath.clear();
+
+  Holonomic = is_file(FilePath+"Holonomic"); // Nonholonomic by default
+
+  BinaryGraphs = is_file(FilePath+"BinaryGraphs");
+
+  SaveStats = is_file(FilePath+"PlannerStats");
+  Stats.Timing = SaveStats || is_file(FilePath+"PhaseTiming");
+
+  READ_PARAMETER_OR_DEFAULT(MemoryLimit,0.0);
+  MemoryExceeded = false;
+  MemoryPolls = 0;
+  Gauges.Clear();
+
+  // R starts from the clock unless a seed is given
+  READ_PARAMETER_OR_DEFAULT(Seed,R());
+  SetSeed(Seed);
+  Stats.Clear();
 
   CumulativePlanningTime = 0.0;
   CumulativeConstructTime = 0.0;
+  CumulativePlanningWallTime = 0.0;
+  CumulativeConstructWallTime = 0.0;
 
   if (T)
     delete T;
@@ -75,43 +108,431 @@ void Planner::Reset() {
   if (Roadmap)
     delete Roadmap;
   Roadmap = NULL;
+
+  ResetSnapshot();
 }
 
 
-MSLVector Planner::RandomState() {
+void Planner::SetSeed(int seed) {
+  Seed = seed;
+  R.set_seed(seed);
+  NumStreams = 0;
+}
+
+
+
+void Planner::SplitRandomSource(MSLRandomSource &rs) {
+  rs.set_stream(Seed,++NumStreams);
+}
+
+
+void Planner::ResetSnapshot() {
+  LastSnapshotTime = 0.0;
+  SnapshotNodes = SnapshotNodes2 = SnapshotEdges = 0;
+}
+
+
+void Planner::SendSolution() {
+  list<MSLVector>::iterator x,u;
+  list<double>::iterator t;
+  MSLVector none;
+
+  if (!Sink)
+    return;
+
+  // Samples stop where the times do; a Path may end with a jump to the goal
+  Sink->Begin(P->StateDim,P->InputDim);
+  x = Path.begin();
+  u = Policy.begin();
+  forall(t,TimeList) {
+    if (x == Path.end())
+      break;
+    Sink->Sample(*t,*x,(u != Policy.end()) ? *u : none);
+    x++;
+    if (u != Policy.end())
+      u++;
+  }
+  Sink->End();
+}
+
+
+
+bool Planner::Interrupted() {
+  size_t bytes;
+
+  if (((MemoryLimit > 0.0) || KeepGauges) && (++MemoryPolls >= 64)) {
+    MemoryPolls = 0;
+    bytes = MemoryUsage();
+    if ((MemoryLimit > 0.0) && (bytes > MemoryLimit*1048576.0))
+      MemoryExceeded = true;
+    if (KeepGauges)
+      UpdateGauges(bytes);
+  }
+
+  return (MemoryExceeded ||
+	  (CancelToken && CancelToken->IsCancelled()) ||
+	  ((Deadline > 0.0) && (wall_time() > Deadline)));
+}
+
+
+
+void Planner::UpdateGauges(size_t bytes) {
+  Gauges.TreeNodes = T ? T->Size() : 0;
+  Gauges.Tree2Nodes = T2 ? T2->Size() : 0;
+  Gauges.RoadmapVertices = Roadmap ? Roadmap->NumVertices() : 0;
+  Gauges.MemoryBytes = bytes;
+}
+
+
+
+void Planner::MemoryItems(list<MSLMemoryItem> &ml) {
+  MSLMemoryItem m;
+
+  if (T) {
+    m = {"tree",T->MemoryUsage(),T->PeakMemoryUsage(),T->Size()};
+    ml.push_back(m);
+  }
+  if (T2) {
+    m = {"tree2",T2->MemoryUsage(),T2->PeakMemoryUsage(),T2->Size()};
+    ml.push_back(m);
+  }
+  if (Roadmap) {
+    m = {"roadmap",Roadmap->MemoryUsage(),Roadmap->PeakMemoryUsage(),
+	 Roadmap->Size()};
+    ml.push_back(m);
+  }
+  m = {"collision_models",P->MemoryUsage(),P->MemoryUsage(),0};
+  ml.push_back(m);
+}
+
+
+
+size_t Planner::MemoryUsage() {
+  list<MSLMemoryItem> ml;
+  list<MSLMemoryItem>::iterator m;
+  size_t bytes = 0;
+
+  MemoryItems(ml);
+  forall(m,ml)
+    bytes += m->Bytes;
+  return bytes;
+}
+
+
+
+size_t Planner::PeakMemoryUsage() {
+  list<MSLMemoryItem> ml;
+  list<MSLMemoryItem>::iterator m;
+  size_t bytes = 0;
+
+  MemoryItems(ml);
+  forall(m,ml)
+    bytes += m->PeakBytes;
+  return bytes;
+}
+
+
+
+void Planner::WriteMemoryJSON(ostream &os) {
+  list<MSLMemoryItem> ml;
+
+  MemoryItems(ml);
+  MSLPlannerStats::WriteMemoryJSON(os,ml);
+}
+
+
+
+MSLPlanStatus Planner::PlanWithin(double timelimit, MSLCancelToken *token) {
+  MSLCancelToken *oldtoken = CancelToken;
+  double start = wall_time();
+
+  if (token)
+    CancelToken = token;
+  Deadline = (timelimit > 0.0) ? wall_time() + timelimit : 0.0;
+  Stats.Clear();
+  MemoryExceeded = false;
+  Gauges.Running = true;
+
+  FinishStatus(Plan());
+  CumulativePlanningWallTime += wall_time() - start;
+  if (KeepGauges)
+    UpdateGauges(MemoryUsage());
+  Gauges.Status = Status;
+  Gauges.Running = false;
+
+  Deadline = 0.0;
+  CancelToken = oldtoken;
+  if (SaveStats)
+    WriteStats("plan");
+  return Status;
+}
+
+
+
+MSLPlanStatus Planner::ConstructWithin(double timelimit,
+				       MSLCancelToken *token) {
+  MSLCancelToken *oldtoken = CancelToken;
+  double start = wall_time();
+
+  if (token)
+    CancelToken = token;
+  Deadline = (timelimit > 0.0) ? wall_time() + timelimit : 0.0;
+  Stats.Clear();
+  MemoryExceeded = false;
+  Gauges.Running = true;
+
+  Construct();
+  CumulativeConstructWallTime += wall_time() - start;
+  FinishStatus(!Interrupted());
+  if (KeepGauges)
+    UpdateGauges(MemoryUsage());
+  Gauges.Status = Status;
+  Gauges.Running = false;
+
+  Deadline = 0.0;
+  CancelToken = oldtoken;
+  if (SaveStats)
+    WriteStats("construct");
+  return Status;
+}
+
+
+
+void Planner::WriteStats(const string &run) {
+  ofstream fout((FilePath + "stats").c_str(),ios::out|ios::app);
+
+  if (!fout) {
+    cout << "Cannot write " << FilePath << "stats\n";
+    return;
+  }
+  fout << "{\"run\": \"" << run << "\", \"status\": \"" << Status
+       << "\", \"planning_time\": " << CumulativePlanningTime
+       << ", \"construct_time\": " << CumulativeConstructTime
+       << ", \"planning_wall_time\": " << CumulativePlanningWallTime
+       << ", \"construct_wall_time\": " << CumulativeConstructWallTime
+       << ", \"phases\": ";
+  Stats.WriteJSON(fout);
+  fout << ", \"memory\": ";
+  WriteMemoryJSON(fout);
+  fout << "}\n";
+}
+
+
+
+void Planner::FinishStatus(bool success) {
+  if (success)
+    Status = MSL_PLAN_SUCCESS;
+  else if (MemoryExceeded)
+    Status = MSL_PLAN_MEMORY;
+  else if (CancelToken && CancelToken->IsCancelled())
+    Status = MSL_PLAN_CANCELLED;
+  else if ((Deadline > 0.0) && (wall_time() > Deadline))
+    Status = MSL_PLAN_TIMEOUT;
+  else
+    Status = MSL_PLAN_FAILURE;
+
+  if (Status == MSL_PLAN_SUCCESS)
+    PartialPath.clear();
+  else
+    RecordPartialSolution();
+}
+
+
+
+void Planner::RecordPartialSolution() {
+  PartialPath.clear();
+}
+
+
+
+ostream& operator<< (ostream& os, MSLPlanStatus s) {
+  switch (s) {
+  case MSL_PLAN_NONE: os << "none"; break;
+  case MSL_PLAN_SUCCESS: os << "success"; break;
+  case MSL_PLAN_FAILURE: os << "failure"; break;
+  case MSL_PLAN_TIMEOUT: os << "timeout"; break;
+  case MSL_PLAN_CANCELLED: os << "cancelled"; break;
+  case MSL_PLAN_MEMORY: os << "memory"; break;
+  }
+  return os;
+}
+
+
+
+// Collect the newest nodes of a tree as (parent, child) pairs.  Nodes
+// are appended to t->nodes, so the unpublished ones are at the back.
+static void SnapshotTreeEdges(MSLTree *t, int &count, list<MSLVector> &el)
+{
+  list<MSLNode*>::reverse_iterator n;
   int i;
-  double r;
-  MSLVector rx;
 
-  rx = P->LowerState;
-  for (i = 0; i < P->StateDim; i++) {
-      R >> r;
-      rx[i] += r * (P->UpperState[i] - P->LowerState[i]);
+  if (!t) {
+    count = 0;
+    return;
+  }
+  if (count > t->Size())
+    count = 0;  // The tree was replaced
+
+  for (n = t->nodes.rbegin(), i = t->Size() - count;
+       (i > 0) && (n != t->nodes.rend()); n++, i--)
+    if ((*n)->Parent()) {
+      el.push_back((*n)->Parent()->State());
+      el.push_back((*n)->State());
+    }
+  count = t->Size();
+}
+
+
+
+void Planner::PublishSnapshot(bool force) {
+  list<MSLVector> el;
+  double now;
+
+  if (!Snapshot)
+    return;
+
+  now = wall_time();
+  if ((!force) && (now - LastSnapshotTime < SnapshotPeriod))
+    return;
+  LastSnapshotTime = now;
+
+  CollectSnapshotEdges(el);
+
+  if (el.size() > 0)
+    Snapshot->Add(el);
+}
+
+
+
+void Planner::PublishTreeSnapshot(MSLTree *t, int &count, double &last,
+				  bool force) {
+  list<MSLVector> el;
+  double now;
+
+  if (!Snapshot)
+    return;
+
+  now = wall_time();
+  if ((!force) && (now - last < SnapshotPeriod))
+    return;
+  last = now;
+
+  SnapshotTreeEdges(t,count,el);
+
+  if (el.size() > 0)
+    Snapshot->Add(el);
+}
+
+
+
+void Planner::CollectSnapshotEdges(list<MSLVector> &el) {
+  list<MSLEdge*> edges;
+  list<MSLEdge*>::reverse_iterator e;
+  int i;
+
+  SnapshotTreeEdges(T,SnapshotNodes,el);
+  SnapshotTreeEdges(T2,SnapshotNodes2,el);
+
+  if (Roadmap) {
+    if (SnapshotEdges > Roadmap->NumEdges())
+      SnapshotEdges = 0;
+    edges = Roadmap->Edges();
+    for (e = edges.rbegin(), i = Roadmap->NumEdges() - SnapshotEdges;
+	 (i > 0) && (e != edges.rend()); e++, i--) {
+      el.push_back((*e)->Source()->State());
+      el.push_back((*e)->Target()->State());
     }
+    SnapshotEdges = Roadmap->NumEdges();
+  }
+  else
+    SnapshotEdges = 0;
+}
+
+
+
+// *********************************************************************
+// *********************************************************************
+// CLASS:     MSLPlannerSnapshot
+//
+// *********************************************************************
+// *********************************************************************
+
+void MSLPlannerSnapshot::Add(list<MSLVector> &el) {
+  std::lock_guard<std::mutex> guard(Lock);
+  Edges.splice(Edges.end(),el);
+}
+
+
+void MSLPlannerSnapshot::Take(list<MSLVector> &el) {
+  std::lock_guard<std::mutex> guard(Lock);
+  el.splice(el.end(),Edges);
+}
+
+
+void MSLPlannerSnapshot::Clear() {
+  std::lock_guard<std::mutex> guard(Lock);
+  Edges.clear();
+}
+
+
+
+// *********************************************************************
+// *********************************************************************
+// CLASS:     MSLPlannerGauges
+//
+// *********************************************************************
+// *********************************************************************
+
+void MSLPlannerGauges::Clear() {
+  TreeNodes = 0;
+  Tree2Nodes = 0;
+  RoadmapVertices = 0;
+  MemoryBytes = 0;
+  GoalDist = NAN;
+  Status = MSL_PLAN_NONE;
+  Running = false;
+}
+
+
+MSLVector Planner::RandomState() {
+  return RandomState(R);
+}
+
+
+
+MSLVector Planner::RandomState(MSLRandomSource &rs) {
+  MSLVector rx(P->StateDim);
+
+  RandomStates(rs,&rx[0],1);
 
   return rx;
 }
 
 
 
+void Planner::RandomStates(MSLRandomSource &rs, double *x, int n) {
+  int i,j,dim;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SAMPLE);
+
+  dim = P->StateDim;
+  rs.uniform(x,n*dim);
+  for (i = 0; i < n; i++, x += dim)
+    for (j = 0; j < dim; j++)
+      x[j] = StateLower[j] + x[j] * StateRange[j];
+}
+
+
+
 MSLVector Planner::NormalState(MSLVector mean, double sd = 0.5) {
-  int i,j;
-  double r;
-  MSLVector rx;
-  bool success = false;
+  int i;
+  MSLVector rx(P->StateDim);
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SAMPLE);
 
-  rx = mean;
   for (i = 0; i < P->StateDim; i++) {
-    success = false;
-    while (!success) {
-      rx[i] = 0.0;
-      for (j = 0; j < 12; j++) {  // Increase 12 here and below for more accuracy
-	R >> r; rx[i] += r;
-      }
-      rx[i] = (rx[i] - 12/2)*sd*(P->UpperState[i]-P->LowerState[i])+mean[i];
-      if ((rx[i] <= P->UpperState[i])&&(rx[i] >= P->LowerState[i]))
-	success = true;
-    }
+    // Redraw until the coordinate falls within the bounds
+    do {
+      rx[i] = R.normal()*sd*StateRange[i] + mean[i];
+    } while ((rx[i] > StateLower[i] + StateRange[i])||(rx[i] < StateLower[i]));
   }
 
   return rx;
@@ -153,12 +574,17 @@ void IncrementalPlanner::Construct() {
 void IncrementalPlanner::RecordSolution(const list<MSLNode*> &glist,
 					const list<MSLNode*> &g2list)
 {
-  list<MSLNode*>::const_iterator n,nfirst,nlast;
+  list<MSLNode*>::const_iterator n,nfirst,nlast,nprev;
   double ptime;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_RECOVER);
 
   Path.clear();
   Policy.clear();
 
+  // Samples go to the Sink as soon as their inputs are known
+  if (Sink)
+    Sink->Begin(P->StateDim,P->InputDim);
+
   ptime = 0.0; TimeList.clear();
   nfirst = glist.begin();
 
@@ -166,9 +592,12 @@ void IncrementalPlanner::RecordSolution(const list<MSLNode*> &glist,
     Path.push_back((*n)->State());
     if (n != nfirst) {
       Policy.push_back((*n)->Input());
+      if (Sink)
+	Sink->Sample(TimeList.back(),(*nprev)->State(),(*n)->Input());
     }
     ptime += (*n)->Time();
     TimeList.push_back(ptime);
+    nprev = n;
   }
 
   // The GapState is always comes from last node in glist
@@ -176,6 +605,8 @@ void IncrementalPlanner::RecordSolution(const list<MSLNode*> &glist,
 
   // Make a dummy input to get from GapState to the next state
   Policy.push_back(P->GetInputs().front());
+  if (Sink)
+    Sink->Sample(TimeList.back(),GapState,Policy.back());
 
   if (g2list.size() == 0) {
     // Push the goal state onto the end (jumps the gap)
@@ -190,10 +621,15 @@ void IncrementalPlanner::RecordSolution(const list<MSLNode*> &glist,
 	Policy.push_back((*n)->Input());
       }
     TimeList.push_back(ptime);
+    if (Sink)
+      Sink->Sample(ptime,(*n)->State(),(*n)->Input());
     ptime += (*n)->Time();
     }
   }
 
+  if (Sink)
+    Sink->End();
+
   //cout << "Path: " << Path << "\n";
   //cout << "Policy: " << Policy << "\n";
   //cout << "TimeList: " << TimeList << "\n";
@@ -211,8 +647,46 @@ void IncrementalPlanner::RecordSolution(const list<MSLNode*> &glist)
 
 
 
+void IncrementalPlanner::RecordPartialSolution()
+{
+  list<MSLNode*>::iterator n;
+  list<MSLNode*> path;
+  MSLNode *best;
+  double d,bestd;
+
+  PartialPath.clear();
+  if ((!T) || (!T->Root()))
+    return;
+
+  best = T->Root();
+  bestd = P->Metric(best->State(),P->GoalState);
+  forall(n,T->nodes) {
+    d = P->Metric((*n)->State(),P->GoalState);
+    if (d < bestd) {
+      bestd = d;
+      best = *n;
+    }
+  }
+
+  BestState = best->State();
+  path = T->PathToRoot(best);
+  path.reverse();
+  forall(n,path)
+    PartialPath.push_back((*n)->State());
+}
+
+
+
 void IncrementalPlanner::WriteGraphs(ofstream &fout)
 {
+  if (BinaryGraphs) {
+    if (T)
+      T->WriteBinary(fout);
+    if (T2)
+      T2->WriteBinary(fout);
+    return;
+  }
+
   if (T)
     fout << *T << "\n\n\n";
   if (T2)
@@ -232,7 +706,6 @@ void IncrementalPlanner::ReadGraphs(ifstream &fin)
   T2 = new MSLTree();
 
   fin >> *T;
-  cout << "T \n" << *T << endl;
   fin >> *T2;
 }
 
@@ -252,18 +725,60 @@ RoadmapPlanner::RoadmapPlanner(Problem *problem):Planner(problem) {
 
 
 
+void RoadmapPlanner::RecordPartialSolution()
+{
+  list<MSLVertex*> vl;
+  list<MSLVertex*>::iterator v;
+  double d,bestd;
+
+  PartialPath.clear();
+  if (!Roadmap)
+    return;
+
+  bestd = INFINITY;
+  vl = Roadmap->Vertices();
+  forall(v,vl) {
+    d = P->Metric((*v)->State(),P->GoalState);
+    if (d < bestd) {
+      bestd = d;
+      BestState = (*v)->State();
+    }
+  }
+}
+
+
+
 void RoadmapPlanner::WriteGraphs(ofstream &fout)
 {
-  fout << *Roadmap << "\n\n\n";
+  if (!Roadmap)
+    return;
+
+  if (BinaryGraphs)
+    MSLRoadmapFile::Write(fout,*Roadmap);
+  else
+    fout << *Roadmap << "\n\n\n";
 }
 
 
 
 void RoadmapPlanner::ReadGraphs(ifstream &fin)
 {
+  MSLRoadmapFile rf;
+
   if (Roadmap)
     delete Roadmap;
 
+  fin >> ws;
+  if (fin.peek() == MSL_ROADMAP_MAGIC[0]) {
+    if (rf.Read(fin))
+      Roadmap = rf.MakeGraph();
+    else {
+      cout << "Error reading a binary roadmap\n";
+      Roadmap = new MSLGraph();
+    }
+    return;
+  }
+
   Roadmap = new MSLGraph();
   fin >> *Roadmap;
 }
@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include "msl/plannerstats.h"
+
+
+void MSLPlannerStats::Clear() {
+  int i;
+
+  for (i = 0; i < MSL_NUM_PHASES; i++) {
+    Calls[i] = 0;
+    Nanoseconds[i] = 0;
+  }
+}
+
+
+
+const char* MSLPlannerStats::PhaseName(MSLPlannerPhase p) {
+  static const char *names[MSL_NUM_PHASES] = {
+    "sample", "nearest", "select_input", "integrate", "collision",
+    "insert", "recover"
+  };
+
+  return ((p >= 0) && (p < MSL_NUM_PHASES)) ? names[p] : "unknown";
+}
+
+
+
+void MSLPlannerStats::WriteJSON(ostream &os) const {
+  int i;
+
+  os << "{";
+  for (i = 0; i < MSL_NUM_PHASES; i++)
+    os << ((i > 0) ? ", " : "") << "\"" << PhaseName((MSLPlannerPhase) i)
+       << "\": {\"calls\": " << Calls[i] << ", \"seconds\": "
+       << Nanoseconds[i]*1e-9 << "}";
+  os << "}";
+}
+
+
+
+void MSLPlannerStats::WriteMemoryJSON(ostream &os,
+				      const list<MSLMemoryItem> &ml) {
+  list<MSLMemoryItem>::const_iterator m;
+  size_t bytes = 0,peak = 0;
+
+  os << "{";
+  for (m = ml.begin(); m != ml.end(); m++) {
+    os << "\"" << m->Name << "\": {\"bytes\": " << m->Bytes
+       << ", \"peak_bytes\": " << m->PeakBytes << ", \"items\": "
+       << m->Items;
+    if (m->Items > 0)
+      os << ", \"bytes_per_item\": " << (double) m->Bytes / m->Items;
+    os << "}, ";
+    bytes += m->Bytes;
+    peak += m->PeakBytes;
+  }
+  os << "\"total\": {\"bytes\": " << bytes << ", \"peak_bytes\": "
+     << peak << "}}";
+}
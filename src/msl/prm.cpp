@@ -48,12 +48,47 @@ PRM::PRM(Problem *problem): RoadmapPlanner(problem) {
   //! Choose Hammersley (which is better) or Halton sequence for quasi-random points
   QuasiRandomHammersley = true;
 
+  MappedRoadmap = NULL;
+
   if (!Holonomic)
     cout << "WARNING: Differential constraints will be ignored.\n";
 }
 
 
 
+PRM::~PRM() {
+  if (MappedRoadmap)
+    delete MappedRoadmap;
+}
+
+
+
+bool PRM::MapRoadmap(const string &fname) {
+  if (!MappedRoadmap)
+    MappedRoadmap = new MSLRoadmapFile();
+
+  if (!MappedRoadmap->Open(fname)) {
+    cout << "Could not map the roadmap " << fname << "\n";
+    delete MappedRoadmap;
+    MappedRoadmap = NULL;
+    return false;
+  }
+
+  if (MappedRoadmap->StateDim() != P->StateDim) {
+    cout << "The roadmap " << fname << " has states of dimension "
+	 << MappedRoadmap->StateDim() << ", not " << P->StateDim << "\n";
+    delete MappedRoadmap;
+    MappedRoadmap = NULL;
+    return false;
+  }
+
+  cout << "Mapped a roadmap with " << MappedRoadmap->NumVertices()
+       << " vertices and " << MappedRoadmap->NumEdges() << " edges\n";
+  return true;
+}
+
+
+
 
 list<MSLVertex*> PRM::NeighboringVertices(const MSLVector &x) {
   double d;
@@ -61,6 +96,7 @@ list<MSLVertex*> PRM::NeighboringVertices(const MSLVector &x) {
   list<MSLVertex*> best_list,all_vertices;
   list<MSLVertex*>::iterator vi;
   int k;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_NEAREST);
 
   all_vertices = Roadmap->Vertices();
 
@@ -100,7 +136,7 @@ bool PRM::Connect(const MSLVector &x1, const MSLVector &x2, MSLVector &u_best) {
   for (a = 1.0/(k+1); a < 1.0; a += 1.0/(k+1) ) {
     x = P->InterpolateState(x1,x2,a);
     SatisfiedCount++;
-    if (!P->Satisfied(x))
+    if (!Satisfied(x))
       return false;
   }
 
@@ -116,43 +152,64 @@ void PRM::Construct()
   MSLVertex *nn;
   list<MSLVertex*> nhbrs;
   list<MSLVertex*>::iterator ni;
+  long long start;
 
   float t = used_time();
 
+  if (MappedRoadmap) {
+    cout << "The mapped roadmap is read-only.  Construct has no effect.\n";
+    return;
+  }
+
   if (!Roadmap)
     Roadmap = new MSLGraph();
 
   // Set the step size
-  StepSize = P->Metric(P->InitialState,P->Integrate(P->InitialState,
+  StepSize = P->Metric(P->InitialState,Integrate(P->InitialState,
  	     P->GetInputs(P->InitialState).front(),PlannerDeltaT));
 
   i = 0;
-  while (i < NumNodes) {
+  while ((i < NumNodes)&&(!Interrupted())) {
+    start = Trace ? MSLTrace::Now() : 0;
     nx = ChooseState(i,NumNodes,P->InitialState.dim());
     SatisfiedCount++;
     i++;
-    while (!P->Satisfied(nx)) {
+    while (!Satisfied(nx)) {
+      if (Trace) {
+	Trace->Add(MSL_TRACE_SAMPLE,start,MSL_TRACE_COLLISION,-1,-1,0,nx);
+	start = MSLTrace::Now();
+      }
       nx = ChooseState(i,NumNodes,P->InitialState.dim());
       SatisfiedCount++;
       i++;
       // Keep trying until a good sample is found
     }
     nhbrs = NeighboringVertices(nx);
-    nn = Roadmap->AddVertex(nx);
+    {
+      MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+      nn = Roadmap->AddVertex(nx);
+    }
 
     k = 0;
     forall(ni,nhbrs) {
       if (Connect((*ni)->State(),nx,u_best)) {
-	Roadmap->AddEdge(nn,*ni,u_best,1.0);
-	Roadmap->AddEdge(*ni,nn,-1.0*u_best,1.0);
+	{
+	  MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	  Roadmap->AddEdge(nn,*ni,u_best,1.0);
+	  Roadmap->AddEdge(*ni,nn,-1.0*u_best,1.0);
+	}
 	k++;
       }
       if (k > MaxEdgesPerVertex)
 	break;
     }
 
+    if (Trace)
+      Trace->Add(MSL_TRACE_SAMPLE,start,MSL_TRACE_OK,-1,nn->ID(),k,nx);
+
     if (Roadmap->NumVertices() % 1000 == 0)
       cout << Roadmap->NumVertices() << " vertices in the PRM.\n";
+    PublishSnapshot();
   }
 
   //MSLVertex_array<int> labels(G);
@@ -196,6 +253,9 @@ bool PRM::Plan()
   priority_queue<MSLVertex*,vector<MSLVertex*>,MSLVertexGreater> Q;
   double cost,mincost,time;
 
+  if (MappedRoadmap)
+    return PlanMapped();
+
   float t = used_time();
 
   if (!Roadmap) {
@@ -204,7 +264,7 @@ bool PRM::Plan()
   }
 
   // Set the step size
-  StepSize = P->Metric(P->InitialState,P->Integrate(P->InitialState,
+  StepSize = P->Metric(P->InitialState,Integrate(P->InitialState,
  	     P->GetInputs(P->InitialState).front(),PlannerDeltaT));
 
   // Connect to the initial state
@@ -216,10 +276,12 @@ bool PRM::Plan()
     return false;
   }
 
+  success = false;
   vi = nlist.begin();
   while ((!success) && (vi != nlist.end())) {
     success = Connect(P->InitialState,(*vi)->State(),u_best);
-    vi++;
+    if (!success)
+      vi++;
   }
 
   if (!success) {
@@ -230,9 +292,12 @@ bool PRM::Plan()
 
   // Make ni a new vertex in the PRM
   n = *vi;
-  ni = Roadmap->AddVertex(P->InitialState);
-  Roadmap->AddEdge(n,ni,u_best,1.0);
-  Roadmap->AddEdge(ni,n,-1.0*u_best,1.0);
+  {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+    ni = Roadmap->AddVertex(P->InitialState);
+    Roadmap->AddEdge(n,ni,u_best,1.0);
+    Roadmap->AddEdge(ni,n,-1.0*u_best,1.0);
+  }
 
   // Connect to the goal state
   nlist = NeighboringVertices(P->GoalState);
@@ -243,10 +308,12 @@ bool PRM::Plan()
     return false;
   }
 
+  success = false;
   vi = nlist.begin();
   while ((!success) && (vi != nlist.end())) {
     success = Connect((*vi)->State(),P->GoalState,u_best);
-    vi++;
+    if (!success)
+      vi++;
   }
 
   if (!success) {
@@ -257,9 +324,12 @@ bool PRM::Plan()
 
   // Make ng a new MSLVertex in the PRM
   n = *vi;
-  ng = Roadmap->AddVertex(P->GoalState);
-  Roadmap->AddEdge(n,ng,u_best,1.0);
-  Roadmap->AddEdge(ng,n,-1.0*u_best,1.0);
+  {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+    ng = Roadmap->AddVertex(P->GoalState);
+    Roadmap->AddEdge(n,ng,u_best,1.0);
+    Roadmap->AddEdge(ng,n,-1.0*u_best,1.0);
+  }
 
   // Initialize for DP search (the original PRM used A^*)
   ni->SetCost(0.0);
@@ -271,7 +341,7 @@ bool PRM::Plan()
 
   // Loop until Q is empty or goal is found
   success = false;
-  while ((!success)&&(!Q.empty())) {
+  while ((!success)&&(!Q.empty())&&(!Interrupted())) {
     // Remove smallest element
     n = Q.top();
     cost = n->Cost();
@@ -293,6 +363,7 @@ bool PRM::Plan()
   cout << "Planning Time: " << CumulativePlanningTime << "s\n";
 
   if (ng->IsMarked()) {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_RECOVER);
     // Get the path
     n = ng;
     while (n != ni) {
@@ -325,6 +396,141 @@ bool PRM::Plan()
     TimeList.push_back(time);
     time += 1.0;
   }
+  SendSolution();
+
+  cout << "  Success\n";
+
+  return true;
+}
+
+
+
+int PRM::ConnectMapped(const MSLVector &x, bool toward, MSLVector &u_best) {
+  MSLVector y;
+  int v,k;
+
+  // Same neighbors as NeighboringVertices, tried in the same order
+  k = 0;
+  for (v = 0; (v < MappedRoadmap->NumVertices()) && (k < MaxNeighbors); v++) {
+    y = MappedRoadmap->State(v);
+    if (P->Metric(y,x) < Radius) {
+      k++;
+      if (toward ? Connect(x,y,u_best) : Connect(y,x,u_best))
+	return v;
+    }
+  }
+
+  return -1;
+}
+
+
+
+bool PRM::PlanMapped()
+{
+  const MSLRoadmapFile *rm = MappedRoadmap;
+  vector<double> cost;
+  vector<int> pred,prededge;
+  list<int> vpath,epath;
+  list<int>::iterator vi,ei;
+  priority_queue<pair<double,int>,vector<pair<double,int> >,
+    greater<pair<double,int> > > Q;
+  int n,nn,e,ni,ng;
+  double c,time;
+  bool reached;
+  MSLVector u_init,u_goal;
+
+  float t = used_time();
+
+  // The roadmap may have been lent for another problem
+  if (rm->StateDim() != P->StateDim) {
+    cout << "The roadmap has states of dimension " << rm->StateDim()
+	 << ", not " << P->StateDim << "\n";
+    return false;
+  }
+
+  // Set the step size
+  StepSize = P->Metric(P->InitialState,Integrate(P->InitialState,
+ 	     P->GetInputs(P->InitialState).front(),PlannerDeltaT));
+
+  ni = ConnectMapped(P->InitialState,true,u_init);
+  if (ni < 0) {
+    cout << "Failure to connect to Initial State\n";
+    cout << "Planning Time: " << ((double)used_time(t)) << "s\n";
+    return false;
+  }
+
+  ng = ConnectMapped(P->GoalState,false,u_goal);
+  if (ng < 0) {
+    cout << "Failure to connect to Goal State\n";
+    cout << "Planning Time: " << ((double)used_time(t)) << "s\n";
+    return false;
+  }
+
+  // Dijkstra over the CSR arrays; the roadmap itself is never written
+  cost.assign(rm->NumVertices(),INFINITY);
+  pred.assign(rm->NumVertices(),-1);
+  prededge.assign(rm->NumVertices(),-1);
+  cost[ni] = 0.0;
+  Q.push(make_pair(0.0,ni));
+  reached = false;
+  while ((!Q.empty())&&(!Interrupted())) {
+    c = Q.top().first;
+    n = Q.top().second;
+    Q.pop();
+    if (n == ng) {  // Only now is cost[ng] final
+      reached = true;
+      break;
+    }
+    if (c > cost[n])
+      continue;  // A stale entry
+    for (e = rm->EdgeBegin(n); e < rm->EdgeEnd(n); e++) {
+      nn = rm->Target(e);
+      if (c + rm->Cost(e) < cost[nn]) {
+	cost[nn] = c + rm->Cost(e);
+	pred[nn] = n;
+	prededge[nn] = e;
+	Q.push(make_pair(cost[nn],nn));
+      }
+    }
+  }
+
+  CumulativePlanningTime += ((double)used_time(t));
+  cout << "Planning Time: " << CumulativePlanningTime << "s\n";
+
+  // Stopped early (deadline or cancel): any cost to ng is not yet final
+  if (!reached) {
+    cout << "  Failure to find a path in the graph.\n";
+    return false;
+  }
+
+  {
+    MSLPhaseTimer timer(Stats,MSL_PHASE_RECOVER);
+    for (n = ng; n != -1; n = pred[n]) {
+      vpath.push_front(n);
+      if (prededge[n] >= 0)
+	epath.push_front(prededge[n]);
+    }
+  }
+
+  // Make the solution; the inputs come from the edges of the file
+  Path.clear();
+  Policy.clear();
+  TimeList.clear();
+  Path.push_back(P->InitialState);
+  TimeList.push_back(0.0);
+  Policy.push_back(u_init);
+  time = 1.0;
+  forall(vi,vpath) {
+    Path.push_back(rm->State(*vi));
+    TimeList.push_back(time);
+    time += 1.0;
+  }
+  forall(ei,epath)
+    Policy.push_back(rm->Input(*ei));
+  Policy.push_back(u_goal);
+  Path.push_back(P->GoalState);
+  TimeList.push_back(time);
+  SendSolution();
 
   cout << "  Success\n";
 
@@ -20,6 +20,7 @@
 #include <math.h>
 
 #include "msl/problem.h"
+#include "msl/profile.h"
 #include "msl/defs.h"
 
 // Constructor
@@ -74,6 +75,7 @@ void Problem::SetModel(Model *model) {
 // In the base class, steal the following methods from Model
 
 list<MSLVector> Problem::GetInputs(const MSLVector &x) {
+  MSL_PROFILE_SCOPE("Problem::GetInputs");
   return M->GetInputs(x);
 }
 
@@ -86,16 +88,19 @@ list<MSLVector> Problem::GetInputs() {
 
 MSLVector Problem::InterpolateState(const MSLVector &x1, const MSLVector &x2,
 				 const double &a) {
+  MSL_PROFILE_SCOPE("Problem::InterpolateState");
   return M->LinearInterpolate(x1,x2,a);
 }
 
 // By default, don't change anything
 MSLVector Problem::StateToConfiguration(const MSLVector &x) {
+  MSL_PROFILE_SCOPE("Problem::StateToConfiguration");
   return M->StateToConfiguration(x);
 }
 
 // Default metric: use the metric from the model
 double Problem::Metric(const MSLVector &x1, const MSLVector &x2) {
+  MSL_PROFILE_SCOPE("Problem::Metric");
   return M->Metric(x1,x2);
 }
 
@@ -105,27 +110,36 @@ MSLVector Problem::StateDifference(const MSLVector &x1,
 }
 
 bool Problem::Satisfied(const MSLVector &x) {
+  MSL_PROFILE_SCOPE("Problem::Satisfied");
   return ((G->CollisionFree(StateToConfiguration(x)))&&
 	  (M->Satisfied(x)));
 }
 
 MSLVector Problem::Integrate(const MSLVector &x, const MSLVector &u,
 			  const double &deltat) {
+  MSL_PROFILE_SCOPE("Problem::Integrate");
   return M->Integrate(x,u,deltat);
 }
 
 // In the base class, steal the following methods from Geom
 
 bool Problem::CollisionFree(const MSLVector &q) {
+  MSL_PROFILE_SCOPE("Problem::CollisionFree");
   return G->CollisionFree(q);
 }
 
 
 double Problem::DistanceComp(const MSLVector &q) {
+  MSL_PROFILE_SCOPE("Problem::DistanceComp");
   return G->DistanceComp(q);
 }
 
 
+size_t Problem::MemoryUsage() {
+  return G->MemoryUsage();
+}
+
+
 MSLVector Problem::ConfigurationDifference(const MSLVector &q1,
 				    const MSLVector &q2) {
   return G->ConfigurationDifference(q1,q2);
@@ -0,0 +1,176 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <atomic>
+
+#include "msl/profile.h"
+
+thread_local MSLMarkerStack MSLMarkers;
+
+//! Distinct stacks kept (a power of two)
+#define MSL_PROFILE_TABLE 4096
+
+// One distinct marker stack and its samples.  Key is a hash of the
+// stack, claimed with a compare-and-swap by the first sample that
+// sees it; 0 marks a free entry.
+struct MSLProfileEntry {
+  std::atomic<unsigned long long> Key;
+  std::atomic<long> Count;
+  int Depth;
+  const char *Names[MSL_PROFILE_MAX_DEPTH];
+};
+
+static MSLProfileEntry Table[MSL_PROFILE_TABLE];
+static std::atomic<long> Samples(0),Dropped(0);
+static std::atomic<bool> Running(false);
+static struct sigaction OldAction;
+
+
+
+// Runs in the signal handler, so it only reads the stack of the
+// interrupted thread and touches preallocated entries
+static void Sample(int) {
+  unsigned long long key = 1469598103934665603ULL;
+  int i,depth,n;
+  size_t e;
+
+  depth = MSLMarkers.Depth;
+  n = (depth < MSL_PROFILE_MAX_DEPTH) ? depth : MSL_PROFILE_MAX_DEPTH;
+  key = (key ^ (unsigned long long) depth) * 1099511628211ULL;
+  for (i = 0; i < n; i++)
+    key = (key ^ (unsigned long long) MSLMarkers.Names[i]) *
+      1099511628211ULL;
+  key |= 1;
+
+  Samples++;
+  for (e = key, i = 0; i < MSL_PROFILE_TABLE; e++, i++) {
+    MSLProfileEntry &t = Table[e & (MSL_PROFILE_TABLE-1)];
+    unsigned long long k = t.Key.load();
+    if ((k == 0) && t.Key.compare_exchange_strong(k,key)) {
+      t.Depth = depth;
+      memcpy(t.Names,(const void*) MSLMarkers.Names,n*sizeof(const char*));
+      t.Count++;
+      return;
+    }
+    if (k == key) {
+      t.Count++;
+      return;
+    }
+  }
+  Dropped++;
+}
+
+
+
+bool MSLProfiler::MarkersEnabled() {
+#ifdef MSL_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+
+bool MSLProfiler::Start(int hz) {
+  struct sigaction sa;
+  struct itimerval it;
+  bool off = false;
+
+  if ((hz <= 0) || !Running.compare_exchange_strong(off,true))
+    return false;
+
+  memset(&sa,0,sizeof(sa));
+  sa.sa_handler = Sample;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGPROF,&sa,&OldAction) != 0) {
+    Running = false;
+    return false;
+  }
+
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = (hz > 1) ? 1000000 / hz : 999999;
+  it.it_value = it.it_interval;
+  if (setitimer(ITIMER_PROF,&it,NULL) != 0) {
+    sigaction(SIGPROF,&OldAction,NULL);
+    Running = false;
+    return false;
+  }
+
+  return true;
+}
+
+
+
+void MSLProfiler::Stop() {
+  struct itimerval it;
+
+  if (!Running)
+    return;
+  memset(&it,0,sizeof(it));
+  setitimer(ITIMER_PROF,&it,NULL);
+  sigaction(SIGPROF,&OldAction,NULL);
+  Running = false;
+}
+
+
+
+void MSLProfiler::Clear() {
+  int i;
+
+  for (i = 0; i < MSL_PROFILE_TABLE; i++) {
+    Table[i].Key = 0;
+    Table[i].Count = 0;
+  }
+  Samples = Dropped = 0;
+}
+
+
+
+long MSLProfiler::NumSamples() {
+  return Samples;
+}
+
+
+
+long MSLProfiler::NumDropped() {
+  return Dropped;
+}
+
+
+
+void MSLProfiler::WriteFolded(ostream &os) {
+  int i,j;
+
+  for (i = 0; i < MSL_PROFILE_TABLE; i++) {
+    const MSLProfileEntry &t = Table[i];
+    if ((t.Key == 0) || (t.Count == 0))
+      continue;
+    if (t.Depth == 0)
+      os << "(none)";
+    for (j = 0; (j < t.Depth) && (j < MSL_PROFILE_MAX_DEPTH); j++)
+      os << ((j > 0) ? ";" : "") << t.Names[j];
+    if (t.Depth > MSL_PROFILE_MAX_DEPTH)
+      os << ";...";
+    os << " " << t.Count << "\n";
+  }
+}
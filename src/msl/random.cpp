@@ -16,85 +16,85 @@
 // It is provided "as is" without express or implied warranty.
 //----------------------------------------------------------------------
 
+#include <math.h>
 #include <time.h>
 
 #include "msl/random.h"
 
-void MSLRandomSource::init_table()
-{
-  table[ 0] = -1708027847;
-  table[ 1] =   853131300;
-  table[ 2] = -1687801470;
-  table[ 3] =  1570894658;
-  table[ 4] =  -566525472;
-  table[ 5] =  -552964171;
-  table[ 6] =  -251413502;
-  table[ 7] =  1223901435;
-  table[ 8] =  1950999915;
-  table[ 9] = -1095640144;
-  table[10] = -1420011240;
-  table[11] = -1805298435;
-  table[12] = -1943115761;
-  table[13] =  -348292705;
-  table[14] = -1323376457;
-  table[15] =   759393158;
-  table[16] =  -630772182;
-  table[17] =   361286280;
-  table[18] =  -479628451;
-  table[19] = -1873857033;
-  table[20] =  -686452778;
-  table[21] =  1873211473;
-  table[22] =  1634626454;
-  table[23] = -1399525412;
-  table[24] =   910245779;
-  table[25] =  -970800488;
-  table[26] =  -173790536;
-  table[27] = -1970743429;
-  table[28] =  -173171442;
-  table[29] = -1986452981;
-  table[30] =   670779321;
-
-  ptr0    = table;
-  ptr1    = table + 3;
-  ptr_end = table + 31;
+// SplitMix64 (Steele, Lea and Flood): each call advances x and returns
+// a well-mixed 64-bit value, so nearby (seed, stream) pairs give
+// unrelated tables
+static unsigned long long splitmix64(unsigned long long &x)
+{ unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
 }
 
 
 void MSLRandomSource::set_seed(int x)
-{ table[0] = (unsigned)x;
+{ unsigned long long z = (unsigned long long)(unsigned) x;
   int i;
-  for(i=1; i<31; i++) table[i] = 1103515245 * table[i-1] + 12345;
-  ptr0 = table;
-  ptr1 = table + 3;
-  for(i=0; i<310; i++) get_rand31();
+  for(i=0; i<4; i++) state[i] = splitmix64(z);
+  have_normal = false;
 }
 
 
-#define RANDMAX 0x7FFFFFFF
+void MSLRandomSource::set_stream(int seed, int stream)
+{ unsigned long long x = ((unsigned long long)(unsigned) seed << 32) |
+    (unsigned) stream;
+  int i;
+  splitmix64(x);
+  for(i=0; i<4; i++) state[i] = splitmix64(x);
+  have_normal = false;
+}
 
-unsigned long MSLRandomSource::get_rand31()
-{ *ptr1 += *ptr0;
-  long i = (*ptr1 >> 1) & 0x7fffffff;
-  if (++ptr0 >= ptr_end) ptr0 = table;
-  if (++ptr1 >= ptr_end) ptr1 = table;
-  return (unsigned long)i;
+
+void MSLRandomSource::uniform(double *x, int n)
+{ // The state lives in registers for the whole block
+  unsigned long long s0 = state[0], s1 = state[1], s2 = state[2],
+    s3 = state[3], t;
+  int i;
+  for(i=0; i<n; i++) {
+    x[i] = ((rotl(s1 * 5, 7) * 9) >> 11) * (1.0/9007199254740992.0);
+    t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl(s3, 45);
+  }
+  state[0] = s0; state[1] = s1; state[2] = s2; state[3] = s3;
 }
 
-unsigned long MSLRandomSource::get_rand32()
-{ if (buffer == 0x00000001) buffer = 0x80000000 | get_rand31();
-  unsigned long result = get_rand31();
-  if (buffer&1) result |= 0x80000000;
-  buffer >>= 1;
-  return result;
+
+double MSLRandomSource::normal()
+{ double u,v,r;
+  if (have_normal) {
+    have_normal = false;
+    return next_normal;
+  }
+  // Marsaglia's polar form of Box-Muller: no trigonometry, and each
+  // accepted pair gives two normals
+  do {
+    u = 2.0*uniform() - 1.0;
+    v = 2.0*uniform() - 1.0;
+    r = u*u + v*v;
+  } while (r >= 1.0 || r == 0.0);
+  r = sqrt(-2.0*log(r)/r);
+  next_normal = v*r;
+  have_normal = true;
+  return u*r;
 }
 
 
+#define RANDMAX 0x7FFFFFFF
 
 int MSLRandomSource::count = 0;
 
 MSLRandomSource::MSLRandomSource()
-{ init_table();
-  time_t seed;
+{   time_t seed;
   time(&seed);
   count++;
   set_seed(int(seed)*count);
@@ -102,12 +102,10 @@ MSLRandomSource::MSLRandomSource()
   prec = 31;
   bit_mode = true;
   low = diff = 0;
-  buffer = 0x00000001;
  }
 
 MSLRandomSource::MSLRandomSource(int bits)
-{ init_table();
-  time_t seed;
+{   time_t seed;
   time(&seed);
   count++;
   set_seed(int(seed)*count);
@@ -118,7 +116,6 @@ MSLRandomSource::MSLRandomSource(int bits)
   prec = bits;
   bit_mode = true;
   low = diff = 0;
-  buffer = 0x00000001;
  }
 
 void MSLRandomSource::set_range(int l, int h)
@@ -132,13 +129,11 @@ void MSLRandomSource::set_range(int l, int h)
 
 
 MSLRandomSource::MSLRandomSource(int l, int h)
-{ init_table();
-  time_t seed;
+{   time_t seed;
   time(&seed);
   count++;
   set_seed(int(seed)*count);
   set_range(l,h);
-  buffer = 0x00000001;
  }
 
 
@@ -242,7 +237,3 @@ MSLRandomSource& MSLRandomSource::operator>>(float&  x)
 
 
 
-MSLRandomSource& MSLRandomSource::operator>>(double& x)
-{ x = double(get_rand31())/RANDMAX;
-  return *this;
-}
@@ -159,6 +159,8 @@ MSLNode* RCRRT::SelectNode(const MSLVector &x,
   double d, d_min, d_min1;
   double biasvalue;
   double r;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_NEAREST);
+  long long start = Trace ? MSLTrace::Now() : 0;
 
   n_best = NULL;
   n_best1 = NULL;
@@ -186,10 +188,15 @@ MSLNode* RCRRT::SelectNode(const MSLVector &x,
     }
   }
 
-  if (d_min != INFINITY)
-    return n_best;
-  else
-    return n_best1;
+  if (d_min == INFINITY)
+    n_best = n_best1;
+
+  if (Trace)
+    Trace->Add(MSL_TRACE_SELECT,start,
+	       n_best ? MSL_TRACE_OK : MSL_TRACE_NOT_FOUND,
+	       n_best ? n_best->ID() : -1,-1,0,x);
+
+  return n_best;
 }
 
 
@@ -219,7 +226,10 @@ bool RCRRT::Extend(const MSLVector &x, MSLTree* t,
 
   if (success) {
     nodeinfo = new MSLNodeInfo(initexploreinfo, initcoltend);
-    nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+    {
+      MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+      nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+    }
   }
   else nn = NULL;
 
@@ -244,6 +254,7 @@ MSLVector RCRRT::SelectInput(MSLNode* n1,
   double d,d_min;
   int u_best_index;
   int inputindex;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SELECT_INPUT);
 
   u_best_index = 0;
 
@@ -268,16 +279,16 @@ MSLVector RCRRT::SelectInput(MSLNode* n1,
       //!!!!!!!!!!!!!!!! need to modify the intergrate function to
       //!include the uncontrolled state
       if (forward)
-	nx = P->Integrate(state, *uiter, PlannerDeltaT);
+	nx = Integrate(state, *uiter, PlannerDeltaT);
       else
-	nx = P->Integrate(state, *uiter, -PlannerDeltaT);
+	nx = Integrate(state, *uiter, -PlannerDeltaT);
 
       d = (forward) ? P->Metric(nx, x2) : P->Metric(x2, nx);
 
       //! Check if this input leads to collision
 
       //! If it does not lead to collision, record its index
-      if (P->Satisfied(nx)) {
+      if (Satisfied(nx)) {
 	if(d<d_min) {
 	  //! if the new state is satisfied and closer, keep this information
 	  d_min = d; u_best = *uiter; nx_best = nx; success = true;
@@ -339,7 +350,7 @@ bool RCRRT::Connect(const MSLVector &x, MSLTree* t,
     nx_prev = nx; //! Initialize
     nn = n_best;
     clock = PlannerDeltaT;
-    while ((P->Satisfied(nx))&&
+    while ((Satisfied(nx))&&
 	   (clock <= ConnectTimeLimit)&&
 	   (d <= d_prev))
       {
@@ -349,16 +360,19 @@ bool RCRRT::Connect(const MSLVector &x, MSLTree* t,
 	d_prev = d; nn_prev = nn;
 
 	if (forward)
-	  nx = P->Integrate(nx_prev,u_best,PlannerDeltaT);
+	  nx = Integrate(nx_prev,u_best,PlannerDeltaT);
 	else
-	  nx = P->Integrate(nx_prev,u_best,-PlannerDeltaT);
+	  nx = Integrate(nx_prev,u_best,-PlannerDeltaT);
 
 	d = P->Metric(nx,x);
 	clock += PlannerDeltaT;
       }
 
     nodeinfo = new MSLNodeInfo(initexploreinfo, initcoltend);
-    nn = t->Extend(n_best, nx_prev, u_best, steps*PlannerDeltaT, nodeinfo);
+    {
+      MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+      nn = t->Extend(n_best, nx_prev, u_best, steps*PlannerDeltaT, nodeinfo);
+    }
   }
   return success;
 }
@@ -397,7 +411,7 @@ bool RCRRT::Plan()
     }
 
   while (issolutionexist &&
-	 (!GapSatisfied(n_goal->State(),P->GoalState))) {
+	 (!GapSatisfied(n_goal->State(),P->GoalState))&&(!Interrupted())) {
     if (Extend(ChooseState(), T, nn, true)) {
       d = P->Metric(nn->State(),P->GoalState);
       if (d < GoalDist) {
@@ -412,6 +426,7 @@ bool RCRRT::Plan()
 	issolutionexist = false;
       }
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -490,7 +505,7 @@ bool RCRRTDual::Plan()
       return false;
     }
 
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     rx = ChooseState();
 
     if (Extend(rx,T,nn,true)) {
@@ -509,6 +524,7 @@ bool RCRRTDual::Plan()
     }
 
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -590,7 +606,7 @@ bool RCRRTExtExt::Plan()
     return false;
   }
 
-  while (issolutionexist && (!connected)) {
+  while (issolutionexist && (!connected) && (!Interrupted())) {
     if (Extend(ChooseState(),T,nn,true)) {
       if (Extend(nn->State(),T2,nn2,false)) {
 	//!    if (Connect(ChooseState(),G,nn)) {
@@ -619,6 +635,7 @@ bool RCRRTExtExt::Plan()
       }
     }
     i++;
+    PublishSnapshot();
   }
 
   if (!connected)
@@ -654,6 +671,8 @@ MSLNode* RCRRTBall::SelectNode(const MSLVector &x, MSLTree* t,
   double biasvalue;
   bool inball;
   double r;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_NEAREST);
+  long long start = Trace ? MSLTrace::Now() : 0;
 
   n_best = NULL;
   n_best1 = NULL;
@@ -692,10 +711,15 @@ MSLNode* RCRRTBall::SelectNode(const MSLVector &x, MSLTree* t,
   if(inball) FailNum ++;
   else FailNum = 0;
 
-  if (d_min != INFINITY)
-    return n_best;
-  else
-    return n_best1;
+  if (d_min == INFINITY)
+    n_best = n_best1;
+
+  if (Trace)
+    Trace->Add(MSL_TRACE_SELECT,start,
+	       n_best ? MSL_TRACE_OK : MSL_TRACE_NOT_FOUND,
+	       n_best ? n_best->ID() : -1,-1,inball ? 1 : 0,x);
+
+  return n_best;
 }
 
 
@@ -733,7 +757,10 @@ bool RCRRTBall::Extend(const MSLVector &x, MSLTree* t,
 
     if(!inball) {
       nodeinfo = new MSLNodeInfo(initexploreinfo, initcoltend);
-      nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+      {
+	MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+      }
     }
     else return false;
   }
@@ -774,7 +801,7 @@ bool RCRRTBall::Connect(const MSLVector &x, MSLTree* t,
     nx_prev = nx; //! Initialize
     nn = n_best;
     clock = PlannerDeltaT;
-    while ((P->Satisfied(nx))&&
+    while ((Satisfied(nx))&&
 	   (clock <= ConnectTimeLimit)&&
 	   (d <= d_prev))
       {
@@ -784,9 +811,9 @@ bool RCRRTBall::Connect(const MSLVector &x, MSLTree* t,
 	d_prev = d; nn_prev = nn;
 
 	if (forward)
-	  nx = P->Integrate(nx_prev,u_best,PlannerDeltaT);
+	  nx = Integrate(nx_prev,u_best,PlannerDeltaT);
 	else
-	  nx = P->Integrate(nx_prev,u_best,-PlannerDeltaT);
+	  nx = Integrate(nx_prev,u_best,-PlannerDeltaT);
 
 	d = P->Metric(nx,x);
 	clock += PlannerDeltaT;
@@ -800,7 +827,10 @@ bool RCRRTBall::Connect(const MSLVector &x, MSLTree* t,
 
     if(!inball) {
       nodeinfo = new MSLNodeInfo(initexploreinfo, initcoltend);
-      nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+      {
+	MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	nn = t->Extend(n_best, nx, u_best, PlannerDeltaT, nodeinfo);
+      }
     }
     else return false;
   }
@@ -845,7 +875,7 @@ bool RCRRTBall::Plan()
     }
 
   while ((i < NumNodes)&&(!GapSatisfied(n_goal->State(),P->GoalState))
-	 && ! isfail) {
+	 && ! isfail && (!Interrupted())) {
     //!    if (Connect(ChooseState(), G, nn, true)) {
     if (Extend(ChooseState(), T, nn, true)) {
       d = P->Metric(nn->State(),P->GoalState);
@@ -862,6 +892,7 @@ bool RCRRTBall::Plan()
 
     i++;
     if(FailNum>FailNumTh) isfail = true;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -936,7 +967,7 @@ bool RCRRTBallDual::Plan()
       return false;
     }
 
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     rx = ChooseState();
 
     if(!(Extend(rx, T, nn) && Extend(rx, T2, nn2, false))) {
@@ -947,6 +978,7 @@ bool RCRRTBallDual::Plan()
     connected = GetConnected(nn, nn2);
 
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -1026,7 +1058,7 @@ bool RCRRTBallExtExt::Plan()
     return false;
   }
 
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     if (Extend(ChooseState(),T,nn,true)) {
       if (Extend(nn->State(),T2,nn2,false)) {
 	//!    if (Connect(ChooseState(),G,nn)) {
@@ -1062,6 +1094,7 @@ bool RCRRTBallExtExt::Plan()
     }
 
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -0,0 +1,285 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vector>
+#include <unordered_map>
+#include <iterator>
+
+#include "msl/roadmapfile.h"
+#include "msl/defs.h"
+
+
+// Round a block size up so that the next block stays 8-byte aligned
+static size_t Aligned(size_t n) {
+  return (n + 7) & ~((size_t) 7);
+}
+
+
+MSLRoadmapFile::MSLRoadmapFile() {
+  Map = NULL;
+  MapSize = 0;
+  Header = NULL;
+}
+
+
+MSLRoadmapFile::~MSLRoadmapFile() {
+  Close();
+}
+
+
+
+bool MSLRoadmapFile::Open(const string &fname) {
+  struct stat st;
+  int fd;
+  void *m;
+
+  Close();
+
+  fd = open(fname.c_str(),O_RDONLY);
+  if (fd < 0)
+    return false;
+  if ((fstat(fd,&st) != 0) || (st.st_size < (off_t) sizeof(MSLRoadmapHeader))) {
+    close(fd);
+    return false;
+  }
+
+  m = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);  // The mapping stays valid
+  if (m == MAP_FAILED)
+    return false;
+
+  Map = m;
+  MapSize = st.st_size;
+  if (!Attach((const char*) Map,MapSize)) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+
+
+bool MSLRoadmapFile::Read(istream &is) {
+  Close();
+
+  Buffer.assign(istreambuf_iterator<char>(is),istreambuf_iterator<char>());
+  if (!Attach(Buffer.data(),Buffer.size())) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+
+
+void MSLRoadmapFile::Close() {
+  if (Map)
+    munmap(Map,MapSize);
+  Map = NULL;
+  MapSize = 0;
+  Buffer.clear();
+  Header = NULL;
+}
+
+
+
+bool MSLRoadmapFile::Attach(const char *data, size_t size) {
+  const MSLRoadmapHeader *h;
+  size_t nv,ne,sd,id,need,doubles;
+  const char *p;
+  size_t i;
+
+  if (size < sizeof(MSLRoadmapHeader))
+    return false;
+  h = (const MSLRoadmapHeader*) data;
+  if ((memcmp(h->Magic,MSL_ROADMAP_MAGIC,sizeof(MSL_ROADMAP_MAGIC)) != 0) ||
+      (h->Version != MSL_ROADMAP_VERSION) ||
+      (h->NumVertices < 0) || (h->NumEdges < 0) ||
+      (h->StateDim < 0) || (h->InputDim < 0))
+    return false;
+
+  nv = h->NumVertices; ne = h->NumEdges;
+  sd = h->StateDim; id = h->InputDim;
+
+  // Check the products before they are formed, so that a corrupt header
+  // cannot overflow need
+  doubles = size / sizeof(double);
+  if (((sd > 0) && (nv > doubles / sd)) ||
+      ((id > 0) && (ne > doubles / id)) || (ne > doubles))
+    return false;
+  need = sizeof(MSLRoadmapHeader) +
+    sizeof(double) * (nv*sd + 2*ne + ne*id) +
+    Aligned(sizeof(int) * (nv+1)) + sizeof(int) * ne;
+  if (size < need)
+    return false;
+
+  p = data + sizeof(MSLRoadmapHeader);
+  States = (const double*) p;   p += sizeof(double) * nv * sd;
+  Costs = (const double*) p;    p += sizeof(double) * ne;
+  Times = (const double*) p;    p += sizeof(double) * ne;
+  Inputs = (const double*) p;   p += sizeof(double) * ne * id;
+  Offsets = (const int*) p;     p += Aligned(sizeof(int) * (nv+1));
+  Targets = (const int*) p;
+
+  // Check every offset and target once, so that searches need not
+  if ((Offsets[0] != 0) || (Offsets[nv] != (int) ne))
+    return false;
+  for (i = 0; i < nv; i++)
+    if (Offsets[i] > Offsets[i+1])
+      return false;
+  for (i = 0; i < ne; i++)
+    if ((Targets[i] < 0) || (Targets[i] >= (int) nv))
+      return false;
+
+  Header = h;
+  return true;
+}
+
+
+
+void MSLRoadmapFile::Write(ostream &os, const MSLGraph &g) {
+  list<MSLVertex*> vl;
+  list<MSLEdge*> el;
+  list<MSLVertex*>::iterator v;
+  list<MSLEdge*>::iterator e;
+  unordered_map<MSLVertex*,int> index;
+  vector<double> states,costs,times,inputs;
+  vector<int> offsets,targets,fill;
+  MSLRoadmapHeader h;
+  MSLVector x;
+  int i,j,k,s,nv,ne,sd,id;
+  char pad[8];
+
+  vl = g.Vertices();
+  el = g.Edges();
+  nv = vl.size();
+  ne = el.size();
+
+  sd = id = 0;
+  i = 0;
+  forall(v,vl) {
+    index[*v] = i++;
+    sd = max(sd,(*v)->State().dim());
+  }
+  forall(e,el)
+    id = max(id,(*e)->Input().dim());
+
+  states.assign(nv*sd,0.0);
+  i = 0;
+  forall(v,vl) {
+    x = (*v)->State();
+    for (j = 0; j < (*v)->State().dim(); j++)
+      states[i*sd+j] = x[j];
+    i++;
+  }
+
+  // Count the edges leaving each vertex, then place them (counting sort)
+  offsets.assign(nv+1,0);
+  forall(e,el)
+    offsets[index[(*e)->Source()]+1]++;
+  for (i = 0; i < nv; i++)
+    offsets[i+1] += offsets[i];
+
+  fill.assign(offsets.begin(),offsets.end()-1);
+  targets.assign(ne,0);
+  costs.assign(ne,0.0);
+  times.assign(ne,0.0);
+  inputs.assign(ne*id,0.0);
+  forall(e,el) {
+    s = index[(*e)->Source()];
+    k = fill[s]++;
+    targets[k] = index[(*e)->Target()];
+    costs[k] = (*e)->Cost();
+    times[k] = (*e)->Time();
+    // Bound by the edge's own dimension; operator= never shrinks x
+    x = (*e)->Input();
+    for (j = 0; j < (*e)->Input().dim(); j++)
+      inputs[k*id+j] = x[j];
+  }
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.Magic,MSL_ROADMAP_MAGIC,sizeof(MSL_ROADMAP_MAGIC));
+  h.Version = MSL_ROADMAP_VERSION;
+  h.NumVertices = nv;
+  h.NumEdges = ne;
+  h.StateDim = sd;
+  h.InputDim = id;
+
+  memset(pad,0,sizeof(pad));
+  os.write((const char*) &h,sizeof(h));
+  os.write((const char*) states.data(),states.size()*sizeof(double));
+  os.write((const char*) costs.data(),costs.size()*sizeof(double));
+  os.write((const char*) times.data(),times.size()*sizeof(double));
+  os.write((const char*) inputs.data(),inputs.size()*sizeof(double));
+  os.write((const char*) offsets.data(),offsets.size()*sizeof(int));
+  os.write(pad,Aligned(offsets.size()*sizeof(int)) -
+	   offsets.size()*sizeof(int));
+  os.write((const char*) targets.data(),targets.size()*sizeof(int));
+}
+
+
+
+MSLGraph* MSLRoadmapFile::MakeGraph() const {
+  MSLGraph *g;
+  vector<MSLVertex*> vl;
+  int v,e;
+
+  g = new MSLGraph();
+  if (!IsOpen())
+    return g;
+
+  for (v = 0; v < NumVertices(); v++)
+    vl.push_back(g->AddVertex(State(v)));
+  for (v = 0; v < NumVertices(); v++)
+    for (e = EdgeBegin(v); e < EdgeEnd(v); e++)
+      g->AddEdge(vl[v],vl[Target(e)],Input(e),Time(e))->SetCost(Cost(e));
+
+  return g;
+}
+
+
+
+MSLVector MSLRoadmapFile::State(int v) const {
+  MSLVector x(StateDim());
+  int i;
+
+  for (i = 0; i < StateDim(); i++)
+    x[i] = States[v*StateDim()+i];
+
+  return x;
+}
+
+
+
+MSLVector MSLRoadmapFile::Input(int e) const {
+  MSLVector u(InputDim());
+  int i;
+
+  for (i = 0; i < InputDim(); i++)
+    u[i] = Inputs[e*InputDim()+i];
+
+  return u;
+}
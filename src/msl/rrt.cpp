@@ -18,6 +18,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <thread>
 
 #include "msl/rrt.h"
 #include "msl/defs.h"
@@ -58,6 +59,14 @@ void RRT::Reset() {
 }
 
 
+
+void RRT::UpdateGauges(size_t bytes) {
+  Planner::UpdateGauges(bytes);
+  if (!T2)
+    Gauges.GoalDist = GoalDist;
+}
+
+
 // Return the best new state in nx_best
 // success will be false if no action is collision free
 MSLVector RRT::SelectInput(const MSLVector &x1, const MSLVector &x2,
@@ -67,6 +76,7 @@ MSLVector RRT::SelectInput(const MSLVector &x1, const MSLVector &x2,
   MSLVector u_best,nx;
   list<MSLVector>::iterator u;
   double d,d_min;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SELECT_INPUT);
   success = false;
   d_min = (forward) ? P->Metric(x1,x2) : P->Metric(x2,x1);
   list<MSLVector> il = P->GetInputs(x1);
@@ -74,24 +84,24 @@ MSLVector RRT::SelectInput(const MSLVector &x1, const MSLVector &x2,
   if (Holonomic) { // Just do interpolation
     u_best = P->InterpolateState(x1,x2,0.1) - x1;
     u_best = u_best.norm(); // Normalize the direction
-    nx_best = P->Integrate(x1,u_best,PlannerDeltaT);
+    nx_best = Integrate(x1,u_best,PlannerDeltaT);
     SatisfiedCount++;
-    if (P->Satisfied(nx_best))
+    if (Satisfied(nx_best))
       success = true;
   }
   else {  // Nonholonomic (the more general case -- look at Inputs)
     forall(u,il) {
       if (forward)
-	nx = P->Integrate(x1,*u,PlannerDeltaT);
+	nx = Integrate(x1,*u,PlannerDeltaT);
       else
-	nx = P->Integrate(x1,*u,-PlannerDeltaT);
+	nx = Integrate(x1,*u,-PlannerDeltaT);
 
       d  = (forward) ? P->Metric(nx,x2): P->Metric(x2,nx);
 
       SatisfiedCount++;
 
       if ((d < d_min)&&(x1 != nx)) {
-	if (P->Satisfied(nx)) {
+	if (Satisfied(nx)) {
 	  d_min = d; u_best = *u; nx_best = nx; success = true;
 	}
       }
@@ -114,6 +124,7 @@ MSLNode* RRT::SelectNode(const MSLVector &x, MSLTree* t,
   double d,d_min;
   MSLNode *n_best;
   list<MSLNode*>::iterator n;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_NEAREST);
 
   d_min = INFINITY; d = 0.0;
 
@@ -151,18 +162,27 @@ bool RRT::Extend(const MSLVector &x,
   MSLNode *n_best;
   MSLVector nx,u_best;
   bool success;
+  long long start = Trace ? MSLTrace::Now() : 0;
 
   n_best = SelectNode(x,t,forward);
   u_best = SelectInput(n_best->State(),x,nx,success,forward);
   // nx gets next state
   if (success) {   // If a collision-free input was found
     // Extend the tree
-    nn = t->Extend(n_best, nx, u_best, PlannerDeltaT);
+    {
+      MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+      nn = t->Extend(n_best, nx, u_best, PlannerDeltaT);
+    }
 
     //cout << "n_best: " << n_best << "\n";
     //cout << "New node: " << nn << "\n";
   }
 
+  if (Trace)
+    Trace->Add(MSL_TRACE_EXTEND,start,
+	       success ? MSL_TRACE_OK : MSL_TRACE_COLLISION,n_best->ID(),
+	       success ? nn->ID() : -1,0,x);
+
   return success;
 }
 
@@ -175,9 +195,11 @@ bool RRT::Connect(const MSLVector &x,
 		  MSLNode *&nn, bool forward = true) {
   MSLNode *nn_prev,*n_best;
   MSLVector nx,nx_prev,u_best;
-  bool success;
+  bool success,isfree = false;
   double d,d_prev,clock;
   int steps;
+  long long start = Trace ? MSLTrace::Now() : 0;
+  MSLTraceResult result;
 
   n_best = SelectNode(x,t,forward);
   u_best = SelectInput(n_best->State(),x,nx,success,forward);
@@ -188,7 +210,7 @@ bool RRT::Connect(const MSLVector &x,
     nx_prev = nx; // Initialize
     nn = n_best;
     clock = PlannerDeltaT;
-    while ((P->Satisfied(nx))&&
+    while ((isfree = Satisfied(nx))&&
 	   (clock <= ConnectTimeLimit)&&
 	   (d <= d_prev))
       {
@@ -199,13 +221,13 @@ bool RRT::Connect(const MSLVector &x,
 	// Uncomment line below to select best action each time
 	//u_best = SelectInput(g.inf(nn),x,nx,success,forward);
 	if (Holonomic) {
-	    nx = P->Integrate(nx_prev,u_best,PlannerDeltaT);
+	    nx = Integrate(nx_prev,u_best,PlannerDeltaT);
 	}
 	else { // Nonholonomic
 	  if (forward)
-	    nx = P->Integrate(nx_prev,u_best,PlannerDeltaT);
+	    nx = Integrate(nx_prev,u_best,PlannerDeltaT);
 	  else
-	    nx = P->Integrate(nx_prev,u_best,-PlannerDeltaT);
+	    nx = Integrate(nx_prev,u_best,-PlannerDeltaT);
 	}
 	d = P->Metric(nx,x);
 	clock += PlannerDeltaT;
@@ -214,10 +236,25 @@ bool RRT::Connect(const MSLVector &x,
 	//nn = g.new_node(nx_prev); // Make a new node
 	//g.new_edge(nn_prev,nn,u_best);
       }
-    nn = t->Extend(n_best, nx_prev, u_best, steps*PlannerDeltaT);
+    {
+      MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+      nn = t->Extend(n_best, nx_prev, u_best, steps*PlannerDeltaT);
+    }
 
   }
 
+  if (Trace) {
+    // Why the last step stopped, in the order the loop tests
+    if (!success || !isfree)
+      result = MSL_TRACE_COLLISION;
+    else if (clock > ConnectTimeLimit)
+      result = MSL_TRACE_TIME_LIMIT;
+    else
+      result = MSL_TRACE_NO_PROGRESS;
+    Trace->Add(MSL_TRACE_CONNECT,start,result,n_best->ID(),
+	       success ? nn->ID() : -1,steps,x);
+  }
+
   return success;
 }
 
@@ -245,7 +282,8 @@ bool RRT::Plan()
   n_goal = n;
 
   GoalDist = P->Metric(n->State(),P->GoalState);
-  while ((i < NumNodes)&&(!GapSatisfied(n_goal->State(),P->GoalState))) {
+  while ((i < NumNodes)&&(!GapSatisfied(n_goal->State(),P->GoalState))&&
+	 (!Interrupted())) {
     if (Extend(ChooseState(),T,nn)) {
       d = P->Metric(nn->State(),P->GoalState);
       if (d < GoalDist) {  // Decrease if goal closer
@@ -256,6 +294,7 @@ bool RRT::Plan()
       }
     }
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -351,7 +390,8 @@ bool RRTCon::Plan()
   n_goal = n;
 
   GoalDist = P->Metric(n->State(),P->GoalState);
-  while ((i < NumNodes)&&(!GapSatisfied(n_goal->State(),P->GoalState))) {
+  while ((i < NumNodes)&&(!GapSatisfied(n_goal->State(),P->GoalState))&&
+	 (!Interrupted())) {
     if (Connect(ChooseState(),T,nn)) {
       d = P->Metric(nn->State(),P->GoalState);
       if (d < GoalDist) {  // Decrease if goal closer
@@ -362,6 +402,7 @@ bool RRTCon::Plan()
       }
     }
     i++;
+    PublishSnapshot();
   }
 
   CumulativePlanningTime += ((double)used_time(t));
@@ -439,7 +480,7 @@ bool RRTDual::Plan()
 
   i = 0;
   connected = false;
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     rx = ChooseState();
     Extend(rx,T,nn);
     Extend(rx,T2,nn2,false);  // false means reverse-time integrate
@@ -452,6 +493,7 @@ bool RRTDual::Plan()
     }
 
     i++;
+    PublishSnapshot();
   }
 
   if (!connected)
@@ -513,7 +555,7 @@ bool RRTExtExt::Plan()
 
   i = 0;
   connected = false;
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     if (Extend(ChooseState(),T,nn)) {
       if (Extend(nn->State(),T2,nn2,false)) {
 	i++;
@@ -538,6 +580,7 @@ bool RRTExtExt::Plan()
 	}
       }
     }
+    PublishSnapshot();
   }
 
   i++;
@@ -685,6 +728,7 @@ MSLVector RRTPolar::SelectInput(const MSLVector &x1, const MSLVector &x2,
   MSLVector u_best,nx;
   list<MSLVector>::iterator u;
   double d,dg,dmax,d_min;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SELECT_INPUT);
   success = false;
   d_min = INFINITY;
   dg  = P->Metric(x1,x2);
@@ -692,9 +736,9 @@ MSLVector RRTPolar::SelectInput(const MSLVector &x1, const MSLVector &x2,
   list<MSLVector> il = P->GetInputs(x1);
   forall(u,il) {
     //nx = P->Integrate(x1,u,PlannerDeltaT*sqrt(dg/dmax));  // Slow down near goal
-    nx = P->Integrate(x1,*u,PlannerDeltaT);
+    nx = Integrate(x1,*u,PlannerDeltaT);
     d  = P->Metric(nx,x2);
-    if ((d < d_min)&&(P->Satisfied(nx))&&(x1 != nx))
+    if ((d < d_min)&&(Satisfied(nx))&&(x1 != nx))
       {
 	d_min = d; u_best = *u; nx_best = nx; success = true;
       }
@@ -771,7 +815,7 @@ bool RRTExtCon::Plan()
 
   i = 0;
   connected = false;
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     if (Extend(ChooseState(),T,nn)) {
       // Update the goal RRT
       if (Connect(nn->State(),T2,nn2,false)) {
@@ -798,6 +842,7 @@ bool RRTExtCon::Plan()
       }
     }
     i++;
+    PublishSnapshot();
   }
 
   if (!connected)
@@ -852,7 +897,7 @@ bool RRTConCon::Plan()
   i = 0;
   connected = false;
 
-  while ((i < NumNodes) && (!connected)) {
+  while ((i < NumNodes) && (!connected) && (!Interrupted())) {
     if (Connect(ChooseState(),T,nn)) {
       // Update the goal RRT
       //cout << "nn: " << nn->State() << "  nn2: " << nn2->State() << "\n";
@@ -879,6 +924,7 @@ bool RRTConCon::Plan()
       }
     }
     i++;
+    PublishSnapshot();
   }
 
   if (!connected)
@@ -934,7 +980,7 @@ bool RRTBidirBalanced::Plan()
   MSLTree *pOtherTree  = T2;
   MSLVector target = P->GoalState;
 
-  while ((i < NumNodes) && (!connected))
+  while ((i < NumNodes) && (!connected) && (!Interrupted()))
   {
     if (Connect(target, pActiveTree, nn, bInitActive)) {
       if (Connect(nn->State(), pOtherTree, nn2, !bInitActive)) {
@@ -960,6 +1006,7 @@ bool RRTBidirBalanced::Plan()
       target = ChooseState();
     }
     i++;
+    PublishSnapshot();
   }
 
   if (!connected)
@@ -981,6 +1028,322 @@ bool RRTBidirBalanced::Plan()
 
 
 
+// *********************************************************************
+// *********************************************************************
+// CLASS:     RRTBidirParallel
+//
+// RRTConCon with each tree grown on its own thread.  New nodes are
+// passed to the other thread through a lock-free queue, and that
+// thread tries to Connect its own tree to them.
+// *********************************************************************
+// *********************************************************************
+
+RRTBidirParallel::RRTBidirParallel(Problem *p):RRTDual(p) {
+}
+
+
+
+void RRTBidirParallel::GrowTree(MSLTree *t, bool forward,
+				MSLRandomSource *rs,
+				MSLLockFreeQueue<MSLNode*> *out,
+				MSLLockFreeQueue<MSLNode*> *in)
+{
+  int i;
+  MSLNode *nn,*n;
+  bool claimed;
+  double last = LastSnapshotTime;
+
+  i = 0;
+  while ((i < NumNodes/2) && (!Connected) && (!Interrupted())) {
+    // Explore, and let the other tree know about the new node
+    if (Connect(RandomState(*rs),t,nn,forward))
+      out->Push(nn);
+    i++;
+
+    // Try to reach the nodes that the other tree has added
+    while ((!Connected) && (in->Pop(n))) {
+      if ((Connect(n->State(),t,nn,forward)) &&
+	  (GapSatisfied(nn->State(),n->State()))) {
+	claimed = false;
+	if (Connected.compare_exchange_strong(claimed,true)) {
+	  // Keep the pair ordered as (node in G, node in G2)
+	  ConnectNode = forward ? nn : n;
+	  ConnectNode2 = forward ? n : nn;
+	}
+      }
+    }
+
+    // Only this thread grows t, so it may walk the new nodes of t
+    PublishTreeSnapshot(t,forward ? SnapshotNodes : SnapshotNodes2,last);
+  }
+}
+
+
+
+bool RRTBidirParallel::Plan()
+{
+  MSLRandomSource R2;
+
+  // Keep track of time (processor time of both threads)
+  float t = used_time();
+
+  if (!T)
+    T = new MSLTree(P->InitialState);
+  if (!T2)
+    T2 = new MSLTree(P->GoalState);
+
+  Connected = false;
+  ConnectNode = ConnectNode2 = NULL;
+
+  // The goal tree gets its own stream
+  SplitRandomSource(R2);
+
+  {
+    MSLLockFreeQueue<MSLNode*> toT2,toT;
+
+    std::thread goalthread(&RRTBidirParallel::GrowTree,this,
+			   T2,false,&R2,&toT,&toT2);
+    GrowTree(T,true,&R,&toT2,&toT);
+    goalthread.join();
+  }
+  PublishSnapshot(true);
+
+  if (Connected) {
+    cout << "CONNECTED!!  MSLNodes: " <<
+      T->Size()+T2->Size() << "\n";
+    RecoverSolution(ConnectNode,ConnectNode2); // Defined in RRTDual
+  }
+  else
+    cout << "Failure to connect after " <<
+      T->Size()+T2->Size() << " nodes\n";
+
+  cout << "Collision Detection Calls: " << SatisfiedCount << "\n";
+
+  CumulativePlanningTime += ((double)used_time(t));
+  cout << "Planning Time: " << CumulativePlanningTime << "s\n";
+
+  return Connected;
+}
+
+
+
+// *********************************************************************
+// *********************************************************************
+// CLASS:     RRTCompact
+//
+// *********************************************************************
+// *********************************************************************
+
+RRTCompact::RRTCompact(Problem *p):RRTGoalBias(p) {
+  READ_PARAMETER_OR_DEFAULT(CompactBits,24);
+  CT = NULL;
+  SnapshotCompactNodes = 0;
+}
+
+
+
+RRTCompact::~RRTCompact() {
+  if (CT)
+    delete CT;
+}
+
+
+
+void RRTCompact::Reset() {
+  RRTGoalBias::Reset();
+
+  if (CT)
+    delete CT;
+  CT = NULL;
+}
+
+
+
+void RRTCompact::MemoryItems(list<MSLMemoryItem> &ml) {
+  MSLMemoryItem m;
+
+  RRTGoalBias::MemoryItems(ml);
+  if (CT) {
+    m = {"compact_tree",CT->MemoryUsage(),CT->MemoryUsage(),CT->Size()};
+    ml.push_back(m);
+  }
+}
+
+
+
+void RRTCompact::UpdateGauges(size_t bytes) {
+  RRTGoalBias::UpdateGauges(bytes);
+  if (CT)
+    Gauges.TreeNodes = CT->Size();
+}
+
+
+
+int RRTCompact::SelectCompactNode(const MSLVector &x) {
+  MSLVector y(P->StateDim);
+  double d,d_min;
+  int n,n_best;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_NEAREST);
+
+  d_min = INFINITY;
+  n_best = 0;
+  for (n = 0; n < CT->Size(); n++) {
+    CT->IndexState(n,y);
+    d = P->Metric(y,x);
+    if (d < d_min) {
+      d_min = d; n_best = n;
+    }
+  }
+
+  return n_best;
+}
+
+
+
+bool RRTCompact::Plan()
+{
+  int i,n,nn,n_goal;
+  double d;
+  bool success;
+  MSLVector x,nx,u_best,goalstate;
+  list<int> path;
+  list<int>::iterator pi;
+  list<MSLNode*> nodes;
+  MSLTree pt;
+  MSLNode *pn;
+
+  // Keep track of time
+  float t = used_time();
+
+  // Make the root node
+  if (!CT) {
+    CT = new MSLCompactTree(P->LowerState,P->UpperState,CompactBits);
+    CT->MakeRoot(P->InitialState);
+  }
+
+  i = 0;
+  n_goal = SelectCompactNode(P->GoalState);
+  goalstate = CT->State(n_goal);
+
+  GoalDist = P->Metric(goalstate,P->GoalState);
+  while ((i < NumNodes)&&(!GapSatisfied(goalstate,P->GoalState))&&
+	 (!Interrupted())) {
+    x = ChooseState();
+    n = SelectCompactNode(x);
+    u_best = SelectInput(CT->State(n),x,nx,success,true);
+    if (success) {
+      {
+	MSLPhaseTimer timer(Stats,MSL_PHASE_INSERT);
+	nn = CT->Extend(n,nx,u_best,PlannerDeltaT);
+      }
+      d = P->Metric(nx,P->GoalState);
+      if (d < GoalDist) {  // Decrease if goal closer
+	GoalDist = d;
+	goalstate = CT->State(nn);
+	BestState = goalstate;
+	n_goal = nn;
+      }
+    }
+    i++;
+    PublishSnapshot();
+  }
+
+  CumulativePlanningTime += ((double)used_time(t));
+  cout << "Planning Time: " << CumulativePlanningTime << "s\n";
+  cout << "Compact tree: " << CT->Size() << " nodes in "
+       << CT->MemoryUsage() << " bytes\n";
+
+  if (!GapSatisfied(goalstate,P->GoalState)) {
+    cout << "Failure\n";
+    return false;
+  }
+
+  // Copy just the solution into an ordinary tree to record it
+  cout << "Success\n";
+  path = CT->PathToRoot(n_goal);
+  path.reverse();
+  pi = path.begin();
+  pt.MakeRoot(CT->State(*pi));
+  pn = pt.Root();
+  for (pi++; pi != path.end(); pi++)
+    pn = pt.Extend(pn,CT->State(*pi),CT->Input(*pi),CT->Time(*pi));
+  nodes = pt.PathToRoot(pn);
+  nodes.reverse();
+  RecordSolution(nodes); // Write to Path and Policy
+
+  return true;
+}
+
+
+
+void RRTCompact::RecordPartialSolution()
+{
+  list<int> path;
+  list<int>::iterator pi;
+  MSLVector y(P->StateDim);
+  double d,bestd;
+  int n,best;
+
+  PartialPath.clear();
+  if ((!CT) || (CT->Size() == 0))
+    return;
+
+  best = 0;
+  bestd = INFINITY;
+  for (n = 0; n < CT->Size(); n++) {
+    CT->IndexState(n,y);
+    d = P->Metric(y,P->GoalState);
+    if (d < bestd) {
+      bestd = d;
+      best = n;
+    }
+  }
+
+  BestState = CT->State(best);
+  path = CT->PathToRoot(best);
+  path.reverse();
+  forall(pi,path)
+    PartialPath.push_back(CT->State(*pi));
+}
+
+
+
+void RRTCompact::CollectSnapshotEdges(list<MSLVector> &el) {
+  MSLVector x(P->StateDim),y(P->StateDim);
+  int n;
+
+  if ((!CT) || (SnapshotCompactNodes > CT->Size()))
+    SnapshotCompactNodes = 0;  // The tree was replaced
+  if (!CT)
+    return;
+
+  for (n = (SnapshotCompactNodes > 0) ? SnapshotCompactNodes : 1;
+       n < CT->Size(); n++) {
+    CT->IndexState(CT->Parent(n),x);
+    CT->IndexState(n,y);
+    el.push_back(x);
+    el.push_back(y);
+  }
+  SnapshotCompactNodes = CT->Size();
+}
+
+
+
+void RRTCompact::MakeTree() {
+  if (T)
+    delete T;
+  T = CT ? CT->MakeTree() : NULL;
+}
+
+
+
+void RRTCompact::WriteGraphs(ofstream &fout) {
+  MakeTree();
+  RRTGoalBias::WriteGraphs(fout);
+}
+
+
+
 // *********************************************************************
 // *********************************************************************
 // CLASS:     RandomTree
@@ -1010,6 +1373,7 @@ MSLVector RandomTree::SelectInput(const MSLVector &x1, const MSLVector &x2,
   list<MSLVector> il;
   int k;
   MSLVector u_best;
+  MSLPhaseTimer timer(Stats,MSL_PHASE_SELECT_INPUT);
 
   il = P->GetInputs(x1);
   R >> r;
@@ -1021,7 +1385,7 @@ MSLVector RandomTree::SelectInput(const MSLVector &x1, const MSLVector &x2,
   //u_best = il.inf(il[k]);
   u_best = il.front();
 
-  nx_best = P->Integrate(x1,u_best,PlannerDeltaT);
+  nx_best = Integrate(x1,u_best,PlannerDeltaT);
   SatisfiedCount++;
 
   return u_best;
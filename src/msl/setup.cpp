@@ -30,11 +30,17 @@
 #include "msl/geom.h"
 #include "msl/geom_pqp.h"
 
+// Include all planners
+#include "msl/rrt.h"
+#include "msl/rcrrt.h"
+#include "msl/prm.h"
+#include "msl/fdp.h"
+
 #include "msl/util.h"
 
 #include "msl/defs.h"
 
-#include "msl_gui/setup.h"
+#include "msl/setup.h"
 
 #define MAKE_MODEL(_m)  if (is_file(path+""#_m"")) m = new _m(path);
 #define MAKE_GEOM(_g)  if (is_file(path+""#_g"")) g = new _g(path);
@@ -94,3 +100,30 @@ void SetupProblem(Model *&m, Geom *&g, string path) {
     g = new GeomPQP2DRigid(path);
 
 }
+
+
+
+// The same planners as the Planner menu of GuiPlanner
+#define FORALL_PLANNERS(_P) \
+  _P(RRT) _P(RRTGoalBias) _P(RRTCon) _P(RRTDual) _P(RRTExtExt) \
+  _P(RRTExtCon) _P(RRTConCon) _P(RCRRT) _P(RCRRTExtExt) \
+  _P(RRTBidirBalanced) _P(RRTBidirParallel) _P(RRTCompact) \
+  _P(PRM) _P(FDP) _P(FDPStar) _P(FDPBestFirst) _P(FDPBi) _P(FDPParallel)
+
+#define MAKE_PLANNER(_p)  if (name == #_p) return new _p(p);
+#define NAME_PLANNER(_p)  names.push_back(#_p);
+
+Planner* MakePlanner(const string &name, Problem *p) {
+  FORALL_PLANNERS(MAKE_PLANNER);
+
+  return NULL;
+}
+
+
+list<string> PlannerNames() {
+  list<string> names;
+
+  FORALL_PLANNERS(NAME_PLANNER);
+
+  return names;
+}
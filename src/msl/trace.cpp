@@ -0,0 +1,243 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <string.h>
+#include <fstream>
+
+#include "msl/trace.h"
+
+
+// The header of a binary trace
+struct MSLTraceHeader {
+  char Magic[8];
+  int Version;
+  int MaxDim;
+  int EventSize;
+  int Pad;
+  long long Count;
+  long long Dropped;
+};
+
+
+
+MSLTrace::MSLTrace(int capacity) {
+  unsigned long long n = 1;
+
+  while ((long long) n < capacity)
+    n <<= 1;
+  Events.resize(n);
+  Mask = n - 1;
+  Clear();
+}
+
+
+
+int MSLTrace::ThreadNumber() {
+  static std::atomic<int> next(0);
+  static thread_local int number = -1;
+
+  if (number < 0)
+    number = next++;
+  return number;
+}
+
+
+
+void MSLTrace::Add(MSLTraceKind kind, long long start, MSLTraceResult result,
+		   int node, int newnode, int count, const MSLVector &sample) {
+  long long now = Now();
+  MSLTraceEvent &e =
+    Events[Head.fetch_add(1,std::memory_order_relaxed) & Mask];
+  int i;
+
+  e.Start = start - Origin;
+  e.Duration = now - start;
+  e.Kind = kind;
+  e.Result = result;
+  e.Thread = ThreadNumber();
+  e.Node = node;
+  e.NewNode = newnode;
+  e.Count = count;
+  e.Dim = (sample.dim() < MSL_TRACE_MAX_DIM) ? sample.dim() :
+    MSL_TRACE_MAX_DIM;
+  e.Pad = 0;
+  for (i = 0; i < e.Dim; i++)
+    e.Sample[i] = sample[i];
+}
+
+
+
+void MSLTrace::Clear() {
+  Head = 0;
+  Lost = 0;
+  Origin = Now();
+}
+
+
+
+long long MSLTrace::Size() const {
+  unsigned long long h = Head;
+
+  return (h > Mask) ? Mask + 1 : h;
+}
+
+
+
+long long MSLTrace::Dropped() const {
+  return Head - Size() + Lost;
+}
+
+
+
+vector<MSLTraceEvent> MSLTrace::Contents() const {
+  vector<MSLTraceEvent> ev;
+  unsigned long long i,h = Head;
+
+  ev.reserve(Size());
+  for (i = h - Size(); i < h; i++)
+    ev.push_back(Events[i & Mask]);
+
+  return ev;
+}
+
+
+
+const char* MSLTrace::KindName(int kind) {
+  static const char *names[] = {
+    "Extend", "Connect", "Sample", "Expand", "Select"
+  };
+
+  return ((kind >= 0) && (kind <= MSL_TRACE_SELECT)) ? names[kind] :
+    "Unknown";
+}
+
+
+
+const char* MSLTrace::ResultName(int result) {
+  static const char *names[] = {
+    "ok", "collision", "no_progress", "time_limit", "visited", "not_found"
+  };
+
+  return ((result >= 0) && (result <= MSL_TRACE_NOT_FOUND)) ?
+    names[result] : "unknown";
+}
+
+
+
+void MSLTrace::WriteChrome(ostream &os) const {
+  vector<MSLTraceEvent> ev = Contents();
+  size_t i;
+  int j;
+
+  os << "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped\": "
+     << Dropped() << "},\n\"traceEvents\": [\n";
+  for (i = 0; i < ev.size(); i++) {
+    const MSLTraceEvent &e = ev[i];
+    os << "{\"name\": \"" << KindName(e.Kind)
+       << "\", \"cat\": \"msl\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+       << e.Thread << ", \"ts\": " << e.Start / 1000.0
+       << ", \"dur\": " << e.Duration / 1000.0
+       << ", \"args\": {\"result\": \"" << ResultName(e.Result)
+       << "\", \"node\": " << e.Node << ", \"new_node\": " << e.NewNode
+       << ", \"count\": " << e.Count << ", \"sample\": [";
+    for (j = 0; j < e.Dim; j++)
+      os << ((j > 0) ? ", " : "") << e.Sample[j];
+    os << "]}}" << ((i+1 < ev.size()) ? ",\n" : "\n");
+  }
+  os << "]}\n";
+}
+
+
+
+void MSLTrace::WriteBinary(ostream &os) const {
+  vector<MSLTraceEvent> ev = Contents();
+  MSLTraceHeader h;
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.Magic,MSL_TRACE_MAGIC,8);
+  h.Version = MSL_TRACE_VERSION;
+  h.MaxDim = MSL_TRACE_MAX_DIM;
+  h.EventSize = sizeof(MSLTraceEvent);
+  h.Count = ev.size();
+  h.Dropped = Dropped();
+  os.write((const char*) &h,sizeof(h));
+  if (!ev.empty())
+    os.write((const char*) &ev[0],ev.size() * sizeof(MSLTraceEvent));
+}
+
+
+
+bool MSLTrace::ReadBinary(istream &is) {
+  MSLTraceHeader h;
+  vector<MSLTraceEvent> ev;
+  unsigned long long n = 1;
+  streamoff here,end;
+  long long i;
+
+  if (!is.read((char*) &h,sizeof(h)) ||
+      (memcmp(h.Magic,MSL_TRACE_MAGIC,8) != 0) ||
+      (h.Version != MSL_TRACE_VERSION) || (h.MaxDim != MSL_TRACE_MAX_DIM) ||
+      (h.EventSize != (int) sizeof(MSLTraceEvent)) || (h.Count < 0) ||
+      (h.Dropped < 0))
+    return false;
+
+  // The events must all be in the stream before any room is made for
+  // them, so that a truncated or corrupt file fails here
+  here = is.tellg();
+  is.seekg(0,ios::end);
+  end = is.tellg();
+  is.seekg(here);
+  if ((here < 0) || (end < 0) ||
+      (h.Count > (end - here) / (streamoff) sizeof(MSLTraceEvent)))
+    return false;
+
+  ev.resize(h.Count);
+  if ((h.Count > 0) &&
+      !is.read((char*) &ev[0],h.Count * sizeof(MSLTraceEvent)))
+    return false;
+  for (i = 0; i < h.Count; i++)
+    if ((ev[i].Dim < 0) || (ev[i].Dim > MSL_TRACE_MAX_DIM))
+      return false;
+
+  while ((long long) n < h.Count)
+    n <<= 1;
+  if (n > Mask + 1) {
+    Events.resize(n);
+    Mask = n - 1;
+  }
+  copy(ev.begin(),ev.end(),Events.begin());
+  Head = h.Count;
+  Lost = h.Dropped;
+
+  return true;
+}
+
+
+
+bool MSLTrace::Write(const string &fname, bool binary) const {
+  ofstream fout(fname.c_str(),binary ? ios::out|ios::binary : ios::out);
+
+  if (!fout)
+    return false;
+  if (binary)
+    WriteBinary(fout);
+  else
+    WriteChrome(fout);
+
+  return (bool) fout;
+}
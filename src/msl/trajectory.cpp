@@ -0,0 +1,119 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include "msl/trajectory.h"
+#include "msl/problem.h"
+
+
+MSLTrajectoryWriter::MSLTrajectoryWriter(ostream &os, Problem *p):Out(os) {
+  P = p;
+  Binary = false;
+  ResampleDeltaT = 0.0;
+  StateDim = InputDim = 0;
+  HavePrevious = false;
+}
+
+
+
+void MSLTrajectoryWriter::Begin(int statedim, int inputdim) {
+  int version = MSL_TRAJECTORY_VERSION;
+
+  StateDim = statedim;
+  InputDim = inputdim;
+  HavePrevious = false;
+
+  if (Binary) {
+    Out.write(MSL_TRAJECTORY_MAGIC,8);
+    Out.write((const char*) &version,sizeof(int));
+    Out.write((const char*) &StateDim,sizeof(int));
+    Out.write((const char*) &InputDim,sizeof(int));
+  }
+  else
+    Out << "# MSL trajectory " << StateDim << " " << InputDim << "\n";
+  Out.flush();
+}
+
+
+
+void MSLTrajectoryWriter::Write(double t, const MSLVector &x,
+				const MSLVector &u) {
+  double v;
+  int i;
+
+  if (Binary) {
+    Out.write((const char*) &t,sizeof(double));
+    for (i = 0; i < StateDim; i++) {
+      v = (i < x.dim()) ? x[i] : 0.0;
+      Out.write((const char*) &v,sizeof(double));
+    }
+    for (i = 0; i < InputDim; i++) {
+      v = (i < u.dim()) ? u[i] : 0.0;
+      Out.write((const char*) &v,sizeof(double));
+    }
+  }
+  else {
+    Out << t;
+    for (i = 0; i < StateDim; i++)
+      Out << " " << ((i < x.dim()) ? x[i] : 0.0);
+    for (i = 0; i < InputDim; i++)
+      Out << " " << ((i < u.dim()) ? u[i] : 0.0);
+    Out << "\n";
+  }
+}
+
+
+
+void MSLTrajectoryWriter::Sample(double t, const MSLVector &x,
+				 const MSLVector &u) {
+  double lambda;
+
+  if ((ResampleDeltaT <= 0.0) || !P) {
+    Write(t,x,u);
+    Out.flush();
+    return;
+  }
+
+  // Fill in the grid times between the previous sample and this one
+  if (!HavePrevious)
+    NextTime = t;
+  else {
+    while (NextTime < t) {
+      lambda = (t > PreviousTime) ?
+	(NextTime - PreviousTime) / (t - PreviousTime) : 0.0;
+      Write(NextTime,P->InterpolateState(Previous[0],x,lambda),Previous[1]);
+      NextTime += ResampleDeltaT;
+    }
+    Out.flush();
+  }
+
+  HavePrevious = true;
+  PreviousTime = t;
+  Previous.clear();
+  Previous.push_back(x);
+  Previous.push_back(u);
+}
+
+
+
+void MSLTrajectoryWriter::End() {
+  // The final state is always written, on the grid or not
+  if ((ResampleDeltaT > 0.0) && P && HavePrevious)
+    Write(PreviousTime,Previous[0],Previous[1]);
+  HavePrevious = false;
+  Out.flush();
+}
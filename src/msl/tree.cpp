@@ -17,7 +17,12 @@
 //----------------------------------------------------------------------
 
 
+#include <string.h>
+#include <vector>
+#include <unordered_map>
+
 #include "msl/tree.h"
+#include "msl/defs.h"
 
 // *********************************************************************
 // *********************************************************************
@@ -113,53 +118,176 @@ ostream& operator<< (ostream& os, const MSLTree& T) {
 istream& operator>> (istream& is, MSLTree & T) {
   int i,nid,pid,tsize;
   MSLVector x,u;
-  MSLNode *pnode,*n; // Parent node
+  MSLNode *n;
+  list<MSLNode*>::iterator ni;
+  vector<MSLNode*> byid;
+  vector<int> parents;
 
   T.Clear();
 
-  is >> tsize;
+  is >> ws;
+  if (is.peek() == MSL_TREE_MAGIC[0]) {
+    if (!T.ReadBinary(is))
+      cout << "Error reading a binary tree\n";
+    return is;
+  }
+
+  if (!(is >> tsize))
+    return is;
   cout << "Loading a tree that has " << tsize << " nodes\n";
+
+  // Make all of the nodes, then link each to its parent by id
+  byid.assign(tsize,(MSLNode*) NULL);
   for (i = 0; i < tsize; i++) {
     is >> nid >> pid >> x >> u;
     if (pid == -1) {
       T.MakeRoot(x);
-      T.Root()->SetID(0);
-    }
-    else {
-      n = T.Extend(T.Root(),x,u);
-      n->SetCost((double)pid);
-      n->SetID(nid);
+      n = T.Root();
+      nid = 0;
     }
+    else
+      n = T.Extend(NULL,x,u);
+    n->SetID(nid);
+    if ((nid >= 0) && (nid < tsize))
+      byid[nid] = n;
+    parents.push_back(pid);
+  }
 
-    list<MSLNode*> vl;
-    vl = T.nodes;
-    list<MSLNode*>::iterator nx;
-    for (nx = vl.begin(); nx != vl.end(); nx++) {
-      n = *nx;
-      if (n->ID() != 0) {
-	pid = (int)(n->Cost());  // Use the cost as a parent id (horrible)
-	pnode = T.FindNode(pid);
-	n->SetParent(pnode);
-      }
-    }
+  i = 0;
+  forall(ni,T.nodes) {
+    pid = parents[i++];
+    if ((pid >= 0) && (pid < tsize))
+      (*ni)->SetParent(byid[pid]);
   }
 
   return is;
 }
 
 
+
+void MSLTree::WriteBinary(ostream& os) const {
+  list<MSLNode*>::const_iterator n;
+  unordered_map<const MSLNode*,int> index;
+  vector<int> parents;
+  vector<double> times,states,inputs;
+  int i,j,statedim,inputdim,version,num;
+
+  num = nodes.size();
+  statedim = inputdim = 0;
+  i = 0;
+  forall(n,nodes) {
+    index[*n] = i++;
+    statedim = max(statedim,(*n)->state.dim());
+    inputdim = max(inputdim,(*n)->input.dim());
+  }
+
+  // Lay out each block contiguously (missing entries are zero)
+  states.assign(num*statedim,0.0);
+  inputs.assign(num*inputdim,0.0);
+  i = 0;
+  forall(n,nodes) {
+    parents.push_back((*n)->parent ? index[(*n)->parent] : -1);
+    times.push_back((*n)->time);
+    for (j = 0; j < (*n)->state.dim(); j++)
+      states[i*statedim+j] = (*n)->state[j];
+    for (j = 0; j < (*n)->input.dim(); j++)
+      inputs[i*inputdim+j] = (*n)->input[j];
+    i++;
+  }
+
+  version = MSL_TREE_VERSION;
+  os.write(MSL_TREE_MAGIC,sizeof(MSL_TREE_MAGIC));
+  os.write((const char*) &version,sizeof(int));
+  os.write((const char*) &num,sizeof(int));
+  os.write((const char*) &statedim,sizeof(int));
+  os.write((const char*) &inputdim,sizeof(int));
+  os.write((const char*) parents.data(),num*sizeof(int));
+  os.write((const char*) times.data(),num*sizeof(double));
+  os.write((const char*) states.data(),states.size()*sizeof(double));
+  os.write((const char*) inputs.data(),inputs.size()*sizeof(double));
+}
+
+
+
+bool MSLTree::ReadBinary(istream& is) {
+  char magic[sizeof(MSL_TREE_MAGIC)];
+  int i,j,statedim,inputdim,version,num;
+  vector<int> parents;
+  vector<double> times,states,inputs;
+  vector<MSLNode*> byindex;
+  MSLVector x,u;
+  MSLNode *n;
+
+  Clear();
+
+  is.read(magic,sizeof(magic));
+  if ((!is) || (memcmp(magic,MSL_TREE_MAGIC,sizeof(magic)) != 0))
+    return false;
+  is.read((char*) &version,sizeof(int));
+  is.read((char*) &num,sizeof(int));
+  is.read((char*) &statedim,sizeof(int));
+  is.read((char*) &inputdim,sizeof(int));
+  if ((!is) || (version != MSL_TREE_VERSION) || (num < 0) ||
+      (statedim < 0) || (inputdim < 0))
+    return false;
+
+  parents.resize(num);
+  times.resize(num);
+  states.resize(num*statedim);
+  inputs.resize(num*inputdim);
+  is.read((char*) parents.data(),num*sizeof(int));
+  is.read((char*) times.data(),num*sizeof(double));
+  is.read((char*) states.data(),states.size()*sizeof(double));
+  is.read((char*) inputs.data(),inputs.size()*sizeof(double));
+  if (!is)
+    return false;
+
+  cout << "Loading a tree that has " << num << " nodes\n";
+
+  x = MSLVector(statedim);
+  u = MSLVector(inputdim);
+  for (i = 0; i < num; i++) {
+    for (j = 0; j < statedim; j++)
+      x[j] = states[i*statedim+j];
+    if (parents[i] < 0) {
+      n = new MSLNode(NULL,x,MSLVector(),times[i]);
+      if (!root)
+	root = n;
+    }
+    else {
+      for (j = 0; j < inputdim; j++)
+	u[j] = inputs[i*inputdim+j];
+      n = new MSLNode(NULL,x,u,times[i]);
+    }
+    n->id = i;
+    AddNode(n);
+    byindex.push_back(n);
+  }
+  size = num;
+
+  for (i = 0; i < num; i++)
+    if ((parents[i] >= 0) && (parents[i] < num))
+      byindex[i]->parent = byindex[parents[i]];
+
+  return true;
+}
+
+
+
 MSLTree::MSLTree() {
   root = NULL;
   size = 0;
+  bytes = peakbytes = 0;
 }
 
 
 MSLTree::MSLTree(const MSLVector &x) {
   MSLVector u;
 
+  bytes = peakbytes = 0;
   root = new MSLNode(NULL,x,u,0.0);
   root->id = 0;
-  nodes.push_back(root);
+  AddNode(root);
   size = 1;
 }
 
@@ -167,9 +295,10 @@ MSLTree::MSLTree(const MSLVector &x) {
 MSLTree::MSLTree(const MSLVector &x, void* nodeinfo) {
   MSLVector u;
 
+  bytes = peakbytes = 0;
   root = new MSLNode(NULL,x,u,0.0,nodeinfo);
   root->id = 0;
-  nodes.push_back(root);
+  AddNode(root);
   size = 1;
 }
 
@@ -185,7 +314,7 @@ void MSLTree::MakeRoot(const MSLVector &x) {
   if (!root) {
     root = new MSLNode(NULL,x,u,0.0);
     root->id = 0;
-    nodes.push_back(root);
+    AddNode(root);
   }
   else
     cout << "Root already made.  MakeRoot has no effect.\n";
@@ -197,9 +326,9 @@ MSLNode* MSLTree::Extend(MSLNode *parent, const MSLVector &x, const MSLVector &u
   MSLNode *nn;
 
   nn = new MSLNode(parent, x, u);
-  nn->id = size;
-  nodes.push_back(nn);
-  size++;
+  nn->id = Size();
+  AddNode(nn);
+  size.store(nn->id + 1,memory_order_relaxed);
 
   return nn;
 }
@@ -212,9 +341,9 @@ MSLNode* MSLTree::Extend(MSLNode *parent, const MSLVector &x,
   MSLNode *nn;
 
   nn = new MSLNode(parent, x, u, time);
-  nn->id = size;
-  nodes.push_back(nn);
-  size++;
+  nn->id = Size();
+  AddNode(nn);
+  size.store(nn->id + 1,memory_order_relaxed);
 
   return nn;
 }
@@ -226,9 +355,9 @@ MSLNode* MSLTree::Extend(MSLNode *parent, const MSLVector &x,
   MSLNode *nn;
 
   nn = new MSLNode(parent, x, u, time, pninfo);
-  nn->id = size;
-  nodes.push_back(nn);
-  size++;
+  nn->id = Size();
+  AddNode(nn);
+  size.store(nn->id + 1,memory_order_relaxed);
 
   return nn;
 }
@@ -270,4 +399,15 @@ void MSLTree::Clear() {
     delete *n;
   nodes.clear();
   root = NULL;
+  peakbytes.store(PeakMemoryUsage(),memory_order_relaxed);
+  bytes.store(0,memory_order_relaxed);
+}
+
+
+void MSLTree::AddNode(MSLNode *n) {
+  nodes.push_back(n);
+  // The node, its state and input, and its cell of the node list
+  bytes.store(MemoryUsage() + sizeof(MSLNode) +
+	      (n->state.dim() + n->input.dim())*sizeof(double) +
+	      sizeof(MSLNode*) + 2*sizeof(void*),memory_order_relaxed);
 }
@@ -28,7 +28,10 @@
 #include <time.h>
 #endif
 
+#include <chrono>
+
 #include "msl/util.h"
+#include "msl/bundle.h"
 
 float used_time()
 {
@@ -59,6 +62,20 @@ float used_time(float& T)
   return  T-t;
 }
 
+
+double wall_time()
+{
+  return std::chrono::duration<double>(
+	   std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+double wall_time(double& T)
+{ double t = T;
+  T = wall_time();
+  return  T-t;
+}
+
 /*
 ostream& operator<<(ostream& out, const list<string>& L)
 {
@@ -116,6 +133,11 @@ istream& operator>>(istream& in, list<int>& L)
 
 bool is_file(string fname)
 { struct stat stat_buf;
+  const MSLBundle *b;
+  string name;
+  // A directory's bundle, if it has one, stands in for its files
+  if ((b = MSLBundle::ForFile(fname,name)) != NULL)
+    return b->Contains(name);
   if (stat(fname.c_str(),&stat_buf) != 0) return false;
   return (stat_buf.st_mode & S_IFMT) == S_IFREG;
 }
@@ -0,0 +1,202 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+#include <string.h>
+
+#include "msl/vectorfile.h"
+
+
+MSLVectorFile::MSLVectorFile() {
+  Valid = false;
+  memset(&Header,0,sizeof(Header));
+}
+
+
+
+bool MSLVectorFile::Open(const string &fname) {
+  streamoff size;
+
+  Close();
+
+  File.open(fname.c_str(),ios::in|ios::binary);
+  if (!File)
+    return false;
+
+  File.seekg(0,ios::end);
+  size = File.tellg();
+  File.seekg(0,ios::beg);
+
+  File.read((char*) &Header,sizeof(Header));
+  if ((!File) ||
+      (memcmp(Header.Magic,MSL_VECTORFILE_MAGIC,
+	      sizeof(MSL_VECTORFILE_MAGIC)) != 0) ||
+      (Header.Version != MSL_VECTORFILE_VERSION) ||
+      (Header.Dim < 0) || (Header.Count < 0)) {
+    Close();
+    return false;
+  }
+
+  // The vectors must all be in the file, so that a truncated or corrupt
+  // one fails here rather than by allocating for a count it lacks.
+  // Divide instead of multiplying, which could overflow.
+  size -= sizeof(Header);
+  if (((Header.Dim == 0) && (Header.Count > 0)) ||
+      ((Header.Dim > 0) &&
+       (Header.Count > size / (streamoff) (sizeof(double) * Header.Dim)))) {
+    Close();
+    return false;
+  }
+
+  Valid = true;
+  return true;
+}
+
+
+
+void MSLVectorFile::Close() {
+  if (File.is_open())
+    File.close();
+  File.clear();
+  memset(&Header,0,sizeof(Header));
+  Valid = false;
+}
+
+
+
+bool MSLVectorFile::Get(long long i, MSLVector &x) {
+  vector<double> v(Header.Dim);
+  int j;
+
+  if ((!Valid) || (i < 0) || (i >= Header.Count))
+    return false;
+
+  File.clear();
+  File.seekg(sizeof(Header) + (streamoff) (sizeof(double) * Header.Dim * i));
+  File.read((char*) v.data(),sizeof(double) * Header.Dim);
+  if (!File)
+    return false;
+
+  x = MSLVector(Header.Dim);
+  for (j = 0; j < Header.Dim; j++)
+    x[j] = v[j];
+
+  return true;
+}
+
+
+
+// Read all the doubles at once; the caller makes the vectors
+static bool ReadBlock(ifstream &f, const MSLVectorFileHeader &h,
+		      vector<double> &data) {
+  data.resize(h.Dim * h.Count);
+  f.clear();
+  f.seekg(sizeof(h));
+  f.read((char*) data.data(),sizeof(double) * data.size());
+  return (bool) f;
+}
+
+
+
+bool MSLVectorFile::ReadAll(vector<MSLVector> &vl) {
+  vector<double> data;
+  long long i;
+  int j;
+
+  vl.clear();
+  if ((!Valid) || (!ReadBlock(File,Header,data)))
+    return false;
+
+  vl.resize(Header.Count,MSLVector(Header.Dim));
+  for (i = 0; i < Header.Count; i++)
+    for (j = 0; j < Header.Dim; j++)
+      vl[i][j] = data[i*Header.Dim + j];
+
+  return true;
+}
+
+
+
+bool MSLVectorFile::ReadAll(list<MSLVector> &vl) {
+  vector<double> data;
+  MSLVector x(Header.Dim);
+  long long i;
+  int j;
+
+  vl.clear();
+  if ((!Valid) || (!ReadBlock(File,Header,data)))
+    return false;
+
+  for (i = 0; i < Header.Count; i++) {
+    for (j = 0; j < Header.Dim; j++)
+      x[j] = data[i*Header.Dim + j];
+    vl.push_back(x);
+  }
+
+  return true;
+}
+
+
+
+// Write the header and the vectors from first to last
+template<class I> static bool WriteVectors(ostream &os, I first, I last,
+					   long long count) {
+  MSLVectorFileHeader h;
+  vector<double> row;
+  int j;
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.Magic,MSL_VECTORFILE_MAGIC,sizeof(MSL_VECTORFILE_MAGIC));
+  h.Version = MSL_VECTORFILE_VERSION;
+  h.Dim = (count > 0) ? first->dim() : 0;
+  h.Count = count;
+  os.write((const char*) &h,sizeof(h));
+
+  row.resize(h.Dim);
+  for (; first != last; first++) {
+    if (first->dim() != h.Dim)
+      return false;
+    for (j = 0; j < h.Dim; j++)
+      row[j] = (*first)[j];
+    os.write((const char*) row.data(),sizeof(double) * h.Dim);
+  }
+
+  return (bool) os;
+}
+
+
+
+bool MSLVectorFile::Write(ostream &os, const vector<MSLVector> &vl) {
+  return WriteVectors(os,vl.begin(),vl.end(),vl.size());
+}
+
+
+
+bool MSLVectorFile::Write(ostream &os, const list<MSLVector> &vl) {
+  return WriteVectors(os,vl.begin(),vl.end(),vl.size());
+}
+
+
+
+bool MSLVectorFile::IsVectorFile(const string &fname) {
+  ifstream fin(fname.c_str(),ios::in|ios::binary);
+  char magic[8];
+
+  fin.read(magic,sizeof(magic));
+  return fin && (memcmp(magic,MSL_VECTORFILE_MAGIC,
+			sizeof(MSL_VECTORFILE_MAGIC)) == 0);
+}
@@ -55,11 +55,14 @@ MSLPlannerWindow::MSLPlannerWindow(GuiPlanner* gp):FXMainWindow(gp,"Motion Strat
     new FXMenuCommand(plannermenu,"RCRRT",NULL,this,GID_RCRRT);
     new FXMenuCommand(plannermenu,"RCRRTExtExt",NULL,this,GID_RCRRTEXTEXT);
     new FXMenuCommand(plannermenu,"RRTBidirBalanced",NULL,this,GID_RRTBIDIRBALANCED);
+    new FXMenuCommand(plannermenu,"RRTBidirParallel",NULL,this,GID_RRTBIDIRPARALLEL);
+    new FXMenuCommand(plannermenu,"RRTCompact",NULL,this,GID_RRTCOMPACT);
     new FXMenuCommand(plannermenu,"PRM",NULL,this,GID_PRM);
     new FXMenuCommand(plannermenu,"FDP",NULL,this,GID_FDP);
     new FXMenuCommand(plannermenu,"FDPStar",NULL,this,GID_FDPSTAR);
     new FXMenuCommand(plannermenu,"FDPBestFirst",NULL,this,GID_FDPBESTFIRST);
     new FXMenuCommand(plannermenu,"FDPBi",NULL,this,GID_FDPBI);
+    new FXMenuCommand(plannermenu,"FDPParallel",NULL,this,GID_FDPPARALLEL);
   new FXMenuTitle(menubar,"&Planner",NULL,plannermenu);
 
   loadmenu=new FXMenuPane(this);
@@ -84,6 +87,7 @@ MSLPlannerWindow::MSLPlannerWindow(GuiPlanner* gp):FXMainWindow(gp,"Motion Strat
   buttonbar=new FXMenuBar(this,LAYOUT_SIDE_TOP|LAYOUT_FILL_X);
   new FXButton(buttonbar,"&Construct",NULL,this,GID_CONSTRUCT,FRAME_RAISED|FRAME_THICK|LAYOUT_FILL_X);
   new FXButton(buttonbar,"P&lan",NULL,this,GID_PLAN,FRAME_RAISED|FRAME_THICK|LAYOUT_FILL_X);
+  new FXButton(buttonbar,"S&top",NULL,this,GID_STOP,FRAME_RAISED|FRAME_THICK|LAYOUT_FILL_X);
   new FXButton(buttonbar,"C&lear",NULL,this,GID_CLEAR_GRAPHS,FRAME_RAISED|FRAME_THICK|LAYOUT_FILL_X);
   new FXButton(buttonbar,"&Quit",NULL,this,GID_DONE,FRAME_RAISED|FRAME_THICK|LAYOUT_FILL_X);
 
@@ -157,6 +161,9 @@ MSLPlannerWindow::~MSLPlannerWindow(){
 // Timer
 long MSLPlannerWindow::onCmdTimer(FXObject*,FXSelector,void*) {
 
+  // Show what the planner has done since the last tick
+  GP->UpdateProgress();
+
   // Reset timer for next time
   //  getApp()->addTimeout(80,this,FXMainWindow::ID_LAST);
   getApp()->addTimeout(this,FXMainWindow::ID_LAST,80);
@@ -352,6 +359,12 @@ void MSLPlotWindow::drawPage(FXDC& dc,FXint w,FXint h,
   tranx = tx-1.0 * scalex * GP->Pl->P->LowerState[indexx];
   trany = ty+h-1.0 * scaley * GP->Pl->P->LowerState[indexy];
 
+  // The path and graphs are still changing while the planner runs
+  if (GP->Working) {
+    dc.setLineWidth(lw);
+    return;
+  }
+
   // Show path (if it exists)
   dc.setForeground(FXRGB(200,0,0));
   dc.setLineWidth(2);
@@ -440,16 +453,29 @@ GuiPlanner::GuiPlanner(Render *render, Planner *planner):Gui(render) {
   DrawIndexX = 0;
   DrawIndexY = 1;
 
+  Working = false;
+  WorkerDone = false;
+  WorkerPlanning = false;
+  PlanSucceeded = false;
+
   if (!render)
     cout << "ERROR: Renderer no defined\n";
 
   FilePath = Pl->P->FilePath;
+  BinaryFrames = is_file(FilePath + "BinaryFrames");
 
   CreateMenuWindow();
 }
 
 
 
+GuiPlanner::~GuiPlanner() {
+  Cancel.Cancel();
+  JoinPlanner();
+}
+
+
+
 void GuiPlanner::Init() {
   list<MSLVector> tpath;
 
@@ -474,6 +500,10 @@ void GuiPlanner::Init() {
     ButtonHandle(GID_RCRRTEXTEXT);
   if (is_file(Pl->P->FilePath + "RRTBidirBalanced"))
     ButtonHandle(GID_RRTBIDIRBALANCED);
+  if (is_file(Pl->P->FilePath + "RRTBidirParallel"))
+    ButtonHandle(GID_RRTBIDIRPARALLEL);
+  if (is_file(Pl->P->FilePath + "RRTCompact"))
+    ButtonHandle(GID_RRTCOMPACT);
   if (is_file(Pl->P->FilePath + "PRM"))
     ButtonHandle(GID_PRM);
   if (is_file(Pl->P->FilePath + "FDP"))
@@ -484,6 +514,8 @@ void GuiPlanner::Init() {
     ButtonHandle(GID_FDPBESTFIRST);
   if (is_file(Pl->P->FilePath + "FDPBi"))
     ButtonHandle(GID_FDPBI);
+  if (is_file(Pl->P->FilePath + "FDPParallel"))
+    ButtonHandle(GID_FDPPARALLEL);
 
   Gui::Init();
 
@@ -522,6 +554,8 @@ void GuiPlanner::CreateMenuWindow() {
 
 void GuiPlanner::ResetPlanner()
 {
+  Snapshot.Clear();
+  R->ClearGraphs();
   R->SetScene(new Scene(Pl->P,FilePath));
   Pl->Reset();
   Window->Restart();
@@ -532,24 +566,18 @@ void GuiPlanner::ButtonHandle(int b){
 
   if ((b > GID_RENDER_FIRST) && (b < GID_RENDER_LAST))
     R->ButtonHandle(b);
+  else if (Working && (b != GID_STOP) && (b != GID_DONE))
+    cout << "Planner is busy (press Stop to cancel)\n";
   else {
     switch (b) {
     case GID_CONSTRUCT: cout << "Construct\n";
-      Pl->Construct();
-      //U.DrawGraphs();
+      StartPlanner(false);
       break;
     case GID_PLAN: cout << "Plan\n";
-      if (Pl->Plan()) {
-	cout << "Making Animation Frames\n";
-	// Make the animation frames
-	if ((Pl->Path.size() >= 2)||
-	    (R->FrameList.size() > 0))
-	  {
-	  R->MakeAnimationFrames(Pl->Path,Pl->TimeList);
-	  }
-      }
-      //U.DrawPath();
-      //U.DrawGraphs();
+      StartPlanner(true);
+      break;
+    case GID_STOP: cout << "Stop\n";
+      Cancel.Cancel();
       break;
     case GID_CLEAR_GRAPHS: cout << "Clear Graphs\n";
       ResetPlanner();
@@ -576,6 +604,8 @@ void GuiPlanner::ButtonHandle(int b){
       ReadPath();
       break;
     case GID_DONE: cout << "Done\n";
+      Cancel.Cancel();
+      JoinPlanner();
       Finished = true;  // This should trigger leaving (for most renderers)
       break;
     case GID_TOGGLE_SHOWPATH: cout << "Toggle Show Path\n";
@@ -621,6 +651,14 @@ void GuiPlanner::ButtonHandle(int b){
       ResetPlanner();
       Pl = new RRTBidirBalanced(Pl->P);
       break;
+    case GID_RRTBIDIRPARALLEL: cout << "Switch to RRTBidirParallel Planner\n";
+      ResetPlanner();
+      Pl = new RRTBidirParallel(Pl->P);
+      break;
+    case GID_RRTCOMPACT: cout << "Switch to RRTCompact Planner\n";
+      ResetPlanner();
+      Pl = new RRTCompact(Pl->P);
+      break;
     case GID_PRM: cout << "Switch to PRM Planner\n";
       ResetPlanner();
       Pl = new PRM(Pl->P);
@@ -641,6 +679,10 @@ void GuiPlanner::ButtonHandle(int b){
       ResetPlanner();
       Pl = new FDPBi(Pl->P);
       break;
+    case GID_FDPPARALLEL: cout << "Switch to FDPParallel Planner\n";
+      ResetPlanner();
+      Pl = new FDPParallel(Pl->P);
+      break;
 
     default: cout << "Option " << b << " not implemented\n";
       break;
@@ -656,13 +698,79 @@ void GuiPlanner::HandleEvents() {
 
 
 
+void GuiPlanner::RunPlanner(bool plan) {
+  if (plan)
+    PlanSucceeded = (Pl->PlanWithin(0.0,&Cancel) == MSL_PLAN_SUCCESS);
+  else
+    Pl->ConstructWithin(0.0,&Cancel);
+  WorkerDone = true;
+}
+
+
+
+void GuiPlanner::StartPlanner(bool plan) {
+  if (Working)
+    return;
+
+  Cancel.Reset();
+  Snapshot.Clear();
+  R->ClearGraphs();
+  Pl->Snapshot = &Snapshot;
+  Pl->ResetSnapshot();
+
+  WorkerPlanning = plan;
+  PlanSucceeded = false;
+  WorkerDone = false;
+  Working = true;
+  Worker = std::thread(&GuiPlanner::RunPlanner,this,plan);
+}
+
+
+
+void GuiPlanner::JoinPlanner() {
+  if (Working) {
+    Worker.join();
+    Working = false;
+  }
+}
+
+
+
+void GuiPlanner::UpdateProgress() {
+  list<MSLVector> edges;
+  bool finished = false;
+
+  if (Working && WorkerDone) {
+    JoinPlanner();
+    Pl->PublishSnapshot(true);  // Pick up whatever was added last
+    cout << "Planner status: " << Pl->Status << "\n";
+    finished = true;
+  }
+
+  Snapshot.Take(edges);
+  if (edges.size() > 0)
+    R->AddGraphEdges(edges);
+
+  if (finished && WorkerPlanning && PlanSucceeded) {
+    cout << "Making Animation Frames\n";
+    // Make the animation frames
+    if ((Pl->Path.size() >= 2)||
+	(R->FrameList.size() > 0))
+      {
+	R->MakeAnimationFrames(Pl->Path,Pl->TimeList);
+      }
+  }
+}
+
+
+
 void GuiPlanner::WriteGraphs()
 {
   FXFileDialog dialog(Window,"Write Solution Path");
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("graphs");
   if (dialog.execute()) {
-    std::ofstream outfile(dialog.getFilename().text());
+    std::ofstream outfile(dialog.getFilename().text(),ios::out|ios::binary);
     if (outfile) {
       Pl->WriteGraphs(outfile);
       outfile.close();
@@ -678,7 +786,7 @@ void GuiPlanner::ReadGraphs()
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("graphs");
   if (dialog.execute()) {
-    std::ifstream infile(dialog.getFilename().text());
+    std::ifstream infile(dialog.getFilename().text(),ios::in|ios::binary);
     if (infile) {
       Pl->ReadGraphs(infile);
       infile.close();
@@ -694,9 +802,13 @@ void GuiPlanner::WriteAnimationFrames()
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("frames");
   if (dialog.execute()) {
-    std::ofstream outfile(dialog.getFilename().text());
+    std::ofstream outfile(dialog.getFilename().text(),ios::out|ios::binary);
     if (outfile) {
-      outfile << R->FrameList;
+      R->FinishAnimationFrames();
+      if (BinaryFrames)
+	MSLVectorFile::Write(outfile,R->FrameList);
+      else
+	outfile << R->FrameList;
       outfile.close();
     }
   }
@@ -709,9 +821,15 @@ void GuiPlanner::ReadAnimationFrames()
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("frames");
   if (dialog.execute()) {
+    MSLVectorFile vf;
     std::ifstream infile(dialog.getFilename().text());
     if (infile) {
-      infile >> R->FrameList;
+      R->StopAnimationFrames();
+      if (vf.Open(dialog.getFilename().text()))
+	vf.ReadAll(R->FrameList);
+      else
+	infile >> R->FrameList;
+      R->SetFramesLoaded();
       infile.close();
     }
   }
@@ -726,9 +844,12 @@ void GuiPlanner::WritePath()
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("path");
   if (dialog.execute()) {
-    std::ofstream outfile(dialog.getFilename().text());
+    std::ofstream outfile(dialog.getFilename().text(),ios::out|ios::binary);
     if (outfile) {
-      outfile << Pl->Path;
+      if (BinaryFrames)
+	MSLVectorFile::Write(outfile,Pl->Path);
+      else
+	outfile << Pl->Path;
       outfile.close();
     }
   }
@@ -742,9 +863,13 @@ void GuiPlanner::ReadPath()
   dialog.setDirectory(("./"+FilePath).c_str());
   dialog.setFilename("path");
   if (dialog.execute()) {
+    MSLVectorFile vf;
     std::ifstream infile(dialog.getFilename().text());
     if (infile) {
-      infile >> Pl->Path;
+      if (vf.Open(dialog.getFilename().text()))
+	vf.ReadAll(Pl->Path);
+      else
+	infile >> Pl->Path;
       infile.close();
     }
   }
@@ -27,7 +27,7 @@
 
 #include "msl_gui/rendergl.h"
 #include "msl_gui/guiplanner.h"
-#include "msl_gui/setup.h"
+#include "msl/setup.h"
 
 int main(int argc, char *argv[])
 {
@@ -43,12 +43,14 @@
 
 Render::Render() {
   Render("");
+  InitFrames();
 }
 
 
 Render::Render(string filepath)
 {
   FilePath = filepath;
+  InitFrames();
 }
 
 
@@ -58,6 +60,26 @@ Render::Render(Scene *s, string filepath)
 
   FilePath = filepath;
   ControlFreak = false;
+  InitFrames();
+}
+
+
+Render::~Render()
+{
+  StopAnimationFrames();
+}
+
+
+void Render::InitFrames()
+{
+  NumFrames = 0;
+  FramesReady = 0;
+  FrameScene = NULL;
+  NextFrameChunk = 0;
+  StopFrames = false;
+  ReadyChunks = 0;
+  FrameThreads = 1;
+  FrameChunkSize = 32;
 }
 
 
@@ -65,13 +87,18 @@ Render::Render(Scene *s, string filepath)
 void Render::Init()
 {
   int i;
-  std::ifstream fin;
+  MSLProblemFile fin;
 
   Reset();
 
   FrameTime = 0.1; // This is default; each renderer should determine this
   AnimationStartPause = 0.0; // should be in seconds
   AnimationEndPause = 0.0;
+  READ_PARAMETER_OR_DEFAULT(FrameThreads,
+			    (int) std::thread::hardware_concurrency());
+  READ_PARAMETER_OR_DEFAULT(FrameChunkSize,32);
+  if (FrameChunkSize < 1)
+    FrameChunkSize = 1;
   RenderCtlWindowOn = false;
 
   AttachedCameraOn = false;
@@ -93,12 +120,12 @@ void Render::Init()
   RGBRed[9] = 1.0; RGBGreen[9] = 0.51; RGBBlue[9] = 0.278; // Sienna1
 
   fin.clear();
-  fin.open((FilePath + "EnvList").c_str());
+  fin.open(FilePath + "EnvList");
   if (fin)
     fin >> EnvList;
   else {
     fin.clear();
-    fin.open((FilePath + "Obst").c_str());
+    fin.open(FilePath + "Obst");
     if (fin)
       EnvList.push_back("Obst");
   }
@@ -110,12 +137,12 @@ void Render::Init()
 
   // Load bodies
   fin.clear();
-  fin.open((FilePath+"BodyList").c_str());
+  fin.open(FilePath + "BodyList");
   if (fin)
     fin >> BodyList;
   else {
     fin.clear();
-    fin.open((FilePath+"Robot").c_str());
+    fin.open(FilePath + "Robot");
     if (fin)
       BodyList.push_back("Robot");
     else { // Multiple robots
@@ -132,7 +159,7 @@ void Render::Init()
     }
   }
 
-  // Close ifstream
+  // Close the stream
   fin.close();
 
   //cout << "BodyList: " << BodyList.size() << endl;
@@ -146,6 +173,21 @@ void Render::SetScene(Scene *s)
 }
 
 
+void Render::AddGraphEdges(const list<MSLVector> &edges)
+{
+  list<MSLVector>::const_iterator x;
+
+  forall(x,edges)
+    GraphList.push_back(S->StateToSceneConfiguration(*x));
+}
+
+
+void Render::ClearGraphs()
+{
+  GraphList.clear();
+}
+
+
 void Render::MakeAnimationFrames(const list<MSLVector> &xlist, double deltat)
 {
   double t;
@@ -173,104 +215,177 @@ void Render::MakeAnimationFrames(const list<MSLVector> &xlist,
 }
 
 
+void Render::AddFrame(int lower, int upper, double lambda) {
+  FrameLower.push_back(lower);
+  FrameUpper.push_back(upper);
+  FrameLambda.push_back(lambda);
+}
+
+
+
 void Render::SetFrameList() {
-  double ltime; // Lower time
-  double utime; // Upper time
   double crtime; // Current time
   double lasttime;
-  double lambda;
-  MSLVector sc; // scene configuration
-  MSLVector lx,ux; // lower and upper states
-  int i;
-  list<MSLVector>::iterator stli,tstli;
-  list<double>::iterator tli,li;
+  vector<double> times;
+  list<MSLVector>::iterator x;
+  list<double>::iterator t;
+  int i,j,k,n,numchunks,numworkers;
 
-  //cout << "Running SetFrameList\n";
-  //cout << "StateList: " << StateList << "\n";
-  //cout << "TimeList: " << TimeList << "\n";
+  StopAnimationFrames();
 
   FrameList.clear();
+  FrameLower.clear();
+  FrameUpper.clear();
+  FrameLambda.clear();
+  KeyStates.clear();
   NumFrames = 0;
-
-  if (TimeList.size() < 2) {
-    if (TimeList.size() == 1) {
-      FrameList.push_back(S->StateToSceneConfiguration(StateList.front()));
-      NumFrames = 1;
+  FramesReady = 0;
+
+  forall(x,StateList)
+    KeyStates.push_back(*x);
+  forall(t,TimeList)
+    times.push_back(*t);
+  n = times.size();
+
+  // Decide which states each frame comes from; this part is cheap
+  if (n == 1)
+    AddFrame(0,-1,0.0);
+  if (n >= 2) {
+    // Make the starting pause
+    for (i = 0; i < (int) (AnimationStartPause/FrameTime); i++)
+      AddFrame(0,-1,0.0);
+
+    k = 1;
+    lasttime = times[n-1];
+    for (crtime = times[0]; crtime <= lasttime; crtime += FrameTime) {
+      // Make sure the crtime within upper and lower
+      while ((times[k] < crtime)&&(k < n-1))
+	k++;
+      j = k-1;
+      while ((times[j] > crtime)&&(j > 0)) // This can happen sometimes
+	j--;
+      AddFrame(j,k,(crtime - times[j])/(times[k] - times[j]));
     }
-    return;
+
+    // Add in the last frame, if necessary
+    if ((FrameUpper.back() != n-1)||(FrameLambda.back() != 1.0))
+      AddFrame(n-1,-1,0.0);
+
+    // Make the ending pause
+    for (i = 0; i < (int) (AnimationEndPause/FrameTime); i++)
+      AddFrame(n-1,-1,0.0);
   }
 
-  // Make the starting pause
-  for (i = 0; i < (int) (AnimationStartPause/FrameTime); i++) {
-    FrameList.push_back(S->StateToSceneConfiguration(StateList.front()));
-    NumFrames++;
+  // Now make the scene configurations, a chunk at a time
+  NumFrames = FrameLower.size();
+  FrameList.resize(NumFrames);
+  numchunks = (NumFrames + FrameChunkSize - 1) / FrameChunkSize;
+  ChunkDone.assign(numchunks,false);
+  ReadyChunks = 0;
+  NextFrameChunk = 0;
+  StopFrames = false;
+  FrameScene = S;
+
+  if (numchunks == 0)
+    return;
+
+  // Make the first chunk here, so that the animation can start at once
+  MakeFrameChunk(NextFrameChunk++);
+
+  numworkers = min(FrameThreads,numchunks - 1);
+  for (i = 0; i < numworkers; i++)
+    FrameWorkers.push_back(std::thread(&Render::FrameWorker,this));
+  if (numworkers <= 0)
+    FrameWorker();
+}
+
+
+
+void Render::MakeFrameChunk(int c) {
+  int i,first,last,numchunks;
+
+  first = c * FrameChunkSize;
+  last = min(first + FrameChunkSize,NumFrames);
+  for (i = first; i < last; i++) {
+    if (FrameUpper[i] < 0)
+      FrameList[i] =
+	FrameScene->StateToSceneConfiguration(KeyStates[FrameLower[i]]);
+    else
+      FrameList[i] =
+	FrameScene->InterpolatedSceneConfiguration(KeyStates[FrameLower[i]],
+						   KeyStates[FrameUpper[i]],
+						   FrameLambda[i]);
   }
 
-  li = TimeList.begin(); li++;
-  stli = StateList.begin(); stli++;
-  utime = *li;  // Time index of second element
-  ux = *stli;
-  ltime = TimeList.front();
-  lx = StateList.front();
-  crtime = ltime;
-  lasttime = TimeList.back();
-  tli = li; tli++;
-  while (crtime <= lasttime) {
-    while ((utime < crtime)&&  // Make sure the crtime within upper and lower
-	   (tli != TimeList.end())) {
-      li++;
-      stli++;
-      utime = *li;
-      ux = *stli;
-      tli = li; tli++;
-    }
-    tli = li; tli--;
-    ltime = *tli;
-    tstli = stli; tstli--;
-    lx = *tstli;
-    while (ltime > crtime) { // This can happen sometimes (I think)!
-      tli--;
-      tstli--;
-      ltime = *tli;
-      lx = *tstli;
-    }
+  // Frames may only be shown once all chunks before them are done
+  std::lock_guard<std::mutex> guard(FrameLock);
+  numchunks = ChunkDone.size();
+  ChunkDone[c] = true;
+  while ((ReadyChunks < numchunks)&&(ChunkDone[ReadyChunks]))
+    ReadyChunks++;
+  FramesReady = (ReadyChunks == numchunks) ?
+    NumFrames : ReadyChunks * FrameChunkSize;
+}
 
-    lambda = (crtime - ltime)/(utime - ltime);
-    //cout << "lambda: " << lambda << "\n";
 
-    // Interoplate based on states lx and ux
-    sc = S->InterpolatedSceneConfiguration(lx,ux,lambda);
-    FrameList.push_back(sc);
-    NumFrames++;
-    crtime += FrameTime;
+
+void Render::FrameWorker() {
+  int c;
+
+  while (!StopFrames) {
+    c = NextFrameChunk++;
+    if (c >= (int) ChunkDone.size())
+      break;
+    MakeFrameChunk(c);
   }
+}
 
-  // Add in the last frame, if necessary
-  if (FrameList.back() != (S->StateToSceneConfiguration(StateList.back())))
-    FrameList.push_back(S->StateToSceneConfiguration(StateList.back()));
 
-  // Make the ending pause
-  for (i = 0; i < (int) (AnimationEndPause/FrameTime); i++) {
-    FrameList.push_back(S->StateToSceneConfiguration(StateList.back()));
-    NumFrames++;
+
+void Render::FinishAnimationFrames() {
+  unsigned int i;
+
+  for (i = 0; i < FrameWorkers.size(); i++)
+    FrameWorkers[i].join();
+  FrameWorkers.clear();
+
+  // Pick up anything left by StopAnimationFrames
+  if (FramesReady < NumFrames) {
+    StopFrames = false;
+    ChunkDone.assign(ChunkDone.size(),false);
+    ReadyChunks = 0;
+    NextFrameChunk = 0;
+    FrameWorker();
   }
+}
 
-  //list<MSLVector>::iterator x;
-  //cout << "StateList:\n";
-  //forall(x,StateList)
-  //  cout << *x << "\n";
-  //cout << "TimeList: " << TimeList << "\n";
-  //cout << "\n\nFrameList:\n";
-  //forall(x,FrameList)
-  //  cout << *x << "\n";
-  //cout << "NumFrames: " << NumFrames << "\n";
+
+
+void Render::StopAnimationFrames() {
+  unsigned int i;
+
+  StopFrames = true;
+  for (i = 0; i < FrameWorkers.size(); i++)
+    FrameWorkers[i].join();
+  FrameWorkers.clear();
+}
+
+
+
+void Render::SetFramesLoaded() {
+  NumFrames = FrameList.size();
+  FramesReady = NumFrames;
+  FrameLower.clear();
+  FrameUpper.clear();
+  FrameLambda.clear();
+  ChunkDone.clear();
 }
 
 
 
 void Render::SetCurrentAnimationFrame() {
   MSLVector c(S->SceneConfigurationDim);
-  int num,skip,i;
+  int num,skip;
 
   // How long has the frame been stuck?
   FrameStuckTime = used_time() - LastFrameTime;
@@ -282,9 +397,12 @@ void Render::SetCurrentAnimationFrame() {
     used_time(LastFrameTime);
   }
 
-  num = FrameList.size();
+  num = FramesReady;
   if (AnimationFrameIndex > num - 1) {
-    AnimationFrameIndex = 0;
+    if (num < NumFrames)
+      AnimationFrameIndex = num - 1; // Wait for the rest to be made
+    else
+      AnimationFrameIndex = 0;
     used_time(LastFrameTime);
   }
 
@@ -293,23 +411,20 @@ void Render::SetCurrentAnimationFrame() {
     used_time(LastFrameTime);
   }
 
-  if (num > 0) {
-    list<MSLVector>::iterator fi;
-    fi = FrameList.begin();
-    for (i = 0; i < AnimationFrameIndex - 1; i++)
-      fi++;
-    c=*fi;
-  }
+  if (num > 0)
+    c = FrameList[AnimationFrameIndex];
 
   CurrentAnimationFrame = c;
+
+  // Reap the frame workers once they are done
+  if ((num == NumFrames)&&(FrameWorkers.size() > 0))
+    FinishAnimationFrames();
 }
 
 
 
 void Render::ButtonHandle(int b)
 {
-  int i;
-  list<MSLVector>::iterator fi;
   //cout << "Button " << b << "\n";
 
   switch (b) {
@@ -348,28 +463,26 @@ void Render::ButtonHandle(int b)
     break;
   case GID_VCR_LAST: // Prev frame
     AnimationActive = false;
+    if (FramesReady == 0)
+      break;
     if (AnimationFrameIndex > 0)
       AnimationFrameIndex--;
     else
-      AnimationFrameIndex = FrameList.size() - 1;
-    fi = FrameList.begin();
-    for (i = 0; i < AnimationFrameIndex - 1; i++)
-      fi++;
-    CurrentAnimationFrame = *fi;
+      AnimationFrameIndex = FramesReady - 1;
+    CurrentAnimationFrame = FrameList[AnimationFrameIndex];
     ShowCurrentAnimationFrame();
     cout << "Frame: " << AnimationFrameIndex << "   Time stamp: "
 	 << AnimationFrameIndex*FrameTime << "s\n";
    break;
   case GID_VCR_NEXT: // Next frame
     AnimationActive = false;
-    if (AnimationFrameIndex < (int) FrameList.size() - 1)
+    if (FramesReady == 0)
+      break;
+    if (AnimationFrameIndex < FramesReady - 1)
       AnimationFrameIndex++;
     else
       AnimationFrameIndex = 0;
-    fi = FrameList.begin();
-    for (i = 0; i < AnimationFrameIndex - 1; i++)
-      fi++;
-    CurrentAnimationFrame = *fi;
+    CurrentAnimationFrame = FrameList[AnimationFrameIndex];
     ShowCurrentAnimationFrame();
     cout << "Frame: " << AnimationFrameIndex << "   Time stamp: "
 	 << AnimationFrameIndex*FrameTime << "s\n";
@@ -407,8 +520,8 @@ void Render::MainLoop(Gui *g) {
 void Render::Reset() {
   AnimationActive = false;
   AnimationFrameIndex = 0;
-  if (FrameList.size() > 0)
-    CurrentAnimationFrame = FrameList.front();
+  if (FramesReady > 0)
+    CurrentAnimationFrame = FrameList[0];
   else
     CurrentAnimationFrame = MSLVector(S->SceneConfigurationDim);
   AnimationTimeScale = 1.0;
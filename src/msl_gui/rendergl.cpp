@@ -440,6 +440,7 @@ void RenderGL::InitData(){
   int i;
   mslGLObject * tobj;
   MSLMatrix R(3,3);
+  bool modelcache = is_file(FilePath + "ModelCache");
 
   AnimationActive = false;
   CurrentObject = -1;
@@ -533,13 +534,14 @@ void RenderGL::InitData(){
 
 	cout << "model file name: " << *fname << endl;
 	tobj = new mslGLObject;
+	tobj->UseCache = modelcache;
 	tobj->ReadModelFile(FilePath, *fname);
 	AddEnvObject(tobj);
 	EnvIndex[i] = -1;
       }
     else
       {
-	std::ifstream fin((FilePath + *fname).c_str());
+	MSLProblemFile fin(FilePath + *fname);
 	if (S->GeomDim == 2)
 	  {
 	    fin >> plist;
@@ -567,13 +569,14 @@ void RenderGL::InitData(){
 	cout << "model file name: " << *fname << endl;
 
 	tobj = new mslGLObject;
+	tobj->UseCache = modelcache;
 	tobj->ReadModelFile(FilePath, *fname);
 	AddBodyObject(tobj);
 	BodyIndex[i] = -1;
       }
     else
       {
-	std::ifstream fin2((FilePath + *fname).c_str());
+	MSLProblemFile fin2(FilePath + *fname);
 	if (S->GeomDim == 2)
 	  {
 	    fin2 >> plist;
@@ -756,7 +759,10 @@ void RenderGL::DrawPath()
   int i, j;
   int BodyNum;
   MSLVector state1;
-  list<MSLVector>::iterator state2;
+  vector<MSLVector>::iterator state2;
+
+  if (FramesReady == 0)
+    return;
 
   glPushMatrix();
   glDisable(GL_TEXTURE_2D);
@@ -781,7 +787,7 @@ void RenderGL::DrawPath()
   i = 0;
   forall(state2, FrameList)
     {
-      if(i != 0 && i<NumFrames)
+      if(i != 0 && i<FramesReady)
 	{
 	  for(j=0; j<BodyNum; j++)
 	    {
@@ -811,9 +817,43 @@ void RenderGL::DrawPath()
 
 
 
+void RenderGL::DrawGraphs()
+{
+  list<MSLVector>::iterator x1,x2;
+
+  glPushMatrix();
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_LIGHTING);
+  glLineWidth(0.5);
+
+  // Each edge is drawn between the positions of the first body
+  glBegin(GL_LINES);
+  glColor3f(RGBRed[2],RGBGreen[2],RGBBlue[2]);
+  x1 = GraphList.begin();
+  while (x1 != GraphList.end()) {
+    x2 = x1;
+    x2++;
+    if (x2 == GraphList.end())
+      break;
+    glVertex3f((*x1)[0],(*x1)[1],(*x1)[2]);
+    glVertex3f((*x2)[0],(*x2)[1],(*x2)[2]);
+    x1 = x2;
+    x1++;
+  }
+  glEnd();
+
+  glLineWidth(1.0);
+  glEnable(GL_TEXTURE_2D);
+  glEnable(GL_LIGHTING);
+
+  glPopMatrix();
+}
+
+
+
 void RenderGL::GlutDrawEnvironment() {
 
-  int k, j;
+  int j;
   MSLVector c, conf(6);
   float vsca;
   MSLVector vt1(3);
@@ -839,11 +879,7 @@ void RenderGL::GlutDrawEnvironment() {
   if(RGL->AttachedCameraOn)
     {
       // get the current frameinformation
-      list<MSLVector>::iterator fi;
-      fi = RGL->FrameList.begin();
-      for (k = 0; k < RGL->AnimationFrameIndex - 1; k++)
-	fi++;
-      c = *fi;
+      c = RGL->CurrentAnimationFrame;
 
       for (j = 0; j < 6; j++)
 	conf[j] = c[ 6 * RGL->S->AttachedCameraBody + j];
@@ -1045,6 +1081,9 @@ void RenderGL::SceneRender()
   if (ShowPathOn)
     DrawPath();
 
+  if (GraphList.size() > 0)
+    DrawGraphs();
+
   if (CurrentObject != -1)
     WhichObject(CurrentObject)->ObjectHighlight();
 
@@ -20,6 +20,9 @@
 
 #include <cstring>
 #include <algorithm>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "msl/defs.h"
 
@@ -251,18 +254,134 @@ static  list<string> MaterialFileList;
 static  int 	     numSkip	= 0;
 static  int 	     numOther	= 0;
 
-#define	GROW(_v, _t) \
-    if (_v == NULL) \
-    { \
-	_v ## Available = CHUNK; \
-	_v = (_t *) malloc(sizeof(_t)*_v ## Available); \
-    } \
-    else \
-    if (_v ## Count >= _v ## Available) \
-    { \
-	_v ## Available *= 2; \
-	_v = (_t *) realloc(_v, sizeof(_t)*_v ## Available); \
-    }
+
+// The header of a cached model, followed by the material file names,
+// the faces and the corner arrays
+struct MSLGLCacheHeader {
+  char Magic[8];
+  int Version;
+  int CornerSize;
+  long long SourceSize;
+  long long SourceTime;
+  int NumFaces;
+  int NameBytes;
+  long long NumCorners;
+};
+
+struct MSLGLCacheFace {
+  int NumberOfPoint;
+  int NormalOn;
+  int TextureOn;
+  int MaterialID;
+  long long FirstCorner;
+};
+
+
+// Read a whole text file into buffer, NUL-terminated, with each
+// backslash continuation joined onto the next line
+static bool ReadTextFile(const string& fname, vector<char>& buffer)
+{
+  FILE *f;
+  long size;
+  char *p;
+
+  if ((f = fopen(fname.c_str(), "rb")) == NULL)
+    return false;
+
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  buffer.resize(size + 1);
+  if ((size > 0) && (fread(&buffer[0], 1, size, f) != (size_t) size))
+    size = 0;
+  buffer[size] = '\0';
+  buffer.resize(size + 1);
+  fclose(f);
+
+  for (p = &buffer[0]; (p = strchr(p, '\\')) != NULL; )
+    while (*p != '\0')
+      {
+	if (*p == '\n')
+	  {
+	    *p = ' ';
+	    break;
+	  }
+	*p++ = ' ';
+      }
+
+  return true;
+}
+
+
+// Return the line starting at line, NUL-terminated in place, and
+// advance line past it; NULL at end
+static char* NextLine(char *&line, char *end)
+{
+  char *start, *eol;
+
+  if (line >= end)
+    return NULL;
+
+  start = line;
+  if ((eol = (char *) memchr(line, '\n', end - line)) == NULL)
+    eol = end;
+  *eol = '\0';
+  line = eol + 1;
+
+  return start;
+}
+
+
+// Return the next blank-separated token of a line, NUL-terminated in
+// place, and advance p past it; NULL at the end of the line
+static char* NextToken(char *&p)
+{
+  char *token;
+
+  while (*p != '\0' && isspace(*p))
+    p++;
+  if (*p == '\0')
+    return NULL;
+
+  token = p;
+  while (*p != '\0' && !isspace(*p))
+    p++;
+  if (*p != '\0')
+    *p++ = '\0';
+
+  return token;
+}
+
+
+/* case insensitive token equality test */
+static inline bool SameToken(const char *a, const char *b)
+{
+  return strcasecmp(a, b) == 0;
+}
+
+
+// Wavefront tokens that are valid but ignored
+static const char *ObjSkippedTokens[] = {
+  "bevel", "bmat", "bsp", "bzp", "c_interp", "cdc", "con", "cstype",
+  "ctech", "curv", "curv2", "d_interp", "deg", "end", "hole", "l",
+  "lod", "maplib", "mg", "o", "p", "param", "parm", "res", "s",
+  "scrv", "shadow_obj", "sp", "stech", "step", "surf", "trace_obj",
+  "trim", "usemap", "vp", NULL};
+
+static const char *MtlSkippedTokens[] = {
+  "Ni", "Tf", "bump", "d", "decal", "illum", "map_Ka", "map_Ks",
+  "map_Ns", "map_d", "sharpness", "vp", NULL};
+
+static bool IsSkippedToken(const char *token, const char **skipped)
+{
+  int i;
+
+  for (i = 0; skipped[i] != NULL; i++)
+    if (SameToken(token, skipped[i]))
+      return true;
+
+  return false;
+}
 
 
 static unsigned int getint(FILE *fp)
@@ -532,6 +651,7 @@ mslGLFace::mslGLFace()
   ColorOn = 1;          // open color
 
   MaterialID = -1;
+  FirstCorner = -1;
 }
 
 
@@ -702,6 +822,7 @@ void mslGLFace::Clear()
   ColorOn = 1;          // open color
 
   MaterialID = -1;
+  FirstCorner = -1;
 }
 
 void mslGLFace::PrintVertex()
@@ -828,6 +949,8 @@ mslGLObject::mslGLObject()
   NumberOfMaterial = 0;
   NumberOfFace = 0;
 
+  UseCache = false;
+
   BoundingBoxMin[0] = 0.0;
   BoundingBoxMin[1] = 0.0;
   BoundingBoxMin[2] = 0.0;
@@ -852,6 +975,11 @@ void mslGLObject::Clear()
   NumberOfMaterial = 0;
   NumberOfFace = 0;
 
+  FaceArray.clear();
+  VertexArray.clear();
+  NormalArray.clear();
+  TexCoordArray.clear();
+
   BoundingBoxMin[0] = 0.0;
   BoundingBoxMin[1] = 0.0;
   BoundingBoxMin[2] = 0.0;
@@ -863,37 +991,20 @@ void mslGLObject::Clear()
 
 int mslGLObject::ReadModelFile(const string& path, const string& fileName)
 {
-    FILE	 *objFile;
+    vector<char>	 buffer;
+    char	*line, *next, *token, *end;
 
     int          currentMaterialID = -1;
+    int		 firstFace	= NumberOfFace;
+    list<string> mtllibs;
 
-    char	 buffer[BUFFER_SIZE];
-    char	 token[BUFFER_SIZE];
-    char	*next		= NULL;
-    char	*backslash	= NULL;
-
-    int		 width		= 0;
-
-    int 	 numTris	= 0;
-    int 	 numPolys	= 0;
-    int 	 numGroups	= 0;
-
-    mslGLVertex*         v       = NULL;
-    unsigned int	 vCount	        = 0;
-    unsigned int	 vAvailable	= 0;
+    // the indexed arrays of the file; faces copy out of them
+    vector<mslGLVertex>	 v;
+    vector<mslGLNormal>	 n;
+    vector<mslGLTexCoord> t;
 
-    mslGLNormal*         n        = NULL;
-    unsigned int	 nCount	        = 0;
-    unsigned int	 nAvailable	= 0;
-
-    mslGLTexCoord*       t       = NULL;
-    unsigned int	 tCount	        = 0;
-    unsigned int	 tAvailable	= 0;
-
-    /* tmp count vars */
-    int		 i, j;
-    float       f1, f2, f3;
-    MSLVector       tv1(3), tv2(2), tv3(9);
+    mslGLNormal		 zeroNormal = {0.0, 0.0, 0.0};
+    mslGLTexCoord	 zeroTexCoord = {0.0, 0.0, 0.0};
 
     Position[0] = 0.0;
     Position[1] = 0.0;
@@ -907,237 +1018,146 @@ int mslGLObject::ReadModelFile(const string& path, const string& fileName)
     Scale[1] = 1.0;
     Scale[2] = 1.0;
 
-    if ((objFile = fopen((path + fileName).c_str(), "r")) == NULL)
+    Name = fileName;
+
+    if (UseCache && ReadCachedModel(path, fileName))
+      {
+	ComputeBoundingBox();
+	return 0;
+      }
+
+    if (!ReadTextFile(path + fileName, buffer))
       {
 	cout << "can not open model file!" << endl;
 	return 1;
       }
 
-    Name = fileName;
-
-    while (fgets(buffer, BUFFER_SIZE, objFile) != NULL)
+    end = &buffer[buffer.size() - 1];
+    for (line = &buffer[0]; (next = NextLine(line, end)) != NULL; )
     {
-
-	while ((backslash = strchr(buffer, '\\')) != NULL)
-	{
-
-	    *backslash++ = ' ';
-	    *backslash   = '\0';
-
-
-	    if (fgets(backslash, (int)(BUFFER_SIZE - strlen(buffer)), objFile)
-		== NULL)
-		break;
-	}
-
-	/* find first non-"space" character in line */
-	for (next = buffer; *next != '\0' && isspace(*next); next++)
-	    /* EMPTY */ {};
-
 	/* skip blank lines and comments ('$' is comment in "cow.obj") */
-	if (*next == '\0' || *next == '#' || *next == '!' || *next == '$')
+	if ((token = NextToken(next)) == NULL ||
+	    *token == '#' || *token == '!' || *token == '$')
 	    continue;
 
-	/* extract token */
-	sscanf(next, "%s%n", token, &width);
-	next += width;
-
-	if (SAME(token, "v"))
+	if (SameToken(token, "v"))
 	{
-	    sscanf(next, "%f %f %f", &f1, &f2, &f3);
+	    mslGLVertex	 x;
 
-	    GROW(v, mslGLVertex);
-	    if(v == 0)
-	      {
-		cout << "memory allocation error!" << endl;
-		exit(-1);
-	      }
-
-	    v[vCount].x = f1;
-	    v[vCount].y = f2;
-	    v[vCount].z = f3;
-
-	    ++vCount;
+	    x.x = strtod(next, &next);
+	    x.y = strtod(next, &next);
+	    x.z = strtod(next, &next);
+	    v.push_back(x);
 	}
 	else
-	if (SAME(token, "vn"))
+	if (SameToken(token, "vn"))
 	{
-	    sscanf(next, "%f %f %f", &f1, &f2, &f3);
-
-	    GROW(n, mslGLNormal);
-	    if(n == 0)
-	      {
-		cout << "memeory allocation error!" << endl;
-		exit(-1);
-	      }
+	    mslGLNormal	 x;
 
-	    n[nCount].x = f1;
-	    n[nCount].y = f2;
-	    n[nCount].z = f3;
-
-	    ++nCount;
+	    x.x = strtod(next, &next);
+	    x.y = strtod(next, &next);
+	    x.z = strtod(next, &next);
+	    n.push_back(x);
 	}
 	else
-	if (SAME(token, "vt"))
+	if (SameToken(token, "vt"))
 	{
-	    sscanf(next, "%f %f", &f1, &f2);
-
-	    GROW(t, mslGLTexCoord);
-	    if(t == 0)
-	      {
-		cout << "memeory allocation error!" << endl;
-		exit(-1);
-	      }
-
-	    t[tCount].x = f1;
-	    t[tCount].y = f2;
+	    mslGLTexCoord x;
 
-	    ++tCount;
+	    x.x = strtod(next, &next);
+	    x.y = strtod(next, &next);
+	    x.z = 0.0;
+	    t.push_back(x);
 	}
 	else
-	if (SAME(token, "g"))
+	if (SameToken(token, "g"))
  	{
-	    ++numGroups;
+	    // groups carry no information for drawing
 	}
 	else
-	if (SAME(token, "f") ||
-	    SAME(token, "fo"))
+	if (SameToken(token, "f") ||
+	    SameToken(token, "fo"))
 	{
-	    int 	 count;
-	    int		 textureValid = 1;
-	    int		 normalsValid = 1;
-	    int		 vi[FACE_SIZE];
-	    int		 ti[FACE_SIZE];
-	    int		 ni[FACE_SIZE];
-
+	    int 	 count		= 0;
+	    int		 textureValid	= 1;
+	    int		 normalsValid	= 1;
+	    int		 vertexValid	= 1;
+	    long	 vi, ti, ni;
+	    size_t	 first		= VertexArray.size();
 	    char	*slash;
-	    char	 vertexData[256];
 
 	    mslGLFace       tFace;
 
-	    for (count = 0; count < FACE_SIZE; count++)
+	    while ((token = NextToken(next)) != NULL)
 	    {
-		if (sscanf(next, "%s%n", vertexData, &width) != 1)
-		    break;
-		next += width;
-		vi[count] = (int)strtol(vertexData, NULL, 10);
-		ti[count] = 0;
-		if ((slash = strchr(vertexData, '/')) == NULL ||
-		    (ti[count] = (int)strtol(slash+1, NULL, 10)) == 0)
-		    textureValid = 0;
-		ni[count] = 0;
-		if (slash == NULL || (slash = strchr(slash+1, '/')) == NULL ||
-		    (ni[count] = (int)strtol(slash+1, NULL, 10)) == 0)
-		    normalsValid = 0;
+		vi = strtol(token, &slash, 10);
+		ti = 0;
+		ni = 0;
+		if (*slash == '/')
+		  {
+		    ti = strtol(slash+1, &slash, 10);
+		    if (*slash == '/')
+		      ni = strtol(slash+1, NULL, 10);
+		  }
 
 		/*
 		 * form cannonical indices:
 		 *   convert ".obj" 1-based indices to 0-based (subtract 1)
-		 *   convert negative indices to positive (count from 0)
+		 *   convert negative indices to count back from the end
 		 */
-		if (vi[count] >= 0)
-		    vi[count] -= 1;
-		else
-		    vi[count]  = vCount - vi[count];
-
-		if (ti[count] >= 0)
-		    ti[count] -= 1;
-		else
-		    ti[count]  = tCount - ti[count];
-
-		if (ni[count] >= 0)
-		    ni[count] -= 1;
-		else
-		    ni[count]  = nCount - ni[count];
+		vi = (vi > 0) ? vi - 1 : (long) v.size() + vi;
+		ti = (ti > 0) ? ti - 1 : (ti < 0 ? (long) t.size() + ti : -1);
+		ni = (ni > 0) ? ni - 1 : (ni < 0 ? (long) n.size() + ni : -1);
+
+		if (vi < 0 || vi >= (long) v.size())
+		  vertexValid = 0;
+		if (ti < 0 || ti >= (long) t.size())
+		  textureValid = 0;
+		if (ni < 0 || ni >= (long) n.size())
+		  normalsValid = 0;
+
+		VertexArray.push_back(vertexValid ? v[vi] : mslGLVertex());
+		NormalArray.push_back(normalsValid ? n[ni] : zeroNormal);
+		TexCoordArray.push_back(textureValid ? t[ti] : zeroTexCoord);
+		count++;
 	    }
 
-	    for (i = 0; i < count; i++)
+	    if (count > 2 && vertexValid)
 	      {
-		tFace.AddVertex(v[vi[i]]);
-	      }
-
-	    tFace.ColorOn = 0;
-	    tFace.MaterialID = currentMaterialID;
-
-	    /* setup normal MSLVector information */
-	    if (normalsValid)
-	      {
-		tFace.NormalOn = 1;
-		for (i = 0; i < count; i++)
-		  tFace.AddNormal(n[ni[i]]);
+		tFace.ColorOn = 0;
+		tFace.MaterialID = currentMaterialID;
+		tFace.NumberOfPoint = count;
+		tFace.NormalOn = normalsValid;
+		tFace.NumberOfNormal = normalsValid ? count : 0;
+		tFace.TextureOn = textureValid;
+		tFace.NumberOfTexCoord = textureValid ? count : 0;
+		tFace.FirstCorner = first;
+		AddFace(tFace);
 	      }
 	    else
-	      tFace.NormalOn = 0;
-
-	    if (textureValid)
 	      {
-		tFace.TextureOn = 1;
-		for (i = 0; i < count; i++)
-		  tFace.AddTexCoord(t[ti[i]]);
-	      }
-	    else
-	      tFace.TextureOn = 0;
-
-	    if (count > 2)
-	      {
-		tFace.NumberOfPoint = count;
-		AddFace(tFace);
-		numTris += count - 2;
-		numPolys++;
-
+		VertexArray.resize(first);
+		NormalArray.resize(first);
+		TexCoordArray.resize(first);
 	      }
 	}
 	else
-	if (SAME(token, "usemtl"))
+	if (SameToken(token, "usemtl"))
 	{
-	    char	mtlName[MAXNAME_LENGTH];
-	    sscanf(next, "%s", mtlName);
-	    currentMaterialID = SetCurrentMaterialID(mtlName);
+	    if ((token = NextToken(next)) != NULL)
+	      currentMaterialID = SetCurrentMaterialID(token);
 	}
 	else
-	  if (SAME(token, "mtllib"))
+	  if (SameToken(token, "mtllib"))
 	    {
-	      char	libName[MAXNAME_LENGTH];
-	      sscanf(next, "%s", libName);
-	      LoadMaterialFile(path, libName);
+	      if ((token = NextToken(next)) != NULL)
+		{
+		  mtllibs.push_back(token);
+		  LoadMaterialFile(path, token);
+		}
 	    }
 	  else
-	    if (
-		SAME(token, "bevel")	||
-		SAME(token, "bmat")		||
-		SAME(token, "bsp")		||
-		SAME(token, "bzp")		||
-		SAME(token, "c_interp")	||
-		SAME(token, "cdc")		||
-		SAME(token, "con")		||
-		SAME(token, "cstype")	||
-		SAME(token, "ctech")	||
-		SAME(token, "curv")		||
-		SAME(token, "curv2")	||
-		SAME(token, "d_interp")	||
-		SAME(token, "deg")		||
-		SAME(token, "end")		||
-		SAME(token, "hole")		||
-		SAME(token, "l")		||
-		SAME(token, "lod")		||
-		SAME(token, "maplib")	||
-		SAME(token, "mg")		||
-		SAME(token, "o")		||
-		SAME(token, "p")		||
-		SAME(token, "param")	||
-		SAME(token, "parm")		||
-		SAME(token, "res")		||
-		SAME(token, "s")		||
-		SAME(token, "scrv")		||
-		SAME(token, "shadow_obj")	||
-		SAME(token, "sp")		||
-		SAME(token, "stech")	||
-		SAME(token, "step")		||
-		SAME(token, "surf")		||
-		SAME(token, "trace_obj")	||
-		SAME(token, "trim")		||
-		SAME(token, "usemap")	||
-		SAME(token, "vp"))
+	    if (IsSkippedToken(token, ObjSkippedTokens))
 	      {
 		++numSkip;
 	      }
@@ -1147,11 +1167,11 @@ int mslGLObject::ReadModelFile(const string& path, const string& fileName)
 	 * part of the OBJ format, but proves quite handy.
 	 */
 	    else
-	      if (SAME(token, "RESET"))
+	      if (SameToken(token, "RESET"))
 		{
-		  vCount = 0;
-		  nCount = 0;
-		  tCount = 0;
+		  v.clear();
+		  n.clear();
+		  t.clear();
 		}
 #endif
 	      else
@@ -1161,37 +1181,236 @@ int mslGLObject::ReadModelFile(const string& path, const string& fileName)
 		}
     }
 
-    /* close Wavefront ".obj" file */
-    fclose(objFile);
+    SetFaceArrays();
 
-    if (v != NULL) free(v);
-    if (n != NULL) free(n);
-    if (t != NULL) free(t);
+    if (UseCache)
+      WriteCachedModel(path, fileName, firstFace, mtllibs);
 
-    for(i=0; i<NumberOfFace; i++)
-      {
-	for(j=0; j<ObjectFaceLib[i].NumberOfPoint; j++)
-	  {
-	    if(ObjectFaceLib[i].VerticeCoord[j].x>BoundingBoxMax[0])
-	      BoundingBoxMax[0] = ObjectFaceLib[i].VerticeCoord[j].x;
-	    if(ObjectFaceLib[i].VerticeCoord[j].y>BoundingBoxMax[1])
-	      BoundingBoxMax[1] = ObjectFaceLib[i].VerticeCoord[j].y;
-	    if(ObjectFaceLib[i].VerticeCoord[j].z>BoundingBoxMax[2])
-	      BoundingBoxMax[2] = ObjectFaceLib[i].VerticeCoord[j].z;
-
-	    if(ObjectFaceLib[i].VerticeCoord[j].x<BoundingBoxMin[0])
-	      BoundingBoxMin[0] = ObjectFaceLib[i].VerticeCoord[j].x;
-	    if(ObjectFaceLib[i].VerticeCoord[j].y<BoundingBoxMin[1])
-	      BoundingBoxMin[1] = ObjectFaceLib[i].VerticeCoord[j].y;
-	    if(ObjectFaceLib[i].VerticeCoord[j].z<BoundingBoxMin[2])
-	      BoundingBoxMin[2] = ObjectFaceLib[i].VerticeCoord[j].z;
-	  }
-      }
+    ComputeBoundingBox();
 
     return 0;
 }
 
 
+void mslGLObject::ComputeBoundingBox()
+{
+  int i, j;
+
+  for(i=0; i<NumberOfFace; i++)
+    {
+      for(j=0; j<ObjectFaceLib[i].NumberOfPoint; j++)
+	{
+	  if(ObjectFaceLib[i].VerticeCoord[j].x>BoundingBoxMax[0])
+	    BoundingBoxMax[0] = ObjectFaceLib[i].VerticeCoord[j].x;
+	  if(ObjectFaceLib[i].VerticeCoord[j].y>BoundingBoxMax[1])
+	    BoundingBoxMax[1] = ObjectFaceLib[i].VerticeCoord[j].y;
+	  if(ObjectFaceLib[i].VerticeCoord[j].z>BoundingBoxMax[2])
+	    BoundingBoxMax[2] = ObjectFaceLib[i].VerticeCoord[j].z;
+
+	  if(ObjectFaceLib[i].VerticeCoord[j].x<BoundingBoxMin[0])
+	    BoundingBoxMin[0] = ObjectFaceLib[i].VerticeCoord[j].x;
+	  if(ObjectFaceLib[i].VerticeCoord[j].y<BoundingBoxMin[1])
+	    BoundingBoxMin[1] = ObjectFaceLib[i].VerticeCoord[j].y;
+	  if(ObjectFaceLib[i].VerticeCoord[j].z<BoundingBoxMin[2])
+	    BoundingBoxMin[2] = ObjectFaceLib[i].VerticeCoord[j].z;
+	}
+    }
+}
+
+
+// Point the faces read from files into the flat corner arrays; done
+// once the arrays have stopped growing
+void mslGLObject::SetFaceArrays()
+{
+  int i;
+  mslGLFace *f;
+
+  for(i=0; i<NumberOfFace; i++)
+    {
+      f = &ObjectFaceLib[i];
+      if(f->FirstCorner < 0)
+	continue;
+      f->VerticeCoord = &VertexArray[f->FirstCorner];
+      f->NormalCoord = f->NormalOn ? &NormalArray[f->FirstCorner] : NULL;
+      f->TextureCoord = f->TextureOn ? &TexCoordArray[f->FirstCorner] : NULL;
+    }
+}
+
+
+// The cache holds the header, the material file names (each followed
+// by a NUL), one MSLGLCacheFace per face, and the corner arrays.  It
+// is used while the size and modification time of the source match.
+bool mslGLObject::ReadCachedModel(const string& path, const string& fileName)
+{
+  MSLGLCacheHeader h;
+  MSLGLCacheFace cf;
+  struct stat st;
+  vector<char> buffer;
+  const char *p, *names;
+  size_t first, corners, expected;
+  mslGLFace tFace;
+  FILE *f;
+  long size;
+  int i;
+
+  if (stat((path + fileName).c_str(), &st) != 0)
+    return false;
+  if ((f = fopen((path + fileName + MSL_GLOBJ_CACHE_SUFFIX).c_str(), "rb")) == NULL)
+    return false;
+
+  // One read brings in the whole model
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (size < (long) sizeof(h))
+    {
+      fclose(f);
+      return false;
+    }
+  buffer.resize(size);
+  if (fread(&buffer[0], 1, size, f) != (size_t) size)
+    {
+      fclose(f);
+      return false;
+    }
+  fclose(f);
+
+  memcpy(&h, &buffer[0], sizeof(h));
+  if ((memcmp(h.Magic, MSL_GLOBJ_CACHE_MAGIC, 8) != 0) ||
+      (h.Version != MSL_GLOBJ_CACHE_VERSION) ||
+      (h.CornerSize != (int) sizeof(mslGLVertex)) ||
+      (h.SourceSize != (long long) st.st_size) ||
+      (h.SourceTime != (long long) st.st_mtime) ||
+      (h.NumFaces < 0) || (h.NumCorners < 0) || (h.NameBytes < 0))
+    return false;
+  corners = h.NumCorners;
+  expected = sizeof(h) + h.NameBytes + h.NumFaces * sizeof(cf) +
+    corners * (sizeof(mslGLVertex) + sizeof(mslGLNormal) + sizeof(mslGLTexCoord));
+  if (expected != (size_t) size)
+    return false;
+
+  // Check the names and faces before anything is loaded, so that a
+  // stale or corrupt cache falls back to the OBJ file cleanly: the
+  // last name must end inside the names, and every face must lie
+  // inside the corners
+  p = &buffer[sizeof(h)];
+  if ((h.NameBytes > 0) && (p[h.NameBytes - 1] != '\0'))
+    return false;
+  for (i = 0, p += h.NameBytes; i < h.NumFaces; i++, p += sizeof(cf))
+    {
+      memcpy(&cf, p, sizeof(cf));
+      if ((cf.NumberOfPoint < 0) || (cf.FirstCorner < 0) ||
+	  (cf.FirstCorner > (long long) corners - cf.NumberOfPoint))
+	return false;
+    }
+
+  // Replay the material files in their original order, so the ids
+  // stored with the faces mean the same materials
+  p = &buffer[sizeof(h)];
+  for (names = p; names < p + h.NameBytes; names += strlen(names) + 1)
+    LoadMaterialFile(path, names);
+  p += h.NameBytes;
+
+  first = VertexArray.size();
+  for (i = 0; i < h.NumFaces; i++, p += sizeof(cf))
+    {
+      memcpy(&cf, p, sizeof(cf));
+      tFace.ColorOn = 0;
+      tFace.MaterialID = cf.MaterialID;
+      tFace.NumberOfPoint = cf.NumberOfPoint;
+      tFace.NormalOn = cf.NormalOn;
+      tFace.NumberOfNormal = cf.NormalOn ? cf.NumberOfPoint : 0;
+      tFace.TextureOn = cf.TextureOn;
+      tFace.NumberOfTexCoord = cf.TextureOn ? cf.NumberOfPoint : 0;
+      tFace.FirstCorner = first + cf.FirstCorner;
+      AddFace(tFace);
+    }
+
+  VertexArray.resize(first + corners);
+  NormalArray.resize(first + corners);
+  TexCoordArray.resize(first + corners);
+  memcpy(&VertexArray[first], p, corners * sizeof(mslGLVertex));
+  p += corners * sizeof(mslGLVertex);
+  memcpy(&NormalArray[first], p, corners * sizeof(mslGLNormal));
+  p += corners * sizeof(mslGLNormal);
+  memcpy(&TexCoordArray[first], p, corners * sizeof(mslGLTexCoord));
+
+  SetFaceArrays();
+
+  return true;
+}
+
+
+void mslGLObject::WriteCachedModel(const string& path, const string& fileName,
+				   int firstFace, const list<string>& mtllibs)
+{
+  MSLGLCacheHeader h;
+  MSLGLCacheFace cf;
+  struct stat st;
+  list<string>::const_iterator s;
+  string names, fname, tmp;
+  size_t first;
+  char pid[30];
+  FILE *f;
+  int i, ok;
+
+  if (stat((path + fileName).c_str(), &st) != 0)
+    return;
+
+  forall(s, mtllibs)
+    names.append(s->c_str(), s->length() + 1);
+
+  first = (firstFace < NumberOfFace) ?
+    ObjectFaceLib[firstFace].FirstCorner : VertexArray.size();
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.Magic, MSL_GLOBJ_CACHE_MAGIC, sizeof(MSL_GLOBJ_CACHE_MAGIC));
+  h.Version = MSL_GLOBJ_CACHE_VERSION;
+  h.CornerSize = sizeof(mslGLVertex);
+  h.SourceSize = st.st_size;
+  h.SourceTime = st.st_mtime;
+  h.NumFaces = NumberOfFace - firstFace;
+  h.NumCorners = VertexArray.size() - first;
+  h.NameBytes = names.length();
+
+  // Write to a private name and rename, so that a concurrent reader
+  // never sees a partial file
+  fname = path + fileName + MSL_GLOBJ_CACHE_SUFFIX;
+  sprintf(pid, ".%d", (int) getpid());
+  tmp = fname + pid;
+  if ((f = fopen(tmp.c_str(), "wb")) == NULL)
+    return;
+
+  ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+  ok = ok && (fwrite(names.data(), 1, names.length(), f) == names.length());
+  for (i = firstFace; ok && i < NumberOfFace; i++)
+    {
+      cf.NumberOfPoint = ObjectFaceLib[i].NumberOfPoint;
+      cf.NormalOn = ObjectFaceLib[i].NormalOn;
+      cf.TextureOn = ObjectFaceLib[i].TextureOn;
+      cf.MaterialID = ObjectFaceLib[i].MaterialID;
+      cf.FirstCorner = ObjectFaceLib[i].FirstCorner - first;
+      ok = (fwrite(&cf, sizeof(cf), 1, f) == 1);
+    }
+  if (h.NumCorners > 0)
+    {
+      ok = ok && (fwrite(&VertexArray[first], sizeof(mslGLVertex),
+			 h.NumCorners, f) == (size_t) h.NumCorners);
+      ok = ok && (fwrite(&NormalArray[first], sizeof(mslGLNormal),
+			 h.NumCorners, f) == (size_t) h.NumCorners);
+      ok = ok && (fwrite(&TexCoordArray[first], sizeof(mslGLTexCoord),
+			 h.NumCorners, f) == (size_t) h.NumCorners);
+    }
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok || (rename(tmp.c_str(), fname.c_str()) != 0))
+    {
+      cout << "Could not write the model cache " << fname << endl;
+      remove(tmp.c_str());
+    }
+}
+
+
 MSLPoint3d mslGLObject::PointCurrentState(const MSLPoint3d& po, int mode)
 {
   MSLVector vp1(3);
@@ -1326,13 +1545,8 @@ list<MSLTriangle> mslGLObject::SetBoundingBoxTriangle(int mode)
 
 void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 {
-    FILE	*mtlFile;
-    char	 buffer[BUFFER_SIZE];
-    char	 token[BUFFER_SIZE];
-    char	*next;
-    char	*backslash;
-    int		 width	= 0;
-    //    int	         i;
+    vector<char>	 buffer;
+    char	*line, *next, *token, *end;
     int 	 inProgress = 0;
 
     mslGLMaterial   tmat;
@@ -1355,29 +1569,22 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 	cout << "You have exceed the limit of the number of the material file" << endl;
       }
 
-    /* open file */
-    if ((mtlFile = fopen((path + filename).c_str(), "r")) == NULL)
+    /* read Wavefront ".mtl" file */
+    if (!ReadTextFile(path + filename, buffer))
       {
 	cout << "Can not open the material file" << endl;
 	return;
       }
 
-    /* read Wavefront ".mtl" file */
-    while (fgets(buffer, BUFFER_SIZE, mtlFile) != NULL)
+    end = &buffer[buffer.size() - 1];
+    for (line = &buffer[0]; (next = NextLine(line, end)) != NULL; )
     {
-	while ((backslash = strchr(buffer, '\\')) != NULL)
-	    if (fgets(backslash, BUFFER_SIZE - strlen(buffer), mtlFile) == NULL)
-		break;
-
-	for (next = buffer; *next != '\0' && isspace(*next); next++)
-	    /* EMPTY */ {};
-	if (*next == '\0' || *next == '#' || *next == '!' || *next == '$')
+	if ((token = NextToken(next)) == NULL ||
+	    *token == '#' || *token == '!' || *token == '$')
 	    continue;
-	sscanf(next, "%s%n", token, &width);
-	next += width;
 
 	/* identify token */
-	if (SAME(token, "newmtl"))
+	if (SameToken(token, "newmtl"))
 	  {
 	    if(inProgress)
 	      {
@@ -1390,7 +1597,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 	    sscanf(next, "%s", tmat.Name);
 	  }
 	else
-	  if (SAME(token, "Ka"))
+	  if (SameToken(token, "Ka"))
 	    {
 	      sscanf(next, "%f %f %f",
 		     &tmat.Ambient[0],
@@ -1399,7 +1606,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 	      tmat.AmbientOn= 1;
 	    }
 	  else
-	    if (SAME(token, "Kd"))
+	    if (SameToken(token, "Kd"))
 	      {
 		sscanf(next, "%f %f %f",
 		       &tmat.Diffuse[0],
@@ -1411,7 +1618,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 		tmat.DiffuseOn = 1;
 	      }
 	    else
-	      if (SAME(token, "Ks"))
+	      if (SameToken(token, "Ks"))
 		{
 		  sscanf(next, "%f %f %f",
 			 &tmat.Specular[0],
@@ -1420,7 +1627,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 		  tmat.SpecularOn = 1;
 		}
 	      else
-		if (SAME(token, "Tr"))
+		if (SameToken(token, "Tr"))
 		  {
 		    float alpha = 1.0f;
 		    sscanf(next, "%f", &alpha);
@@ -1428,7 +1635,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 		    tmat.AlphaOn = 1;
 		  }
 		else
-		  if (SAME(token, "Ns"))
+		  if (SameToken(token, "Ns"))
 		    {
 		      sscanf(next, "%f", &tmat.Shininess);
 
@@ -1442,32 +1649,20 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 		      tmat.ShininessOn = 1;
 		    }
 		  else
-		    if (SAME(token, "map_Kd"))
+		    if (SameToken(token, "map_Kd"))
 		      {
 			ParseTexture(next, &tmat);
 			tmat.TextureOn = 1;
 		      }
 		    else
-		      if (SAME(token, "refl"))
+		      if (SameToken(token, "refl"))
 			{
 			  strcpy(tmat.Reflect, "sphere");
 			  ParseTexture(next, &tmat);
 			  tmat.ReflectOn = 1;
 			}
 		      else
-			if (
-			    SAME(token, "Ni")	        ||
-			    SAME(token, "Tf")		||
-			    SAME(token, "bump")	        ||
-			    SAME(token, "d")		||
-			    SAME(token, "decal")	||
-			    SAME(token, "illum")	||
-			    SAME(token, "map_Ka")	||
-			    SAME(token, "map_Ks")	||
-			    SAME(token, "map_Ns")	||
-			    SAME(token, "map_d")	||
-			    SAME(token, "sharpness")	||
-			    SAME(token, "vp"))
+			if (IsSkippedToken(token, MtlSkippedTokens))
 			  {
 			    numSkip++;
 			  }
@@ -1476,7 +1671,7 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 	 * indicate that this material is two-sided
 	 */
 			else
-			  if (SAME(token, "TWOSIDE"))
+			  if (SameToken(token, "TWOSIDE"))
 			    {
 			      tmat.TwosideOn = 1;
 			    }
@@ -1490,9 +1685,6 @@ void mslGLObject::LoadMaterialFile(const string& path, const string& filename)
 
     if (inProgress)
       AddMaterial(path, tmat);
-
-    /* close Wavefront ".mtl" file */
-    fclose(mtlFile);
 }
 
 
@@ -1549,24 +1741,10 @@ void mslGLObject::AddMaterial(const string& path, const mslGLMaterial& mat)
 
 void mslGLObject::AddFace(const mslGLFace& face)
 {
-  if(ObjectFaceLib == NULL)
-    {
-      if((ObjectFaceLib = (mslGLFace *) malloc(sizeof(mslGLFace))) == 0)
-	{
-	  printf("Error reallocating mem\n");
-	  exit(-1);
-	}
-    }
-  else
-    if((ObjectFaceLib = (mslGLFace *) realloc(ObjectFaceLib,
-					      sizeof(mslGLFace)*(NumberOfFace+1))) == 0) {
-      printf("Error reallocating mem\n");
-      exit(-1);
-    }
-
-  ObjectFaceLib[NumberOfFace] = face;
+  FaceArray.push_back(face);
 
-  NumberOfFace++;
+  ObjectFaceLib = &FaceArray[0];
+  NumberOfFace = FaceArray.size();
 }
 
 
@@ -557,6 +557,7 @@ inline void RenderIv::_SetSwitch(SoSwitch *pSwitch, bool bFlag)
 //---------------------------------------------------------------------
 void RenderIv::_UpdatePathDisplay()
 {
+  FinishAnimationFrames();
   _pathFrames = NumFrames;
 
   // check for empty path
@@ -577,7 +578,7 @@ void RenderIv::_UpdatePathDisplay()
   int bInd;
   int p = 0;
 
-  list<MSLVector>::iterator frp;
+  vector<MSLVector>::iterator frp;
   frp = FrameList.begin();
   for (int i = 1; i < NumFrames; i++) {
     for (int j = 0; j < BodyNum; j++) {
@@ -0,0 +1,488 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// msl_bench: run planners over many seeds on the example problems
+//
+//   msl_bench [options]
+//
+//   -data <dir>          directory of problems (default data)
+//   -problems <a,b,...>  problems to run (default: every subdirectory)
+//   -planners <a,b,...>  planners to run (default: all of PlannerNames)
+//   -seeds <n>           runs per pair, with seeds 1..n (default 10)
+//   -nodes <n>           node budget per run (default: the planner's)
+//   -time <seconds>      wall-clock limit per run (default 10)
+//   -csv <file>          write the results as CSV (default: stdout)
+//   -json <file>         write the results as JSON
+//   -runs <file>         write every run, for msl_compare (see WriteRuns)
+//   -baseline <file>     compare against a CSV written earlier
+//   -tolerance <r>       allowed loss before a regression is flagged
+//                        (default 0.1); a slower median must also be
+//                        beyond the baseline's p95 (see Compare)
+//   -verbose             keep what the planners print
+//
+// One row is written per (problem, planner) pair.  Times are wall
+// clock, from the start of Construct (for roadmap planners) to the end
+// of Plan, over the successful runs only.  With -baseline, the exit
+// status is 1 if any pair regressed.  Summary rows hide how much the
+// time varies from seed to seed; to compare two builds, save -runs
+// from each and give both to msl_compare.
+
+#include <stdlib.h>
+#include <dirent.h>
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+
+#include "msl/setup.h"
+#include "msl/planner.h"
+#include "msl/rrt.h"
+#include "msl/prm.h"
+#include "msl/fdp.h"
+#include "msl/util.h"
+#include "msl/defs.h"
+
+
+//! One run of one planner on one problem
+struct MSLBenchRun {
+  int Seed;
+  MSLPlanStatus Status;
+  double Time;        // Wall clock, whether or not it succeeded
+  int Nodes;
+  int Satisfied;
+  double PathLength;  // -1 unless it succeeded
+};
+
+
+//! The results of all runs of one planner on one problem
+struct MSLBenchResult {
+  string Problem;
+  string Planner;
+  int Runs;
+  int Successes;
+  double MedianTime;
+  double P95Time;
+  double MeanNodes;
+  double MeanSatisfied;
+  double MedianPathLength;
+  vector<MSLBenchRun> RunList;
+
+  inline double SuccessRate() const {
+    return (Runs > 0) ? (double) Successes / Runs : 0.0;
+  }
+};
+
+
+//! A stream buffer that drops everything
+class MSLNullBuf: public streambuf {
+ protected:
+  virtual int overflow(int c) {return c;}
+};
+
+
+
+static list<string> Split(const string &s) {
+  list<string> l;
+  string w;
+  istringstream is(s);
+
+  while (getline(is,w,','))
+    if (w != "")
+      l.push_back(w);
+
+  return l;
+}
+
+
+
+// The value below which a fraction p of v lies (v is sorted);
+// -1 if v is empty
+static double Percentile(const vector<double> &v, double p) {
+  size_t i;
+
+  if (v.empty())
+    return -1.0;
+  i = (size_t) ceil(p * v.size());
+  if (i > 0)
+    i--;
+  if (i >= v.size())
+    i = v.size() - 1;
+
+  return v[i];
+}
+
+
+
+// Collision checks made by the planner, for the planners that count them
+static int SatisfiedCount(Planner *pl) {
+  if (dynamic_cast<RRT*>(pl))
+    return ((RRT*) pl)->SatisfiedCount;
+  if (dynamic_cast<PRM*>(pl))
+    return ((PRM*) pl)->SatisfiedCount;
+  if (dynamic_cast<FDP*>(pl))
+    return ((FDP*) pl)->SatisfiedCount;
+  return 0;
+}
+
+
+
+static int NodeCount(Planner *pl) {
+  int n = 0;
+  RRTCompact *rc;
+
+  if (pl->T)
+    n += pl->T->Size();
+  if (pl->T2)
+    n += pl->T2->Size();
+  if (pl->Roadmap)
+    n += pl->Roadmap->NumVertices();
+  if (((rc = dynamic_cast<RRTCompact*>(pl)) != NULL) && rc->CT)
+    n += rc->CT->Size();
+
+  return n;
+}
+
+
+
+static double PathLength(Problem *p, const list<MSLVector> &path) {
+  list<MSLVector>::const_iterator x,last;
+  double len = 0.0;
+
+  for (x = last = path.begin(); x != path.end(); last = x++)
+    if (x != last)
+      len += p->Metric(*last,*x);
+
+  return len;
+}
+
+
+
+static MSLBenchResult Run(Problem *prob, const string &problemname,
+			  const string &plannername, int seeds, int nodes,
+			  double timelimit) {
+  MSLBenchResult r;
+  MSLBenchRun run;
+  vector<double> times,lengths;
+  double nodesum = 0.0,satsum = 0.0,start,remaining;
+  MSLPlanStatus status;
+  Planner *pl;
+  bool roadmap;
+  int s;
+
+  r.Problem = problemname;
+  r.Planner = plannername;
+  r.Runs = r.Successes = 0;
+
+  for (s = 1; s <= seeds; s++) {
+    if ((pl = MakePlanner(plannername,prob)) == NULL)
+      break;
+    pl->SetSeed(s);
+    if (nodes > 0)
+      pl->NumNodes = nodes;
+
+    start = wall_time();
+    roadmap = (dynamic_cast<RoadmapPlanner*>(pl) != NULL);
+    status = MSL_PLAN_SUCCESS;
+    if (roadmap)
+      status = pl->ConstructWithin(timelimit);
+    if (status == MSL_PLAN_SUCCESS) {
+      remaining = timelimit - (wall_time() - start);
+      status = pl->PlanWithin((remaining > 0.0) ? remaining : 1e-9);
+    }
+
+    run.Seed = s;
+    run.Status = status;
+    run.Time = wall_time() - start;
+    run.Nodes = NodeCount(pl);
+    run.Satisfied = SatisfiedCount(pl);
+    run.PathLength = -1.0;
+    r.Runs++;
+    if (status == MSL_PLAN_SUCCESS) {
+      r.Successes++;
+      run.PathLength = PathLength(prob,pl->Path);
+      times.push_back(run.Time);
+      lengths.push_back(run.PathLength);
+    }
+    nodesum += run.Nodes;
+    satsum += run.Satisfied;
+    r.RunList.push_back(run);
+
+    delete pl;
+  }
+
+  sort(times.begin(),times.end());
+  sort(lengths.begin(),lengths.end());
+  r.MedianTime = Percentile(times,0.5);
+  r.P95Time = Percentile(times,0.95);
+  r.MedianPathLength = Percentile(lengths,0.5);
+  r.MeanNodes = (r.Runs > 0) ? nodesum / r.Runs : 0.0;
+  r.MeanSatisfied = (r.Runs > 0) ? satsum / r.Runs : 0.0;
+
+  return r;
+}
+
+
+
+static void WriteCSV(ostream &os, const vector<MSLBenchResult> &results) {
+  size_t i;
+
+  os << "problem,planner,runs,successes,success_rate,median_time,p95_time,"
+     << "mean_nodes,mean_satisfied,median_path_length\n";
+  for (i = 0; i < results.size(); i++) {
+    const MSLBenchResult &r = results[i];
+    os << r.Problem << "," << r.Planner << "," << r.Runs << ","
+       << r.Successes << "," << r.SuccessRate() << "," << r.MedianTime
+       << "," << r.P95Time << "," << r.MeanNodes << "," << r.MeanSatisfied
+       << "," << r.MedianPathLength << "\n";
+  }
+}
+
+
+
+static void WriteJSON(ostream &os, const vector<MSLBenchResult> &results) {
+  size_t i;
+
+  os << "[\n";
+  for (i = 0; i < results.size(); i++) {
+    const MSLBenchResult &r = results[i];
+    os << "  {\"problem\": \"" << r.Problem << "\", \"planner\": \""
+       << r.Planner << "\", \"runs\": " << r.Runs << ", \"successes\": "
+       << r.Successes << ", \"success_rate\": " << r.SuccessRate()
+       << ", \"median_time\": " << r.MedianTime << ", \"p95_time\": "
+       << r.P95Time << ", \"mean_nodes\": " << r.MeanNodes
+       << ", \"mean_satisfied\": " << r.MeanSatisfied
+       << ", \"median_path_length\": " << r.MedianPathLength << "}"
+       << ((i+1 < results.size()) ? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+
+
+// One line per run, after a line naming the format and its version
+// and a CSV header:
+//   # msl_bench runs 1
+//   problem,planner,seed,status,time,nodes,satisfied,path_length
+// status is as printed for MSLPlanStatus ("success", "timeout", ...).
+// msl_compare reads these.
+static void WriteRuns(ostream &os, const vector<MSLBenchResult> &results) {
+  size_t i,j;
+
+  os << "# msl_bench runs 1\n"
+     << "problem,planner,seed,status,time,nodes,satisfied,path_length\n";
+  for (i = 0; i < results.size(); i++)
+    for (j = 0; j < results[i].RunList.size(); j++) {
+      const MSLBenchRun &run = results[i].RunList[j];
+      os << results[i].Problem << "," << results[i].Planner << ","
+	 << run.Seed << "," << run.Status << "," << run.Time << ","
+	 << run.Nodes << "," << run.Satisfied << "," << run.PathLength
+	 << "\n";
+    }
+}
+
+
+
+// Read a CSV written by WriteCSV, keyed by "problem,planner"
+static bool ReadCSV(const string &fname, map<string,MSLBenchResult> &results) {
+  ifstream fin(fname.c_str());
+  string line,field;
+  MSLBenchResult r;
+
+  if (!fin)
+    return false;
+
+  getline(fin,line);  // The header
+  while (getline(fin,line)) {
+    istringstream is(line);
+    double rate;
+    getline(is,r.Problem,',');
+    getline(is,r.Planner,',');
+    char c;
+    if (is >> r.Runs >> c >> r.Successes >> c >> rate >> c >> r.MedianTime
+	>> c >> r.P95Time >> c >> r.MeanNodes >> c >> r.MeanSatisfied
+	>> c >> r.MedianPathLength)
+      results[r.Problem + "," + r.Planner] = r;
+  }
+
+  return true;
+}
+
+
+
+// A pair regressed if its success rate dropped by more than tol, or
+// its median time grew by more than a factor 1+tol and is also beyond
+// the baseline's 95th percentile.  Planning times spread widely from
+// seed to seed, so a median within the baseline's own spread is not
+// counted (times under 10ms are too noisy to compare at all).
+static int Compare(const vector<MSLBenchResult> &results,
+		   map<string,MSLBenchResult> &baseline, double tol) {
+  size_t i;
+  int regressions = 0;
+  map<string,MSLBenchResult>::iterator b;
+
+  for (i = 0; i < results.size(); i++) {
+    const MSLBenchResult &r = results[i];
+    b = baseline.find(r.Problem + "," + r.Planner);
+    if (b == baseline.end())
+      continue;
+    const MSLBenchResult &old = b->second;
+    if (r.SuccessRate() < old.SuccessRate() - tol) {
+      cerr << "REGRESSION " << r.Problem << " " << r.Planner
+	   << ": success rate " << old.SuccessRate() << " -> "
+	   << r.SuccessRate() << "\n";
+      regressions++;
+    }
+    else if ((old.MedianTime >= 0.01) && (r.MedianTime >= 0.0) &&
+	     (r.MedianTime > old.MedianTime * (1.0 + tol)) &&
+	     (r.MedianTime > old.P95Time)) {
+      cerr << "REGRESSION " << r.Problem << " " << r.Planner
+	   << ": median time " << old.MedianTime << "s -> "
+	   << r.MedianTime << "s (baseline p95 " << old.P95Time << "s)\n";
+      regressions++;
+    }
+  }
+
+  return regressions;
+}
+
+
+
+static list<string> ProblemDirectories(const string &data) {
+  list<string> names;
+  struct dirent *d;
+  DIR *dir;
+  string name;
+
+  if ((dir = opendir(data.c_str())) == NULL)
+    return names;
+  while ((d = readdir(dir)) != NULL) {
+    name = d->d_name;
+    if ((name[0] != '.') && is_directory(data + name))
+      names.push_back(name);
+  }
+  closedir(dir);
+  names.sort();
+
+  return names;
+}
+
+
+
+int main(int argc, char **argv) {
+  string data = "data/",csvfile,jsonfile,runsfile,baselinefile;
+  list<string> problems,planners;
+  list<string>::iterator pr,pn;
+  vector<MSLBenchResult> results;
+  map<string,MSLBenchResult> baseline;
+  int seeds = 10,nodes = -1,i,regressions = 0;
+  double timelimit = 10.0,tol = 0.1;
+  bool verbose = false;
+  streambuf *coutbuf = cout.rdbuf();
+  MSLNullBuf discard;
+  Model *m;
+  Geom *g;
+  Problem *prob;
+
+  for (i = 1; i < argc; i++) {
+    string a = argv[i];
+    if ((a == "-data") && (i+1 < argc))
+      data = argv[++i];
+    else if ((a == "-problems") && (i+1 < argc))
+      problems = Split(argv[++i]);
+    else if ((a == "-planners") && (i+1 < argc))
+      planners = Split(argv[++i]);
+    else if ((a == "-seeds") && (i+1 < argc))
+      seeds = atoi(argv[++i]);
+    else if ((a == "-nodes") && (i+1 < argc))
+      nodes = atoi(argv[++i]);
+    else if ((a == "-time") && (i+1 < argc))
+      timelimit = atof(argv[++i]);
+    else if ((a == "-csv") && (i+1 < argc))
+      csvfile = argv[++i];
+    else if ((a == "-json") && (i+1 < argc))
+      jsonfile = argv[++i];
+    else if ((a == "-runs") && (i+1 < argc))
+      runsfile = argv[++i];
+    else if ((a == "-baseline") && (i+1 < argc))
+      baselinefile = argv[++i];
+    else if ((a == "-tolerance") && (i+1 < argc))
+      tol = atof(argv[++i]);
+    else if (a == "-verbose")
+      verbose = true;
+    else {
+      cerr << "Usage: msl_bench [-data <dir>] [-problems <a,b,...>]\n"
+	   << "                 [-planners <a,b,...>] [-seeds <n>]\n"
+	   << "                 [-nodes <n>] [-time <seconds>] [-csv <file>]\n"
+	   << "                 [-json <file>] [-runs <file>]\n"
+	   << "                 [-baseline <file>] [-tolerance <r>]\n"
+	   << "                 [-verbose]\n";
+      return 2;
+    }
+  }
+  if (data[data.length()-1] != '/')
+    data += "/";
+  if (problems.empty())
+    problems = ProblemDirectories(data);
+  if (planners.empty())
+    planners = PlannerNames();
+  if ((baselinefile != "") && !ReadCSV(baselinefile,baseline)) {
+    cerr << "Error:   Cannot read the baseline " << baselinefile << "\n";
+    return 2;
+  }
+
+  forall(pr,problems) {
+    if (!is_directory(data + *pr + "/")) {
+      cerr << "Skipping " << *pr << ": not a directory\n";
+      continue;
+    }
+    if (!verbose)
+      cout.rdbuf(&discard);
+    SetupProblem(m,g,data + *pr + "/");
+    prob = new Problem(g,m,data + *pr + "/");
+    forall(pn,planners) {
+      results.push_back(Run(prob,*pr,*pn,seeds,nodes,timelimit));
+      cerr << *pr << " " << *pn << ": " << results.back().Successes
+	   << "/" << results.back().Runs << "\n";
+    }
+    cout.rdbuf(coutbuf);
+    delete prob;
+    delete g;
+    delete m;
+  }
+
+  if (csvfile != "") {
+    ofstream fout(csvfile.c_str());
+    WriteCSV(fout,results);
+  }
+  if (jsonfile != "") {
+    ofstream fout(jsonfile.c_str());
+    WriteJSON(fout,results);
+  }
+  if (runsfile != "") {
+    ofstream fout(runsfile.c_str());
+    WriteRuns(fout,results);
+  }
+  if ((csvfile == "") && (jsonfile == ""))
+    WriteCSV(cout,results);
+
+  if (baselinefile != "")
+    regressions = Compare(results,baseline,tol);
+
+  return (regressions > 0) ? 1 : 0;
+}
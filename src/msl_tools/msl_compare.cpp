@@ -0,0 +1,343 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// msl_compare: compare the runs of two msl_bench results, seed by seed
+//
+//   msl_compare [options] <baseline runs> <new runs>
+//
+//   -alpha <p>          significance level (default 0.05)
+//   -threshold <r>      smallest relative change of the median time that
+//                       counts as faster or slower (default 0.05)
+//   -csv <file>         also write the table as CSV
+//
+// Both files are written by msl_bench -runs, normally for the same
+// problems, planners and seeds; cells (problem, planner pairs) found in
+// only one of them are listed and skipped.  For each cell the times of
+// the two sets of runs are compared with the two-sided Mann-Whitney U
+// test (normal approximation, corrected for ties), so a change is only
+// reported when it is larger than the seed-to-seed spread.  A failed
+// run counts as slower than every successful one, so losing successes
+// shows up as a slowdown.  A cell is "faster" or "slower" if p < alpha
+// and its median time changed by more than the threshold, and "same"
+// otherwise.  The exit status is 1 if any cell is slower, and 2 on a
+// usage or read error.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <map>
+
+#include "msl/util.h"
+
+
+//! The runs of one planner on one problem in one file
+struct MSLCompareCell {
+  string Problem;
+  string Planner;
+  vector<double> Times;  // HUGE_VAL for a failed run
+  int Successes;
+};
+
+
+//! The comparison of one cell between the two files
+struct MSLCompareResult {
+  const MSLCompareCell *Base;
+  const MSLCompareCell *New;
+  double BaseMedian;
+  double NewMedian;
+  double Speedup;  // BaseMedian / NewMedian
+  double P;
+  string Verdict;
+};
+
+
+
+// Read a file written by msl_bench -runs into cells keyed by
+// "problem,planner"; order gets the keys in the order first seen
+static bool ReadRuns(const string &fname, map<string,MSLCompareCell> &cells,
+		     vector<string> &order) {
+  ifstream fin(fname.c_str());
+  string line,problem,planner,seed,status,time,key;
+  int version = 0;
+
+  if (!fin)
+    return false;
+
+  if (!getline(fin,line) ||
+      (sscanf(line.c_str(),"# msl_bench runs %d",&version) != 1)) {
+    cerr << "Error:   " << fname << " is not written by msl_bench -runs\n";
+    return false;
+  }
+  if (version != 1) {
+    cerr << "Error:   " << fname << " has runs format version " << version
+	 << ", not 1\n";
+    return false;
+  }
+
+  getline(fin,line);  // The header
+  while (getline(fin,line)) {
+    istringstream is(line);
+    if (!getline(is,problem,',') || !getline(is,planner,',') ||
+	!getline(is,seed,',') || !getline(is,status,',') ||
+	!getline(is,time,','))
+      continue;
+    key = problem + "," + planner;
+    if (cells.find(key) == cells.end()) {
+      cells[key].Problem = problem;
+      cells[key].Planner = planner;
+      cells[key].Successes = 0;
+      order.push_back(key);
+    }
+    MSLCompareCell &c = cells[key];
+    if (status == "success") {
+      c.Times.push_back(atof(time.c_str()));
+      c.Successes++;
+    }
+    else
+      c.Times.push_back(HUGE_VAL);
+  }
+
+  return true;
+}
+
+
+
+// The median of v, HUGE_VAL if more than half of the runs failed
+static double Median(vector<double> v) {
+  size_t n = v.size();
+
+  if (n == 0)
+    return HUGE_VAL;
+  sort(v.begin(),v.end());
+  if (n % 2 == 1)
+    return v[n/2];
+  if ((v[n/2-1] == HUGE_VAL) || (v[n/2] == HUGE_VAL))
+    return v[n/2];
+  return (v[n/2-1] + v[n/2]) / 2.0;
+}
+
+
+
+// Two-sided p-value of the Mann-Whitney U test that a and b come from
+// the same distribution.  Ties (such as failed runs) get the average of
+// their ranks, and the variance is corrected for them.
+static double MannWhitney(const vector<double> &a, const vector<double> &b) {
+  vector<pair<double,int> > all;
+  double n1 = a.size(),n2 = b.size(),n,r1 = 0.0,u,mean,var,ties = 0.0,z;
+  size_t i,j,k;
+
+  if ((a.size() == 0) || (b.size() == 0))
+    return 1.0;
+
+  for (i = 0; i < a.size(); i++)
+    all.push_back(make_pair(a[i],0));
+  for (i = 0; i < b.size(); i++)
+    all.push_back(make_pair(b[i],1));
+  sort(all.begin(),all.end());
+  n = all.size();
+
+  // Ranks start at 1; a run of t equal values shares their mean rank
+  for (i = 0; i < all.size(); i = j) {
+    for (j = i+1; (j < all.size()) && (all[j].first == all[i].first); j++);
+    for (k = i; k < j; k++)
+      if (all[k].second == 0)
+	r1 += (i + j + 1) / 2.0;
+    ties += pow((double) (j - i),3) - (j - i);
+  }
+
+  u = r1 - n1*(n1+1)/2.0;
+  mean = n1*n2/2.0;
+  var = n1*n2/12.0 * ((n+1) - ties/(n*(n-1)));
+  if (var <= 0.0)
+    return 1.0;  // Everything tied
+
+  // With continuity correction
+  z = (fabs(u - mean) - 0.5) / sqrt(var);
+  if (z < 0.0)
+    z = 0.0;
+  return erfc(z / sqrt(2.0));
+}
+
+
+
+static MSLCompareResult Compare(const MSLCompareCell &base,
+				const MSLCompareCell &now,
+				double alpha, double threshold) {
+  MSLCompareResult r;
+
+  r.Base = &base;
+  r.New = &now;
+  r.BaseMedian = Median(base.Times);
+  r.NewMedian = Median(now.Times);
+  if (r.BaseMedian == r.NewMedian)
+    r.Speedup = 1.0;
+  else if (r.NewMedian == HUGE_VAL)
+    r.Speedup = 0.0;
+  else if (r.BaseMedian == HUGE_VAL)
+    r.Speedup = HUGE_VAL;
+  else
+    r.Speedup = (r.NewMedian > 0.0) ? r.BaseMedian / r.NewMedian : 1.0;
+  r.P = MannWhitney(base.Times,now.Times);
+
+  r.Verdict = "same";
+  if (r.P < alpha) {
+    if (r.Speedup > 1.0 + threshold)
+      r.Verdict = "faster";
+    else if (r.Speedup < 1.0 / (1.0 + threshold))
+      r.Verdict = "slower";
+    else if (now.Successes != base.Successes)
+      r.Verdict = (now.Successes > base.Successes) ? "faster" : "slower";
+  }
+
+  return r;
+}
+
+
+
+// A time in seconds, or "-" for HUGE_VAL
+static string Seconds(double t) {
+  ostringstream os;
+
+  if (t == HUGE_VAL)
+    return "-";
+  os << setprecision(4) << t;
+  return os.str();
+}
+
+
+
+static void WriteTable(ostream &os, const vector<MSLCompareResult> &results) {
+  size_t i;
+
+  os << left << setw(14) << "problem" << setw(18) << "planner" << right
+     << setw(8) << "success" << setw(8) << "success" << setw(11) << "median"
+     << setw(11) << "median" << setw(9) << "speedup" << setw(9) << "p"
+     << "  result\n";
+  os << left << setw(14) << "" << setw(18) << "" << right
+     << setw(8) << "base" << setw(8) << "new" << setw(11) << "base"
+     << setw(11) << "new" << "\n";
+  for (i = 0; i < results.size(); i++) {
+    const MSLCompareResult &r = results[i];
+    ostringstream sb,sn,sp;
+    sb << r.Base->Successes << "/" << r.Base->Times.size();
+    sn << r.New->Successes << "/" << r.New->Times.size();
+    if (r.Speedup == HUGE_VAL)
+      sp << "inf";
+    else
+      sp << fixed << setprecision(2) << r.Speedup;
+    os << left << setw(14) << r.Base->Problem << setw(18)
+       << r.Base->Planner << right << setw(8) << sb.str() << setw(8)
+       << sn.str() << setw(11) << Seconds(r.BaseMedian) << setw(11)
+       << Seconds(r.NewMedian) << setw(9) << sp.str() << setw(9)
+       << setprecision(3) << r.P << "  " << r.Verdict << "\n";
+  }
+}
+
+
+
+static void WriteCSV(ostream &os, const vector<MSLCompareResult> &results) {
+  size_t i;
+
+  os << "problem,planner,base_runs,base_successes,new_runs,new_successes,"
+     << "base_median_time,new_median_time,speedup,p,result\n";
+  for (i = 0; i < results.size(); i++) {
+    const MSLCompareResult &r = results[i];
+    os << r.Base->Problem << "," << r.Base->Planner << ","
+       << r.Base->Times.size() << "," << r.Base->Successes << ","
+       << r.New->Times.size() << "," << r.New->Successes << ","
+       << Seconds(r.BaseMedian) << "," << Seconds(r.NewMedian) << ","
+       << r.Speedup << "," << r.P << "," << r.Verdict << "\n";
+  }
+}
+
+
+
+int main(int argc, char **argv) {
+  string basefile,newfile,csvfile;
+  map<string,MSLCompareCell> base,now;
+  map<string,MSLCompareCell>::iterator c;
+  vector<string> baseorder,neworder;
+  vector<MSLCompareResult> results;
+  double alpha = 0.05,threshold = 0.05;
+  int i,slower = 0,faster = 0;
+  size_t k;
+
+  for (i = 1; i < argc; i++) {
+    string a = argv[i];
+    if ((a == "-alpha") && (i+1 < argc))
+      alpha = atof(argv[++i]);
+    else if ((a == "-threshold") && (i+1 < argc))
+      threshold = atof(argv[++i]);
+    else if ((a == "-csv") && (i+1 < argc))
+      csvfile = argv[++i];
+    else if ((a[0] != '-') && (basefile == ""))
+      basefile = a;
+    else if ((a[0] != '-') && (newfile == ""))
+      newfile = a;
+    else {
+      basefile = "";
+      break;
+    }
+  }
+  if ((basefile == "") || (newfile == "")) {
+    cerr << "Usage: msl_compare [-alpha <p>] [-threshold <r>] [-csv <file>]\n"
+	 << "                   <baseline runs> <new runs>\n";
+    return 2;
+  }
+  if (!ReadRuns(basefile,base,baseorder) || !ReadRuns(newfile,now,neworder)) {
+    cerr << "Error:   Cannot read " << basefile << " and " << newfile << "\n";
+    return 2;
+  }
+
+  for (k = 0; k < baseorder.size(); k++) {
+    if ((c = now.find(baseorder[k])) == now.end()) {
+      cerr << "Only in " << basefile << ": " << baseorder[k] << "\n";
+      continue;
+    }
+    results.push_back(Compare(base[baseorder[k]],c->second,alpha,threshold));
+    if (results.back().Verdict == "slower")
+      slower++;
+    else if (results.back().Verdict == "faster")
+      faster++;
+  }
+  for (k = 0; k < neworder.size(); k++)
+    if (base.find(neworder[k]) == base.end())
+      cerr << "Only in " << newfile << ": " << neworder[k] << "\n";
+
+  WriteTable(cout,results);
+  cout << "\n" << results.size() << " cells: " << faster << " faster, "
+       << slower << " slower, " << results.size() - faster - slower
+       << " same (alpha " << alpha << ", threshold " << threshold << ")\n";
+
+  if (csvfile != "") {
+    ofstream fout(csvfile.c_str());
+    WriteCSV(fout,results);
+    if (!fout) {
+      cerr << "Error:   Cannot write " << csvfile << "\n";
+      return 2;
+    }
+  }
+
+  return (slower > 0) ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// msl_microbench: time the Model and Geom primitives used by the planners
+//
+//   msl_microbench [options]
+//
+//   -data <dir>          directory of problems (default data)
+//   -problems <a,b,...>  problems to load (default: every subdirectory)
+//   -samples <n>         random states drawn per problem (default 256)
+//   -time <seconds>      minimum timed batch per primitive (default 0.2)
+//   -seed <n>            seed for the random states (default 1)
+//   -csv <file>          write the results as CSV (default: a table on stdout)
+//
+// Each problem is loaded with SetupProblem, and every Model/Geom class
+// pair is timed once, on the first problem that uses it.  States are
+// drawn uniformly between LowerState and UpperState, and inputs from
+// the ones GetInputs offers at each state.  The time step for Integrate is
+// PlannerDeltaT, as read by the planners.  Each primitive is called in
+// batches that double in size until one batch takes at least -time
+// seconds; that batch gives ns/call and allocations/call (calls to
+// operator new, counted in this program).
+
+#include <stdlib.h>
+#include <dirent.h>
+#include <cxxabi.h>
+#include <typeinfo>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <new>
+#include <set>
+#include <vector>
+
+#include "msl/setup.h"
+#include "msl/model.h"
+#include "msl/geom.h"
+#include "msl/random.h"
+#include "msl/util.h"
+#include "msl/defs.h"
+
+
+// Every allocation made by this program goes through here
+static unsigned long MSLAllocations = 0;
+
+void* operator new(size_t n) {
+  void *p;
+
+  MSLAllocations++;
+  if ((p = malloc(n ? n : 1)) == NULL)
+    throw bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t n) {
+  return operator new(n);
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  free(p);
+}
+
+
+
+//! The cost of one primitive of one Model/Geom pair
+struct MSLMicroResult {
+  string Problem;
+  string Model;
+  string Geom;
+  string Primitive;
+  long Calls;
+  double NsPerCall;
+  double AllocsPerCall;
+};
+
+
+//! A stream buffer that drops everything
+class MSLNullBuf: public streambuf {
+ protected:
+  virtual int overflow(int c) {return c;}
+};
+
+
+//! The inputs shared by all primitives of one problem
+struct MSLMicroData {
+  Model *M;
+  Geom *G;
+  double DeltaT;
+  vector<MSLVector> States;
+  vector<MSLVector> Inputs;
+  vector<MSLVector> Configs;
+};
+
+// Results of the calls, so that they cannot be optimized away
+static volatile double MSLMicroSink;
+
+typedef void (*MSLMicroFunc)(MSLMicroData &d, size_t i);
+
+
+
+static void TimeMetric(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->Metric(d.States[i],d.States[(i+1) % d.States.size()]);
+}
+
+static void TimeIntegrate(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->Integrate(d.States[i],d.Inputs[i],d.DeltaT)[0];
+}
+
+static void TimeEuler(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->EulerIntegrate(d.States[i],d.Inputs[i],d.DeltaT)[0];
+}
+
+static void TimeRungeKutta(MSLMicroData &d, size_t i) {
+  MSLMicroSink =
+    d.M->RungeKuttaIntegrate(d.States[i],d.Inputs[i],d.DeltaT)[0];
+}
+
+static void TimeLinearInterpolate(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->LinearInterpolate(d.States[i],
+			 d.States[(i+1) % d.States.size()],0.5)[0];
+}
+
+static void TimeStateToConfiguration(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->StateToConfiguration(d.States[i])[0];
+}
+
+static void TimeSatisfied(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.M->Satisfied(d.States[i]);
+}
+
+static void TimeCollisionFree(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.G->CollisionFree(d.Configs[i]);
+}
+
+static void TimeDistanceComp(MSLMicroData &d, size_t i) {
+  MSLMicroSink = d.G->DistanceComp(d.Configs[i]);
+}
+
+
+
+static string ClassName(const type_info &t) {
+  int status;
+  char *s = abi::__cxa_demangle(t.name(),NULL,NULL,&status);
+  string name = (status == 0) ? s : t.name();
+
+  free(s);
+  return name;
+}
+
+
+
+static list<string> Split(const string &s) {
+  list<string> l;
+  string w;
+  istringstream is(s);
+
+  while (getline(is,w,','))
+    if (w != "")
+      l.push_back(w);
+
+  return l;
+}
+
+
+
+static list<string> ProblemDirectories(const string &data) {
+  list<string> names;
+  struct dirent *d;
+  DIR *dir;
+  string name;
+
+  if ((dir = opendir(data.c_str())) == NULL)
+    return names;
+  while ((d = readdir(dir)) != NULL) {
+    name = d->d_name;
+    if ((name[0] != '.') && is_directory(data + name))
+      names.push_back(name);
+  }
+  closedir(dir);
+  names.sort();
+
+  return names;
+}
+
+
+
+static MSLVector RandomVector(MSLRandomSource &R, const MSLVector &lower,
+			      const MSLVector &upper) {
+  MSLVector x(lower.dim());
+  double r;
+  int i;
+
+  for (i = 0; i < lower.dim(); i++) {
+    R >> r;
+    x[i] = lower[i] + r * (upper[i] - lower[i]);
+  }
+
+  return x;
+}
+
+
+
+// One of the inputs that the Model offers at x, or a zero input if
+// there are none
+static MSLVector RandomInput(MSLRandomSource &R, Model *m,
+			     const MSLVector &x) {
+  list<MSLVector> inputs = m->GetInputs(x);
+  list<MSLVector>::iterator u = inputs.begin();
+  int k;
+
+  if (inputs.empty())
+    return MSLVector(m->InputDim);
+  for (k = R(0,inputs.size()-1); k > 0; k--)
+    u++;
+
+  return *u;
+}
+
+
+
+// Call f in doubling batches until one takes at least mintime seconds
+static void Time(MSLMicroData &d, MSLMicroFunc f, double mintime,
+		 MSLMicroResult &r) {
+  long n,k;
+  double start,elapsed;
+  unsigned long allocs;
+  size_t i;
+
+  for (n = 1; ; n *= 2) {
+    allocs = MSLAllocations;
+    start = wall_time();
+    for (k = 0, i = 0; k < n; k++) {
+      f(d,i);
+      if (++i == d.States.size())
+	i = 0;
+    }
+    elapsed = wall_time() - start;
+    allocs = MSLAllocations - allocs;
+    if ((elapsed >= mintime) || (n >= (1L << 40)))
+      break;
+  }
+
+  r.Calls = n;
+  r.NsPerCall = elapsed * 1e9 / n;
+  r.AllocsPerCall = (double) allocs / n;
+}
+
+
+
+int main(int argc, char **argv) {
+  string data = "data/",csvfile,FilePath;
+  list<string> problems;
+  list<string>::iterator pr;
+  set<string> seen;
+  vector<MSLMicroResult> results;
+  int samples = 256,seed = 1,i,j;
+  double mintime = 0.2;
+  streambuf *coutbuf = cout.rdbuf();
+  MSLNullBuf discard;
+  MSLRandomSource R;
+  MSLMicroData d;
+  MSLMicroResult r;
+  double PlannerDeltaT;
+
+  static const struct {const char *Name; MSLMicroFunc F;} primitives[] = {
+    {"Metric",TimeMetric},
+    {"Integrate",TimeIntegrate},
+    {"EulerIntegrate",TimeEuler},
+    {"RungeKuttaIntegrate",TimeRungeKutta},
+    {"LinearInterpolate",TimeLinearInterpolate},
+    {"StateToConfiguration",TimeStateToConfiguration},
+    {"Satisfied",TimeSatisfied},
+    {"CollisionFree",TimeCollisionFree},
+    {"DistanceComp",TimeDistanceComp}
+  };
+
+  for (i = 1; i < argc; i++) {
+    string a = argv[i];
+    if ((a == "-data") && (i+1 < argc))
+      data = argv[++i];
+    else if ((a == "-problems") && (i+1 < argc))
+      problems = Split(argv[++i]);
+    else if ((a == "-samples") && (i+1 < argc))
+      samples = atoi(argv[++i]);
+    else if ((a == "-time") && (i+1 < argc))
+      mintime = atof(argv[++i]);
+    else if ((a == "-seed") && (i+1 < argc))
+      seed = atoi(argv[++i]);
+    else if ((a == "-csv") && (i+1 < argc))
+      csvfile = argv[++i];
+    else {
+      cerr << "Usage: msl_microbench [-data <dir>] [-problems <a,b,...>]\n"
+	   << "                      [-samples <n>] [-time <seconds>]\n"
+	   << "                      [-seed <n>] [-csv <file>]\n";
+      return 2;
+    }
+  }
+  if (data[data.length()-1] != '/')
+    data += "/";
+  if (problems.empty())
+    problems = ProblemDirectories(data);
+  if (samples < 1)
+    samples = 1;
+  R.set_seed(seed);
+
+  forall(pr,problems) {
+    FilePath = data + *pr + "/";
+    if (!is_directory(FilePath)) {
+      cerr << "Skipping " << *pr << ": not a directory\n";
+      continue;
+    }
+
+    cout.rdbuf(&discard);
+    SetupProblem(d.M,d.G,FilePath);
+    cout.rdbuf(coutbuf);
+    r.Problem = *pr;
+    r.Model = ClassName(typeid(*d.M));
+    r.Geom = ClassName(typeid(*d.G));
+    if (!seen.insert(r.Model + "," + r.Geom).second) {
+      delete d.G;
+      delete d.M;
+      continue;
+    }
+
+    // Some problems name a Model that SetupProblem does not know, and
+    // the default planar Model it makes instead does not fit their Geom
+    if (!is_file(FilePath + r.Model) && (d.G->GeomDim != 2)) {
+      cerr << "Skipping " << *pr << ": no Model that SetupProblem knows\n";
+      seen.erase(r.Model + "," + r.Geom);
+      delete d.G;
+      delete d.M;
+      continue;
+    }
+
+    READ_PARAMETER_OR_DEFAULT(PlannerDeltaT,1.0);
+    d.DeltaT = PlannerDeltaT;
+    d.States.clear();
+    d.Inputs.clear();
+    d.Configs.clear();
+    for (j = 0; j < samples; j++) {
+      d.States.push_back(RandomVector(R,d.M->LowerState,d.M->UpperState));
+      d.Inputs.push_back(RandomInput(R,d.M,d.States.back()));
+      d.Configs.push_back(d.M->StateToConfiguration(d.States.back()));
+    }
+
+    cerr << *pr << ": " << r.Model << ", " << r.Geom << "\n";
+    for (j = 0; j < (int) (sizeof(primitives)/sizeof(primitives[0])); j++) {
+      r.Primitive = primitives[j].Name;
+      Time(d,primitives[j].F,mintime,r);
+      results.push_back(r);
+    }
+
+    delete d.G;
+    delete d.M;
+  }
+
+  if (csvfile != "") {
+    ofstream fout(csvfile.c_str());
+    fout << "problem,model,geom,primitive,calls,ns_per_call,allocs_per_call\n";
+    for (i = 0; i < (int) results.size(); i++)
+      fout << results[i].Problem << "," << results[i].Model << ","
+	   << results[i].Geom << "," << results[i].Primitive << ","
+	   << results[i].Calls << "," << results[i].NsPerCall << ","
+	   << results[i].AllocsPerCall << "\n";
+  }
+  else {
+    for (i = 0; i < (int) results.size(); i++) {
+      if ((i == 0) || (results[i].Problem != results[i-1].Problem))
+	cout << "\n" << results[i].Model << " / " << results[i].Geom
+	     << " (" << results[i].Problem << ")\n";
+      cout << "  " << setw(22) << left << results[i].Primitive << right
+	   << setw(14) << fixed << setprecision(1) << results[i].NsPerCall
+	   << " ns/call" << setw(10) << setprecision(2)
+	   << results[i].AllocsPerCall << " allocs/call\n";
+    }
+  }
+
+  return 0;
+}
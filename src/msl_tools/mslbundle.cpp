@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// mslbundle: pack a problem directory into a single Bundle file
+//
+//   mslbundle <problem directory>       write <directory>/Bundle
+//   mslbundle -l <problem directory>    list the entries of a Bundle
+//
+// Every regular file of the directory becomes an entry.  For the 2D
+// PQP geometries the triangulations of Obst and the robot polygons are
+// stored too (as ObstTriangles, RobotTriangles, Robot0Triangles, ...),
+// so loading the bundle skips PolygonsToTriangles.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sstream>
+#include <algorithm>
+
+#include "msl/bundle.h"
+#include "msl/polygon.h"
+#include "msl/triangle.h"
+#include "msl/mslio.h"
+#include "msl/util.h"
+#include "msl/defs.h"
+
+
+// Read a file directly, without consulting any bundle
+static bool ReadWhole(const string &fname, string &contents) {
+  ifstream fin(fname.c_str(),ios::in|ios::binary);
+  ostringstream os;
+
+  if (!fin)
+    return false;
+  os << fin.rdbuf();
+  contents = os.str();
+  return true;
+}
+
+
+// Add name+"Triangles", triangulating the polygons stored under name
+static void AddTriangles(vector<pair<string,string> > &entries,
+			 const string &name, double tolerance) {
+  vector<pair<string,string> >::iterator e;
+  list<MSLPolygon> pl;
+  list<MSLTriangle> tl;
+  ostringstream os;
+
+  for (e = entries.begin(); e != entries.end(); e++)
+    if (e->first == name)
+      break;
+  if (e == entries.end())
+    return;
+
+  istringstream is(e->second);
+  is >> pl;
+  tl = PolygonsToTriangles(pl,tolerance);
+  os.precision(17);
+  os << tl;
+  entries.push_back(make_pair(name + "Triangles",os.str()));
+}
+
+
+static int List(const string &path) {
+  MSLBundle b;
+  list<string> names;
+  list<string>::iterator n;
+  const char *data;
+  size_t size;
+
+  if (!b.Read(path + MSL_BUNDLE_FILE)) {
+    cerr << "No valid bundle in " << path << "\n";
+    return 1;
+  }
+
+  names = b.Names();
+  forall(n,names) {
+    b.Find(*n,data,size);
+    cout << size << "\t" << *n << "\n";
+  }
+
+  return 0;
+}
+
+
+static int Pack(const string &path) {
+  vector<pair<string,string> > entries;
+  struct dirent *d;
+  string name,contents;
+  char s[50];
+  int i;
+  DIR *dir;
+
+  dir = opendir(path.c_str());
+  if (!dir) {
+    cerr << "Cannot open the directory " << path << "\n";
+    return 1;
+  }
+  while ((d = readdir(dir)) != NULL) {
+    name = d->d_name;
+    if ((name[0] == '.') || (name == MSL_BUNDLE_FILE) ||
+	(name[name.length()-1] == '~'))
+      continue;
+    // Skip collision model caches (see geom_pqp.h)
+    if ((name.length() > 4) && (name.substr(name.length()-4) == ".pqp"))
+      continue;
+    struct stat st;
+    if ((stat((path + name).c_str(),&st) != 0) || !S_ISREG(st.st_mode))
+      continue;
+    if (!ReadWhole(path + name,contents)) {
+      cerr << "Cannot read " << path + name << "\n";
+      closedir(dir);
+      return 1;
+    }
+    entries.push_back(make_pair(name,contents));
+  }
+  closedir(dir);
+  sort(entries.begin(),entries.end());
+
+  // Same tolerances as GeomPQP2D and GeomPQP2DRigidMulti use
+  if (ReadWhole(path + "GeomPQP2D",contents) ||
+      ReadWhole(path + "GeomPQP2DRigid",contents) ||
+      ReadWhole(path + "GeomPQP2DRigidMulti",contents)) {
+    AddTriangles(entries,"Obst",3.0);
+    AddTriangles(entries,"Robot",3.0);
+    for (i = 0; ; i++) {
+      sprintf(s,"Robot%d",i);
+      if (!ReadWhole(path + s,contents))
+	break;
+      AddTriangles(entries,s,5.0);
+    }
+  }
+
+  ofstream fout((path + MSL_BUNDLE_FILE).c_str(),ios::out|ios::binary);
+  MSLBundle::Write(fout,entries);
+  if (!fout) {
+    cerr << "Cannot write " << path + MSL_BUNDLE_FILE << "\n";
+    return 1;
+  }
+
+  cout << "Wrote " << entries.size() << " entries to "
+       << path + MSL_BUNDLE_FILE << "\n";
+  return 0;
+}
+
+
+int main(int argc, char **argv) {
+  string path;
+  bool listing = false;
+
+  if ((argc > 2) && (string(argv[1]) == "-l")) {
+    listing = true;
+    argv++;
+    argc--;
+  }
+  if (argc != 2) {
+    cerr << "Usage: mslbundle [-l] <problem directory>\n";
+    return 1;
+  }
+
+  path = argv[1];
+  if (path[path.length()-1] != '/')
+    path += "/";
+
+  return listing ? List(path) : Pack(path);
+}
@@ -0,0 +1,315 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// mslplan: solve a problem without a display
+//
+//   mslplan [options] <problem directory>
+//
+//   -planner <name>    planner class (default RRTConCon; -list shows all)
+//   -seed <n>          seed for the planner's random source (default: the
+//                      file Seed, or the clock; the seed used is reported)
+//   -nodes <n>         node budget (NumNodes)
+//   -time <seconds>    wall-clock limit for Construct and Plan together
+//   -memory <MB>       soft cap on the planner's memory (MemoryLimit)
+//   -path <file>       write the solution path (text, as GuiPlanner does)
+//   -binary            write the path as an MSLVectorFile instead, and
+//                      the trace in the binary MSLTrace format
+//   -trace <file>      record Extend, Connect and the other traced planner
+//                      steps, and write them as Chrome trace JSON
+//   -stats <file>      write the statistics there instead of to stdout
+//   -phase-times       time each planner phase as well as counting its
+//                      calls (two clock reads per call, so this slows
+//                      planning a little)
+//   -profile <file>    sample the profiler markers (MSLProfiler) while
+//                      planning and write them as folded stacks; only
+//                      "(none)" is seen unless built with MSL_PROFILING
+//   -metrics <target>  keep live metrics (MSLMetrics) in Prometheus text
+//                      format in the file <target>, or serve them on a
+//                      Unix socket if <target> is unix:<path>
+//   -metrics-period <seconds>  time between metrics snapshots (default 1)
+//   -quiet             discard what the planner prints
+//
+// Roadmap planners run Construct before Plan.  The statistics are a
+// single JSON object; "plan_time" and "construct_time" are processor
+// time (of all threads), "plan_wall_time" and "construct_wall_time"
+// wall-clock time, "phases" (and "construct_phases") hold the
+// planner's MSLPlannerStats, and "memory" the bytes held by its trees,
+// roadmap, grid and collision models when it stopped.  The exit status
+// is 0 if a solution was found, 1 if not, and 2 on a usage or setup
+// error.
+
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+#include "msl/setup.h"
+#include "msl/planner.h"
+#include "msl/profile.h"
+#include "msl/metrics.h"
+#include "msl/vectorfile.h"
+#include "msl/mslio.h"
+#include "msl/util.h"
+#include "msl/defs.h"
+
+
+static void Usage() {
+  cerr << "Usage: mslplan [-planner <name>] [-seed <n>] [-nodes <n>]\n"
+       << "               [-time <seconds>] [-memory <MB>] [-path <file>]\n"
+       << "               [-binary] [-trace <file>] [-stats <file>]\n"
+       << "               [-phase-times] [-profile <file>]\n"
+       << "               [-metrics <target>] [-metrics-period <seconds>]\n"
+       << "               [-quiet]\n"
+       << "               <problem directory>\n"
+       << "       mslplan -list\n";
+}
+
+
+// Quote s as a JSON string
+static string Quote(const string &s) {
+  string q = "\"";
+  size_t i;
+
+  for (i = 0; i < s.length(); i++) {
+    if ((s[i] == '"') || (s[i] == '\\'))
+      q += '\\';
+    q += s[i];
+  }
+
+  return q + "\"";
+}
+
+
+static bool WritePath(const string &fname, const list<MSLVector> &path,
+		      bool binary) {
+  ofstream fout(fname.c_str(),ios::out|ios::binary);
+
+  if (!fout)
+    return false;
+  if (binary)
+    MSLVectorFile::Write(fout,path);
+  else
+    fout << path;
+  fout.close();
+
+  return !fout.fail();
+}
+
+
+int main(int argc, char **argv) {
+  string path,plannername = "RRTConCon",pathfile,statsfile,tracefile,
+    profilefile,metricstarget;
+  bool binary = false,quiet = false,roadmap,seeded = false,
+    phasetimes = false;
+  double timelimit = 0.0,memorylimit = -1.0,metricsperiod = 1.0,remaining,
+    start;
+  int seed = 0,nodes = -1,i;
+  MSLPlanStatus cstatus = MSL_PLAN_NONE,status;
+  list<string> names;
+  list<string>::iterator n;
+  streambuf *coutbuf = cout.rdbuf();
+  ostringstream discard,cphases;
+  MSLTrace trace;
+  Model *m;
+  Geom *g;
+  Problem *prob;
+  Planner *pl;
+
+  for (i = 1; i < argc; i++) {
+    string a = argv[i];
+    if ((a == "-list") && (argc == 2)) {
+      names = PlannerNames();
+      forall(n,names)
+	cout << *n << "\n";
+      return 0;
+    }
+    else if ((a == "-planner") && (i+1 < argc))
+      plannername = argv[++i];
+    else if ((a == "-seed") && (i+1 < argc)) {
+      seed = atoi(argv[++i]);
+      seeded = true;
+    }
+    else if ((a == "-nodes") && (i+1 < argc))
+      nodes = atoi(argv[++i]);
+    else if ((a == "-time") && (i+1 < argc))
+      timelimit = atof(argv[++i]);
+    else if ((a == "-memory") && (i+1 < argc))
+      memorylimit = atof(argv[++i]);
+    else if ((a == "-path") && (i+1 < argc))
+      pathfile = argv[++i];
+    else if ((a == "-stats") && (i+1 < argc))
+      statsfile = argv[++i];
+    else if ((a == "-trace") && (i+1 < argc))
+      tracefile = argv[++i];
+    else if ((a == "-profile") && (i+1 < argc))
+      profilefile = argv[++i];
+    else if ((a == "-metrics") && (i+1 < argc))
+      metricstarget = argv[++i];
+    else if ((a == "-metrics-period") && (i+1 < argc))
+      metricsperiod = atof(argv[++i]);
+    else if (a == "-phase-times")
+      phasetimes = true;
+    else if (a == "-binary")
+      binary = true;
+    else if (a == "-quiet")
+      quiet = true;
+    else if ((a[0] != '-') && (path == ""))
+      path = a;
+    else {
+      Usage();
+      return 2;
+    }
+  }
+  if (path == "") {
+    Usage();
+    return 2;
+  }
+  if (path[path.length()-1] != '/')
+    path += "/";
+  if (!is_directory(path)) {
+    cerr << "Error:   Directory " << path << " does not exist\n";
+    return 2;
+  }
+
+  if (quiet)
+    cout.rdbuf(discard.rdbuf());
+
+  start = wall_time();
+  SetupProblem(m,g,path);
+  prob = new Problem(g,m,path);
+  pl = MakePlanner(plannername,prob);
+  if (!pl) {
+    cout.rdbuf(coutbuf);
+    cerr << "Error:   Unknown planner " << plannername
+	 << " (mslplan -list shows the planners)\n";
+    return 2;
+  }
+  if (seeded)
+    pl->SetSeed(seed);
+  if (nodes > 0)
+    pl->NumNodes = nodes;
+  if (memorylimit >= 0.0)
+    pl->MemoryLimit = memorylimit;
+  if (tracefile != "")
+    pl->Trace = &trace;
+  if (phasetimes)
+    pl->Stats.Timing = true;
+
+  if ((profilefile != "") && !MSLProfiler::Start()) {
+    cout.rdbuf(coutbuf);
+    cerr << "Error:   Cannot start the profiler\n";
+    return 2;
+  }
+  MSLMetrics metrics(pl);
+  if ((metricstarget != "") && !metrics.Start(metricstarget,metricsperiod)) {
+    cout.rdbuf(coutbuf);
+    return 2;
+  }
+
+  // Roadmap planners need their roadmap before a query
+  roadmap = (dynamic_cast<RoadmapPlanner*>(pl) != NULL);
+  status = MSL_PLAN_NONE;
+  if (roadmap) {
+    cstatus = pl->ConstructWithin(timelimit);
+    pl->Stats.WriteJSON(cphases);
+  }
+  if (!roadmap || (cstatus == MSL_PLAN_SUCCESS)) {
+    remaining = 0.0;
+    if (timelimit > 0.0) {
+      remaining = timelimit - (wall_time() - start);
+      if (remaining <= 0.0)
+	remaining = 1e-9;
+    }
+    status = pl->PlanWithin(remaining);
+  }
+  else
+    status = cstatus;
+
+  cout.rdbuf(coutbuf);
+  MSLProfiler::Stop();
+  metrics.Stop();
+
+  if ((pathfile != "") && (status == MSL_PLAN_SUCCESS) &&
+      !WritePath(pathfile,pl->Path,binary)) {
+    cerr << "Error:   Cannot write " << pathfile << "\n";
+    return 2;
+  }
+  if ((tracefile != "") && !trace.Write(tracefile,binary)) {
+    cerr << "Error:   Cannot write " << tracefile << "\n";
+    return 2;
+  }
+  if (profilefile != "") {
+    ofstream fout(profilefile.c_str());
+    MSLProfiler::WriteFolded(fout);
+    if (!fout) {
+      cerr << "Error:   Cannot write " << profilefile << "\n";
+      return 2;
+    }
+    if (!MSLProfiler::MarkersEnabled())
+      cerr << "Warning: built without MSL_PROFILING, so the profile has "
+	   << "no markers\n";
+  }
+
+  ostringstream stats;
+  stats << "{\"problem\": " << Quote(path)
+	<< ", \"planner\": " << Quote(plannername);
+  stats << ", \"seed\": " << pl->Seed;
+  stats << ", \"num_nodes\": " << pl->NumNodes
+	<< ", \"time_limit\": " << timelimit;
+  if (roadmap) {
+    ostringstream cs;
+    cs << cstatus;
+    stats << ", \"construct_status\": " << Quote(cs.str())
+	  << ", \"construct_time\": " << pl->CumulativeConstructTime
+	  << ", \"construct_wall_time\": " << pl->CumulativeConstructWallTime
+	  << ", \"construct_phases\": " << cphases.str();
+  }
+  ostringstream ps;
+  ps << status;
+  stats << ", \"status\": " << Quote(ps.str())
+	<< ", \"plan_time\": " << pl->CumulativePlanningTime
+	<< ", \"plan_wall_time\": " << pl->CumulativePlanningWallTime
+	<< ", \"wall_time\": " << wall_time() - start
+	<< ", \"path_states\": " << pl->Path.size()
+	<< ", \"tree_nodes\": " << (pl->T ? pl->T->Size() : 0)
+	<< ", \"tree2_nodes\": " << (pl->T2 ? pl->T2->Size() : 0)
+	<< ", \"roadmap_vertices\": "
+	<< (pl->Roadmap ? pl->Roadmap->NumVertices() : 0)
+	<< ", \"roadmap_edges\": "
+	<< (pl->Roadmap ? pl->Roadmap->NumEdges() : 0)
+	<< ", \"phases\": ";
+  if (!roadmap || (cstatus == MSL_PLAN_SUCCESS))
+    pl->Stats.WriteJSON(stats);
+  else
+    stats << "{}";
+  stats << ", \"memory\": ";
+  pl->WriteMemoryJSON(stats);
+  stats << "}\n";
+
+  if (statsfile != "") {
+    ofstream fout(statsfile.c_str());
+    fout << stats.str();
+    if (!fout) {
+      cerr << "Error:   Cannot write " << statsfile << "\n";
+      return 2;
+    }
+  }
+  else
+    cout << stats.str();
+
+  return (status == MSL_PLAN_SUCCESS) ? 0 : 1;
+}
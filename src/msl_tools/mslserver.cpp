@@ -0,0 +1,470 @@
+//----------------------------------------------------------------------
+//               The Motion Strategy Library (MSL)
+//----------------------------------------------------------------------
+//
+// Copyright (c) University of Illinois and Steven M. LaValle.     
+// All Rights Reserved.
+//
+// Permission to use, copy, and distribute this software and its
+// documentation is hereby granted free of charge, provided that
+// (1) it is not a component of a commercial product, and
+// (2) this notice appears in all copies of the software and
+//     related documentation.
+//
+// The University of Illinois and the author make no representations
+// about the suitability or fitness of this software for any purpose.
+// It is provided "as is" without express or implied warranty.
+//----------------------------------------------------------------------
+
+// mslserver: answer planning queries against resident problems
+//
+//   mslserver [-threads <n>] [-socket <path>] [-quiet]
+//
+// Requests are read one per line, from stdin or from each connection
+// to the Unix domain socket <path>.  A request is a list of key=value
+// words:
+//
+//   id=<any>            echoed in the reply
+//   problem=<dir>       problem directory (required)
+//   planner=<name>      planner class (default RRTConCon)
+//   nodes=<n>           node budget (default: the planner's)
+//   time=<seconds>      wall-clock limit (default: none)
+//   seed=<n>            seed for the planner's random source
+//   init=<x1,x2,...>    initial state (default: the problem's)
+//   goal=<x1,x2,...>    goal state (default: the problem's)
+//   roadmap=<file>      for PRM, a roadmap written with BinaryGraphs
+//
+// Each reply is one line holding a JSON object with the id, status,
+// wall time, sizes and the path.  Replies come back in the order the
+// queries finish, not the order they arrived.
+//
+// The Model, Geom (with its collision models) and Problem of each
+// directory are made once, on the first query that names it, and
+// shared by every later query; each query gets its own copy of the
+// Problem, so only its initial and goal states differ.  PRM queries
+// search a roadmap that is also kept per problem: the file given by
+// roadmap=, mapped once, or else one built by Construct on the first
+// PRM query (that query's time limit does not cover the build).
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "msl/setup.h"
+#include "msl/planner.h"
+#include "msl/prm.h"
+#include "msl/roadmapfile.h"
+#include "msl/util.h"
+#include "msl/defs.h"
+
+
+//! A problem directory kept loaded between queries
+struct MSLServerProblem {
+  std::mutex Lock;   // Guards loading
+  std::mutex RoadmapLock;   // Guards Roadmap, and is held while it is made
+  bool Loaded;
+  Model *M;
+  Geom *G;
+  Problem *P;
+  MSLRoadmapFile *Roadmap;
+
+  MSLServerProblem() {Loaded = false; M = NULL; G = NULL; P = NULL;
+                      Roadmap = NULL;}
+};
+
+
+//! Where replies to a client go; shared by its pending queries
+struct MSLServerClient {
+  int Fd;
+  bool Owned;        // Close Fd when the last query is done
+  std::mutex Lock;   // One reply at a time
+
+  MSLServerClient(int fd, bool owned) {Fd = fd; Owned = owned;}
+  ~MSLServerClient() {if (Owned) close(Fd);}
+
+  void Reply(const string &s);
+};
+
+
+//! A stream buffer that drops everything; unlike a string stream, any
+//! number of threads can write to it at once
+class MSLNullBuf: public streambuf {
+ protected:
+  virtual int overflow(int c) {return c;}
+};
+
+
+struct MSLServerJob {
+  std::shared_ptr<MSLServerClient> Client;
+  string Request;
+};
+
+
+static map<string,MSLServerProblem*> Problems;
+static std::mutex ProblemsLock;
+
+static deque<MSLServerJob> Jobs;
+static std::mutex JobsLock;
+static std::condition_variable JobsReady;
+static bool Done = false;
+
+
+
+void MSLServerClient::Reply(const string &s) {
+  std::lock_guard<std::mutex> guard(Lock);
+  size_t n = 0;
+  ssize_t w;
+
+  while (n < s.length()) {
+    w = write(Fd,s.data() + n,s.length() - n);
+    if (w <= 0)
+      return;   // The client went away
+    n += w;
+  }
+}
+
+
+
+// Quote s as a JSON string
+static string Quote(const string &s) {
+  string q = "\"";
+  size_t i;
+
+  for (i = 0; i < s.length(); i++) {
+    if ((s[i] == '"') || (s[i] == '\\'))
+      q += '\\';
+    q += s[i];
+  }
+
+  return q + "\"";
+}
+
+
+
+// Parse "x1,x2,..." into a vector of dimension dim
+static bool ParseState(const string &s, int dim, MSLVector &x) {
+  const char *p = s.c_str();
+  char *end;
+  int i;
+
+  x = MSLVector(dim);
+  for (i = 0; i < dim; i++) {
+    x[i] = strtod(p,&end);
+    if (end == p)
+      return false;
+    p = end;
+    if (*p == ',')
+      p++;
+  }
+
+  return (*p == '\0');
+}
+
+
+
+// The loaded problem for directory path, or NULL
+static MSLServerProblem* GetProblem(string path) {
+  MSLServerProblem *e;
+
+  if (path == "")
+    return NULL;
+  if (path[path.length()-1] != '/')
+    path += "/";
+
+  {
+    std::lock_guard<std::mutex> guard(ProblemsLock);
+    if (Problems.find(path) == Problems.end())
+      Problems[path] = new MSLServerProblem();
+    e = Problems[path];
+  }
+
+  // Queries for a problem that is being loaded wait here
+  std::lock_guard<std::mutex> guard(e->Lock);
+  if (!e->Loaded) {
+    if (!is_directory(path))
+      return NULL;
+    SetupProblem(e->M,e->G,path);
+    e->P = new Problem(e->G,e->M,path);
+    e->Loaded = true;
+  }
+
+  return e;
+}
+
+
+
+// The roadmap shared by the PRM queries of e, made on first use
+static MSLRoadmapFile* GetRoadmap(MSLServerProblem *e, const string &fname) {
+  // Only the PRM queries of e wait while the roadmap is made; the
+  // others take e->Lock alone
+  std::lock_guard<std::mutex> guard(e->RoadmapLock);
+  MSLRoadmapFile *rm;
+
+  if (e->Roadmap)
+    return e->Roadmap;
+
+  rm = new MSLRoadmapFile();
+  if (fname != "") {
+    if (!rm->Open(fname) || (rm->StateDim() != e->P->StateDim)) {
+      delete rm;
+      return NULL;
+    }
+  }
+  else {
+    // Build one with the problem's own parameters, and keep it in the
+    // read-only form that any number of queries can search at once.
+    // The builder gets its own copy of the problem, like a query.
+    Problem prob(*e->P);
+    PRM builder(&prob);
+    builder.Construct();
+    ostringstream os;
+    MSLRoadmapFile::Write(os,*builder.Roadmap);
+    istringstream is(os.str());
+    if (!rm->Read(is)) {
+      delete rm;
+      return NULL;
+    }
+  }
+
+  e->Roadmap = rm;
+  return rm;
+}
+
+
+
+static string Answer(const string &request) {
+  map<string,string> args;
+  string word,id,plannername = "RRTConCon";
+  MSLServerProblem *e;
+  MSLRoadmapFile *rm = NULL;
+  MSLPlanStatus status;
+  Planner *pl;
+  PRM *prm;
+  double timelimit = 0.0,start;
+  size_t eq;
+  ostringstream os;
+  list<MSLVector>::iterator x;
+  int i;
+
+  start = wall_time();
+
+  istringstream is(request);
+  while (is >> word) {
+    eq = word.find('=');
+    if (eq == string::npos)
+      return "{\"status\": \"error\", \"error\": "
+	+ Quote("Expected key=value, not " + word) + "}\n";
+    args[word.substr(0,eq)] = word.substr(eq+1);
+  }
+  id = Quote(args["id"]);
+
+  if ((e = GetProblem(args["problem"])) == NULL)
+    return "{\"id\": " + id + ", \"status\": \"error\", \"error\": "
+      + Quote("No problem directory " + args["problem"]) + "}\n";
+
+  // A copy shares the Model and Geom but has its own query
+  Problem prob(*e->P);
+  if ((args["init"] != "") &&
+      !ParseState(args["init"],prob.StateDim,prob.InitialState))
+    return "{\"id\": " + id + ", \"status\": \"error\", \"error\": "
+      + Quote("Bad initial state " + args["init"]) + "}\n";
+  if ((args["goal"] != "") &&
+      !ParseState(args["goal"],prob.StateDim,prob.GoalState))
+    return "{\"id\": " + id + ", \"status\": \"error\", \"error\": "
+      + Quote("Bad goal state " + args["goal"]) + "}\n";
+
+  if (args["planner"] != "")
+    plannername = args["planner"];
+  if ((pl = MakePlanner(plannername,&prob)) == NULL)
+    return "{\"id\": " + id + ", \"status\": \"error\", \"error\": "
+      + Quote("Unknown planner " + plannername) + "}\n";
+  if (args["seed"] != "")
+    pl->SetSeed(atoi(args["seed"].c_str()));
+  if (atoi(args["nodes"].c_str()) > 0)
+    pl->NumNodes = atoi(args["nodes"].c_str());
+  if (args["time"] != "")
+    timelimit = atof(args["time"].c_str());
+
+  prm = dynamic_cast<PRM*>(pl);
+  if (prm && ((rm = GetRoadmap(e,args["roadmap"])) == NULL)) {
+    delete pl;
+    return "{\"id\": " + id + ", \"status\": \"error\", \"error\": "
+      + Quote("No roadmap for " + args["problem"]) + "}\n";
+  }
+
+  // The shared roadmap is lent to the planner, which must not free it
+  if (prm)
+    prm->MappedRoadmap = rm;
+  status = pl->PlanWithin(timelimit);
+  if (prm)
+    prm->MappedRoadmap = NULL;
+
+  os.precision(10);
+  os << "{\"id\": " << id << ", \"status\": \"" << status << "\""
+     << ", \"planner\": " << Quote(plannername)
+     << ", \"wall_time\": " << wall_time() - start
+     << ", \"tree_nodes\": " << (pl->T ? pl->T->Size() : 0)
+     << ", \"tree2_nodes\": " << (pl->T2 ? pl->T2->Size() : 0)
+     << ", \"path\": [";
+  forall(x,pl->Path) {
+    os << ((x == pl->Path.begin()) ? "[" : ", [");
+    for (i = 0; i < x->dim(); i++)
+      os << ((i == 0) ? "" : ", ") << (*x)[i];
+    os << "]";
+  }
+  os << "]}\n";
+
+  delete pl;
+  return os.str();
+}
+
+
+
+static void Worker() {
+  MSLServerJob job;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(JobsLock);
+      JobsReady.wait(lock,[]{return Done || !Jobs.empty();});
+      if (Jobs.empty())
+	return;   // Done, and nothing is left
+      job = Jobs.front();
+      Jobs.pop_front();
+    }
+    job.Client->Reply(Answer(job.Request));
+    job.Client.reset();
+  }
+}
+
+
+
+static void Submit(const std::shared_ptr<MSLServerClient> &client,
+		   const string &line) {
+  MSLServerJob job;
+
+  if (line.find_first_not_of(" \t\r") == string::npos)
+    return;
+  job.Client = client;
+  job.Request = line;
+  {
+    std::lock_guard<std::mutex> guard(JobsLock);
+    Jobs.push_back(job);
+  }
+  JobsReady.notify_one();
+}
+
+
+
+// Read the requests of one socket connection
+static void Serve(int fd) {
+  std::shared_ptr<MSLServerClient> client(new MSLServerClient(fd,true));
+  string pending;
+  char buf[4096];
+  ssize_t n;
+  size_t eol;
+
+  while ((n = read(fd,buf,sizeof(buf))) > 0) {
+    pending.append(buf,n);
+    while ((eol = pending.find('\n')) != string::npos) {
+      Submit(client,pending.substr(0,eol));
+      pending.erase(0,eol+1);
+    }
+  }
+  Submit(client,pending);
+  // The connection closes once its last reply is sent
+}
+
+
+
+static int Listen(const string &sockpath) {
+  struct sockaddr_un addr;
+  int s,fd;
+
+  if (sockpath.length() >= sizeof(addr.sun_path)) {
+    cerr << "Error:   Socket path too long\n";
+    return 1;
+  }
+
+  s = socket(AF_UNIX,SOCK_STREAM,0);
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,sockpath.c_str());
+  unlink(sockpath.c_str());
+  if ((s < 0) || (bind(s,(struct sockaddr*) &addr,sizeof(addr)) != 0) ||
+      (listen(s,16) != 0)) {
+    cerr << "Error:   Cannot listen on " << sockpath << "\n";
+    return 1;
+  }
+
+  while ((fd = accept(s,NULL,NULL)) >= 0)
+    std::thread(Serve,fd).detach();
+
+  return 0;
+}
+
+
+
+int main(int argc, char **argv) {
+  string sockpath,line;
+  int numthreads,i,result = 0;
+  MSLNullBuf discard;
+  vector<std::thread> workers;
+
+  numthreads = std::thread::hardware_concurrency();
+  if (numthreads < 1)
+    numthreads = 1;
+
+  // Replies go to stdout; whatever the planners print goes to stderr
+  cout.rdbuf(cerr.rdbuf());
+
+  for (i = 1; i < argc; i++) {
+    string a = argv[i];
+    if ((a == "-threads") && (i+1 < argc))
+      numthreads = atoi(argv[++i]);
+    else if ((a == "-socket") && (i+1 < argc))
+      sockpath = argv[++i];
+    else if (a == "-quiet")
+      cout.rdbuf(&discard);
+    else {
+      cerr << "Usage: mslserver [-threads <n>] [-socket <path>] [-quiet]\n";
+      return 1;
+    }
+  }
+  if (numthreads < 1)
+    numthreads = 1;
+
+  signal(SIGPIPE,SIG_IGN);
+
+  for (i = 0; i < numthreads; i++)
+    workers.push_back(std::thread(Worker));
+
+  if (sockpath != "")
+    result = Listen(sockpath);
+  else {
+    std::shared_ptr<MSLServerClient> client(
+      new MSLServerClient(STDOUT_FILENO,false));
+    while (getline(cin,line))
+      Submit(client,line);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(JobsLock);
+    Done = true;
+  }
+  JobsReady.notify_all();
+  for (i = 0; i < numthreads; i++)
+    workers[i].join();
+
+  return result;
+}